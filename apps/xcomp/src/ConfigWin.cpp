@@ -197,6 +197,28 @@ void ConfigWin::drawGeneral()
 #endif
     ImGui::InputText( "Save Folder", &mLocalVars.cfg_saveDir );
 
+    IMUI_DrawHeader( "Saving" );
+
+    ImGui::SliderInt( "PNG Compression", &mLocalVars.cfg_savePNGLevel, 0, 9 );
+
+    IMUI_ComboText( "PNG Filter", mLocalVars.cfg_savePNGFilter,
+                    {"adaptive", "none", "sub", "up", "average", "paeth"},
+                    {"Adaptive", "None", "Sub", "Up", "Average", "Paeth"},
+                    false,
+                    "adaptive" );
+
+    IMUI_ComboText( "All Layers As", mLocalVars.cfg_saveLayersFmt,
+                    {"png", "exr"},
+                    {"A PNG per Layer", "Multi-part EXR"},
+                    false,
+                    "png" );
+
+    IMUI_DrawHeader( "Cache" );
+
+    ImGui::SliderInt( "Decoded Images (GB)", &mLocalVars.cfg_decodeCacheGB, 0, 64 );
+    if ( ImGui::IsItemHovered() )
+        ImGui::SetTooltip( "Kept on disk for the next runs. 0 turns it off and empties it" );
+
     IMUI_DrawHeader( "Controls" );
 
     IMUI_ComboText( "Pan Button", mLocalVars.cfg_ctrlPanButton,
@@ -208,6 +230,14 @@ void ConfigWin::drawGeneral()
     IMUI_DrawHeader( "Display" );
 
     ImGui::Checkbox( "Use Bilinear", &locIMSC.imsc_useBilinear );
+
+    ImGui::Checkbox( "Image List Thumbnails", &mLocalVars.cfg_dispThumbs );
+
+    IMUI_ComboText( "Texture Format", locIMSC.imsc_texUploadFmt,
+                    {"float", "half", "rgb10a2"},
+                    {"Float (8 bit storage)", "Half Float", "RGB 10 bit"},
+                    false,
+                    "half" );
 }
 
 //==================================================================
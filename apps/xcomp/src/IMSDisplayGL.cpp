@@ -0,0 +1,52 @@
+//==================================================================
+/// IMSDisplayGL.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include "Graphics.h"
+#include "TexStreamer.h"
+#include "IMSDisplayGL.h"
+
+// display in tiles above this, even if the GL could take it
+static constexpr u_int TILED_MIN_DIM = 8192;
+
+//==================================================================
+IMSDisplayGL::IMSDisplayGL() = default;
+IMSDisplayGL::~IMSDisplayGL() = default;
+
+//==================================================================
+bool IMSDisplayGL::OnInstallComposite( image &img, const IMSConfig &cfg )
+{
+    // large frames are displayed in tiles, uploaded on demand
+    c_auto maxDim = std::min( Graphics::GetMaxTextureSize(), TILED_MIN_DIM );
+    if ( img.mW > maxDim || img.mH > maxDim )
+        return true;
+
+    // upload to the texture object, only what changed
+    if NOT( moTexStreamer )
+        moTexStreamer = std::make_unique<TexStreamer>();
+
+    moTexStreamer->UploadImage(
+            img, TexStreamer::FormatFromName( cfg.imsc_texUploadFmt ) );
+
+    return false;
+}
+
+//==================================================================
+void IMSDisplayGL::OnReplaceComposite( image &newImg, image &oldImg )
+{
+    Graphics::TransferImageTexture( newImg, oldImg );
+}
+
+//==================================================================
+void IMSDisplayGL::OnFreeComposite( image &img )
+{
+    if ( moTexStreamer )
+        moTexStreamer->ForgetTexture( img.GetTextureID() );
+
+    Graphics::FreeImageTexture( img );
+}
+
@@ -0,0 +1,33 @@
+//==================================================================
+/// IMSDisplayGL.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef IMSDISPLAYGL_H
+#define IMSDISPLAYGL_H
+
+#include "ImageSystem.h"
+
+class TexStreamer;
+
+//==================================================================
+// The composites of the ImageSystem as GL textures
+//==================================================================
+class IMSDisplayGL : public IMSDisplay
+{
+    uptr<TexStreamer>   moTexStreamer;
+
+public:
+    IMSDisplayGL();
+    ~IMSDisplayGL() override;
+
+    bool OnInstallComposite( image &img, const IMSConfig &cfg ) override;
+    void OnReplaceComposite( image &newImg, image &oldImg ) override;
+    void OnFreeComposite( image &img ) override;
+};
+
+#endif
+
@@ -17,8 +17,14 @@ void XCConfig::Serialize( SerialJS &v_ ) const
     SERIALIZE_THIS_MEMBER( v_, cfg_scanDir              );
     SERIALIZE_THIS_MEMBER( v_, cfg_scanDirHist          );
     SERIALIZE_THIS_MEMBER( v_, cfg_saveDir              );
+    SERIALIZE_THIS_MEMBER( v_, cfg_savePNGLevel         );
+    SERIALIZE_THIS_MEMBER( v_, cfg_savePNGFilter        );
+    SERIALIZE_THIS_MEMBER( v_, cfg_saveLayersFmt        );
+    SERIALIZE_THIS_MEMBER( v_, cfg_decodeCacheGB        );
     SERIALIZE_THIS_MEMBER( v_, cfg_ctrlPanButton        );
     SERIALIZE_THIS_MEMBER( v_, cfg_dispAutoFit          );
+    SERIALIZE_THIS_MEMBER( v_, cfg_dispThumbs           );
+    SERIALIZE_THIS_MEMBER( v_, cfg_playFPS              );
     SERIALIZE_THIS_MEMBER( v_, cfg_imsConfig           );
     v_.MSerializeObjectEnd();
 }
@@ -29,8 +35,14 @@ void XCConfig::Deserialize( DeserialJS &v_ )
     DESERIALIZE_THIS_MEMBER( v_, cfg_scanDir            );
     DESERIALIZE_THIS_MEMBER( v_, cfg_scanDirHist        );
     DESERIALIZE_THIS_MEMBER( v_, cfg_saveDir            );
+    DESERIALIZE_THIS_MEMBER( v_, cfg_savePNGLevel       );
+    DESERIALIZE_THIS_MEMBER( v_, cfg_savePNGFilter      );
+    DESERIALIZE_THIS_MEMBER( v_, cfg_saveLayersFmt      );
+    DESERIALIZE_THIS_MEMBER( v_, cfg_decodeCacheGB      );
     DESERIALIZE_THIS_MEMBER( v_, cfg_ctrlPanButton      );
     DESERIALIZE_THIS_MEMBER( v_, cfg_dispAutoFit        );
+    DESERIALIZE_THIS_MEMBER( v_, cfg_dispThumbs         );
+    DESERIALIZE_THIS_MEMBER( v_, cfg_playFPS            );
     DESERIALIZE_THIS_MEMBER( v_, cfg_imsConfig          );
 
     // remove empty or unreachable directories
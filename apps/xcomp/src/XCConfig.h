@@ -22,8 +22,14 @@ public:
     DStr                cfg_scanDir             {};
     DVec<DStr>          cfg_scanDirHist         {};
     DStr                cfg_saveDir             {};
+    int                 cfg_savePNGLevel        { 6 };
+    DStr                cfg_savePNGFilter       { "adaptive" };
+    DStr                cfg_saveLayersFmt       { "png" };
+    int                 cfg_decodeCacheGB       { 8 };
     DStr                cfg_ctrlPanButton       { "left" };
     bool                cfg_dispAutoFit         { true };
+    bool                cfg_dispThumbs          { true };
+    double              cfg_playFPS             { 12 };
 
     IMSConfig           cfg_imsConfig           {};
 
@@ -34,8 +40,14 @@ public:
         cfg_scanDir            =    from.cfg_scanDir            ;
         cfg_scanDirHist        =    from.cfg_scanDirHist        ;
         cfg_saveDir            =    from.cfg_saveDir            ;
+        cfg_savePNGLevel       =    from.cfg_savePNGLevel       ;
+        cfg_savePNGFilter      =    from.cfg_savePNGFilter      ;
+        cfg_saveLayersFmt      =    from.cfg_saveLayersFmt      ;
+        cfg_decodeCacheGB      =    from.cfg_decodeCacheGB      ;
         cfg_ctrlPanButton      =    from.cfg_ctrlPanButton      ;
         cfg_dispAutoFit        =    from.cfg_dispAutoFit        ;
+        cfg_dispThumbs         =    from.cfg_dispThumbs         ;
+        cfg_playFPS            =    from.cfg_playFPS            ;
         cfg_imsConfig          =    from.cfg_imsConfig          ;
     }
 #endif
@@ -45,8 +57,14 @@ public:
             l.cfg_scanDir            !=   r.cfg_scanDir            ||
             l.cfg_scanDirHist        !=   r.cfg_scanDirHist        ||
             l.cfg_saveDir            !=   r.cfg_saveDir            ||
+            l.cfg_savePNGLevel       !=   r.cfg_savePNGLevel       ||
+            l.cfg_savePNGFilter      !=   r.cfg_savePNGFilter      ||
+            l.cfg_saveLayersFmt      !=   r.cfg_saveLayersFmt      ||
+            l.cfg_decodeCacheGB      !=   r.cfg_decodeCacheGB      ||
             l.cfg_ctrlPanButton      !=   r.cfg_ctrlPanButton      ||
             l.cfg_dispAutoFit        !=   r.cfg_dispAutoFit        ||
+            l.cfg_dispThumbs         !=   r.cfg_dispThumbs         ||
+            l.cfg_playFPS            !=   r.cfg_playFPS            ||
             l.cfg_imsConfig          !=   r.cfg_imsConfig          ||
             false;
     }
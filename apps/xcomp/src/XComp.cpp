@@ -30,6 +30,7 @@
 #include "IntervalCall.h"
 #include "DLogOut.h"
 #include "DThreads.h"
+#include "StageTimers.h"
 #include "XCConfig.h"
 #include "BC_Utils.h"
 #include "DUT_Str.h"
@@ -43,6 +44,7 @@
 # include <GLFW/glfw3.h>
 
 #include "ImageSystem.h"
+#include "IMSDisplayGL.h"
 
 using namespace std::string_literals;
 
@@ -127,6 +129,25 @@ XComp::XComp( const XCompParams &par )
 
     //
     moIMSys = std::make_unique<ImageSystem>( GetConfigXC().cfg_imsConfig );
+
+    // composites go to GL textures, and the main loop is woken up to
+    //  show them when the background work is done
+    if NOT( mPar.mIsNoUIMode )
+    {
+        moIMSys->moDisplay = std::make_unique<IMSDisplayGL>();
+        moIMSys->mOnWorkDoneFn = [](){ GraphicsApp::PostWakeUp(); };
+    }
+
+    // before the first scan
+    UpdateDecodeCacheXC();
+
+    // for the image list
+    if NOT( mPar.mIsNoUIMode )
+    {
+        ThumbsParams par;
+        par.thp_dir = FU_JPath( mPar.mAppCacheDir, "thumbs" );
+        moIMSys->SetupThumbs( par );
+    }
 }
 
 //==================================================================
@@ -191,17 +212,19 @@ void XComp::animateApp( TimeUS curTimeUS )
 
     moIMSys->AnimateIMS();
 
+    StageTimers::Get().EndFrame();
+
+    // keep going to show the frames on time
+    if ( moIMSys->IsPlaying() && !mPar.mIsNoUIMode )
+        GraphicsApp::PostWakeUp();
+
     checkLazySaveConfig( curTimeUS );
 }
 
 //==================================================================
-void XComp::SaveCompositeXC()
+// where to save, created if needed. Empty on failure
+DStr XComp::makeSaveDir() const
 {
-    if NOT( moIMSys->moComposite )
-        return;
-
-    c_auto &img = *moIMSys->moComposite;
-
     c_auto &conf = GetConfigXC();
     c_auto outDir = conf.cfg_saveDir.empty()
                             ? conf.cfg_scanDir
@@ -214,11 +237,74 @@ void XComp::SaveCompositeXC()
         if NOT( FU_CreateDirectories( outDir ) )
         {
             LogOut( LOG_ERR, "Error while creating %s", outDir.c_str() );
-            return;
+            return {};
         }
     }
 
-    moIMSys->SaveComposite( outDir );
+    return outDir;
+}
+
+//==================================================================
+PNGSaveParams XComp::makePNGSaveParams() const
+{
+    c_auto &conf = GetConfigXC();
+
+    PNGSaveParams par;
+    par.pss_level   = conf.cfg_savePNGLevel;
+    par.pss_filter  = Image_PNGSaveFilterFromName( conf.cfg_savePNGFilter );
+    return par;
+}
+
+//==================================================================
+void XComp::SaveCompositeXC()
+{
+    if NOT( moIMSys->moComposite )
+        return;
+
+    c_auto outDir = makeSaveDir();
+    if ( outDir.empty() )
+        return;
+
+    moIMSys->SaveComposite( outDir, makePNGSaveParams() );
+}
+
+//==================================================================
+void XComp::SaveAllLayersXC()
+{
+    if NOT( moIMSys->moComposite )
+        return;
+
+    c_auto outDir = makeSaveDir();
+    if ( outDir.empty() )
+        return;
+
+    LayersSaveParams par;
+    par.lsp_isMultiPartEXR  = GetConfigXC().cfg_saveLayersFmt == "exr";
+    par.lsp_pngPar          = makePNGSaveParams();
+
+    c_auto layersN = moIMSys->SaveAllLayers( outDir, par );
+
+    LogOut( 0, "Saving %zu layers to %s", layersN, outDir.c_str() );
+}
+
+//==================================================================
+void XComp::UpdateDecodeCacheXC()
+{
+    c_auto gb = (size_t)std::max( 0, GetConfigXC().cfg_decodeCacheGB );
+
+    DecodeCacheParams par;
+    par.dcp_dir         = FU_JPath( mPar.mAppCacheDir, "decode_cache" );
+    par.dcp_maxBytes    = gb * 1024 * 1024 * 1024;
+    moIMSys->SetupDecodeCache( par );
+}
+
+//==================================================================
+void XComp::TogglePlaybackXC()
+{
+    if ( moIMSys->IsPlaying() )
+        moIMSys->StopPlayback();
+    else
+        moIMSys->StartPlayback( GetConfigXC().cfg_playFPS );
 }
 
 //==================================================================
@@ -333,6 +419,10 @@ void XComp::EnterMainLoop( const DFun<void()> &onCreationFn )
 
     par.mNonInteracIntervalUS = mPar.mIsNoFrameSkipUI ? TimeUS() : TimeUS::ONE_SECOND() / 2;
 
+    // sleep until something happens. Wake-ups also come from the
+    //  background work, and the timeout keeps the timed checks going
+    par.mEventWaitTimeoutS = mPar.mIsNoFrameSkipUI ? 0.0 : 0.5;
+
     par.mTitle = makeWindowTitle( GTV_XCOMP_NAME, GTV_SUITE_VERSION, GTV_XCOMP_SUBTITLE );
 
     if (c_auto pos = mAppBaseConfig.GetWinPosABC())
@@ -393,7 +483,9 @@ void XComp::EnterMainLoop( const DFun<void()> &onCreationFn )
 
         animateApp( curTimeUS );
 
-        SleepSecs( 1.0 / 60 ); // low CPU/GPU usage
+        // nothing to wait on without a window
+        if ( mPar.mIsNoUIMode )
+            SleepSecs( 1.0 / 60 ); // low CPU/GPU usage
 
         return true;
     };
@@ -435,6 +527,12 @@ void XComp::EnterMainLoop( const DFun<void()> &onCreationFn )
 
             return true;
 
+        case GLFW_KEY_SPACE:
+            if ( isDown )
+                TogglePlaybackXC();
+
+            return true;
+
         default: break;
         }
 #endif
@@ -68,6 +68,10 @@ public:
     const DStr &GetUserProfDisplay() const { return mPar.mAppUserProfDisplay; }
 
     void SaveCompositeXC();
+    void SaveAllLayersXC();
+    // after a change of the config
+    void UpdateDecodeCacheXC();
+    void TogglePlaybackXC();
 
     void EnterMainLoop( const DFun<void()> &onCreationFn={} );
 
@@ -77,6 +81,9 @@ public:
 private:
     TimeUS mLazySaveConfigTimeUS;
     void reqLazySaveConfig();
+
+    DStr makeSaveDir() const;
+    PNGSaveParams makePNGSaveParams() const;
     void checkLazySaveConfig( TimeUS curTimeUS );
 
     bool onDrop( int count, const char **ppPathFnames );
@@ -8,6 +8,7 @@
 
 #include "imgui.h"
 #include "imgui_stdlib.h"
+#include "implot.h"
 #include "GTVersions.h"
 #include "DLogOut.h"
 #include "DateMacro.h"
@@ -19,6 +20,11 @@
 #include "DisplayBase.h"
 #include "GraphicsApp.h"
 #include "ImageSystem.h"
+#include "ImageTiler.h"
+#include "TileTexCache.h"
+#include "TexAtlas.h"
+#include "StageTimers.h"
+#include "DTrace.h"
 #ifdef ENABLE_IMGUITEXINSPECT
 # include "imgui_tex_inspect.h"
 #endif
@@ -93,56 +99,125 @@ inline auto endGreenCheckbox = []()
 };
 
 //==================================================================
-void XCompUI::drawImgList()
+void XCompUI::updateImgListCache()
 {
     auto &imsys = *mXComp.moIMSys;
 
-    IMUI_DrawHeader( "Images", false );
-
-    if ( imsys.mEntries.empty() )
-    {
-        IMUI_Text( "No images found." );
+    if ( mImgListGen == imsys.mEntriesGen )
         return;
-    }
 
-    DVec<ImageEntry *>  pEntries;
-    DVec<DStr>          fNames;
-    DVec<DStr>          fExts;
+    mImgListGen = imsys.mEntriesGen;
+    mImgListSelPathFName = {};
+    mImgListSelIdx = DNPOS;
+
+    mImgListRows.clear();
 
     for (auto it = imsys.mEntries.begin(); it != imsys.mEntries.end(); ++it)
-        if ( it->second.moBaseImage
+    {
+        auto &e = *it;
+
+        if NOT( e.moBaseImage
 #ifdef ENABLE_OPENEXR
-                || it->second.moEXRImage
+                || e.moEXRImage
 #endif
                 )
-        {
-            pEntries.push_back( &it->second );
+            continue;
+
+        ImgListRow row;
+        row.ilr_pEntry = &e;
+
+        c_auto fsPath = std::filesystem::path( e.mImagePathFName );
 
-            c_auto fsPath = std::filesystem::path( it->second.mImagePathFName );
+        row.ilr_name = StrFromU8Str( fsPath.filename().replace_extension().u8string() );
 
-            fNames.push_back(
-                    StrFromU8Str( fsPath.filename().replace_extension().u8string() ) );
+        auto ext = StrFromU8Str( fsPath.extension().u8string() );
+        row.ilr_ext = ext.empty() ? DStr() : StrMakeUpper( ext.substr(1) );
 
-            auto ext = StrFromU8Str( fsPath.extension().u8string() );
-            fExts.push_back( ext.empty() ? DStr() : StrMakeUpper( ext.substr(1) ) );
+        size_t w = 0;
+        size_t h = 0;
+        size_t laysN = 0;
+#ifdef ENABLE_OPENEXR
+        if (c_auto &oIEXR = e.moEXRImage; oIEXR)
+        {
+            w = oIEXR->ie_w;
+            h = oIEXR->ie_h;
+
+            // 0 layers, if it's a fummy one
+            laysN =
+                (oIEXR->ie_layers.size() == 1
+                    ? (oIEXR->ie_layers.front()->iel_name == ImageSystem::DUMMY_LAYER_NAME
+                        ? 0 : 1)
+                    : oIEXR->ie_layers.size());
+        }
+        else
+#endif
+        if ( e.moBaseImage )
+        {
+            w = e.moBaseImage->mW;
+            h = e.moBaseImage->mH;
+            laysN = 0;
         }
 
-    //
-    bool hasChangedVisibility = false;
+        if ( w || h )
+            row.ilr_size = SSPrintFS("%zux%zu", w, h);
+
+        if ( laysN )
+            row.ilr_laysN = std::to_string( laysN );
+
+        mImgListRows.push_back( std::move( row ) );
+    }
 
 #if 0
-    c_auto commonStem = findCommonPrefix(
-                            [&](auto i){ return fNames[i]; }, fNames.size() );
+    mImgListCommonStem = findCommonPrefix(
+                            [&](auto i){ return mImgListRows[i].ilr_name; },
+                            mImgListRows.size() );
 #else
-    c_auto commonStem = DStr();
+    mImgListCommonStem = {};
 #endif
+}
+
+//==================================================================
+void XCompUI::drawImgList()
+{
+    auto &imsys = *mXComp.moIMSys;
+
+    IMUI_DrawHeader( "Images", false );
+
+    if ( imsys.mEntries.empty() )
+    {
+        IMUI_Text( "No images found." );
+        return;
+    }
+
+    updateImgListCache();
+
+    c_auto &rows = mImgListRows;
+
+    // images up to the selected one are in the composite
+    if ( mImgListSelPathFName != imsys.mCurSelPathFName )
+    {
+        mImgListSelPathFName = imsys.mCurSelPathFName;
+        mImgListSelIdx = DNPOS;
+        for (size_t i=0; i < rows.size(); ++i)
+            if ( rows[i].ilr_pEntry->mImagePathFName == mImgListSelPathFName )
+                mImgListSelIdx = i;
+    }
+
+    c_auto &commonStem = mImgListCommonStem;
 
     c_auto stemIdx = commonStem.size();
 
-    RU_IMUITableMaker tmak( "Images", 6, false );
+    c_auto showThumbs = moConfigWin->GetConfigCW().cfg_dispThumbs;
+
+    RU_IMUITableMaker tmak( "Images", showThumbs ? 7 : 6, false );
     tmak.BeginHead();
     tmak.NewCell();
     tmak.AddText( "On" );
+    if ( showThumbs )
+    {
+        tmak.NewCell();
+        tmak.AddText( "Thumb" );
+    }
     tmak.NewCell();
     tmak.AddText( "Name" + (commonStem.empty() ? "" : " ("+commonStem+")") );
     tmak.NewCell();
@@ -172,19 +247,13 @@ void XCompUI::drawImgList()
         makeHeadPopup( "AllOnPopup", [&]()
         {
             if ( ImGui::Selectable( "All ON", false ) )
-            {
-                hasChangedVisibility = true;
-                for (auto &[k, e] : imsys.mEntries)
-                    e.mIsImageEnabled = true;
-            }
+                imsys.SetAllEntriesEnabled( true );
 
             if ( ImGui::Selectable( "All OFF", false ) )
-            {
-                hasChangedVisibility = true;
-                for (auto &[k, e] : imsys.mEntries)
-                    e.mIsImageEnabled = false;
-            }
+                imsys.SetAllEntriesEnabled( false );
         });
+        if ( showThumbs )
+            tmak.NewCell();
         tmak.NewCell();
         tmak.NewCell();
         tmak.NewCell();
@@ -193,125 +262,181 @@ void XCompUI::drawImgList()
     }
 
     //
+    c_auto savedSelPathFName = imsys.mCurSelPathFName;
 
-    bool hasChangedLayer = false;
+    // thumbnails are made in the background, and a few are uploaded
+    //  at each frame
+    static constexpr u_int THUMBS_ATLAS_SLOTS_N = 256;
+    static constexpr u_int THUMBS_UPLOADS_PER_FRAME = 4;
 
-    c_auto savedSelPathFName = imsys.mCurSelPathFName;
+    if ( showThumbs && !moThumbAtlas )
+    {
+        c_auto thumbSize = ThumbsParams().thp_size;
+        moThumbAtlas = std::make_unique<TexAtlas>(
+                thumbSize, thumbSize, THUMBS_ATLAS_SLOTS_N, THUMBS_UPLOADS_PER_FRAME );
+    }
 
-    bool isInSelRange = false;
+    // same size for all, for the clipper
+    c_auto thumbBoxH = ImGui::GetTextLineHeight() * 3;
+    c_auto thumbBoxW = thumbBoxH * 1.5f;
 
-    for (size_t ii=pEntries.size(); ii > 0; --ii)
+    // past the uploads of this frame, the rest comes in the next ones
+    bool hasDeferredThumbs = false;
+
+    c_auto drawThumb = [&]( u_int entryID )
     {
-        c_auto i = ii - 1;
-        auto &e = *pEntries[i];
+        c_auto pos = ImGui::GetCursorScreenPos();
+        ImGui::Dummy( { thumbBoxW, thumbBoxH } );
+
+        uint64_t gen {};
+        c_auto *pThumb = imsys.GetThumb( entryID, &gen );
+
+        if NOT( pThumb )
+            return;
+
+        TexAtlas::Slot slot;
+        bool isDeferred {};
+        c_auto hasSlot = moThumbAtlas->GetSlot( entryID, *pThumb, gen, slot, &isDeferred );
+        hasDeferredThumbs |= isDeferred;
+
+        if NOT( hasSlot )
+            return;
+
+        // fit and center in the box
+        c_auto sca = std::min( thumbBoxW / (float)slot.sl_w, thumbBoxH / (float)slot.sl_h );
+        c_auto w = (float)slot.sl_w * sca;
+        c_auto h = (float)slot.sl_h * sca;
+        c_auto x = pos.x + (thumbBoxW - w) * 0.5f;
+        c_auto y = pos.y + (thumbBoxH - h) * 0.5f;
+
+        ImGui::GetWindowDrawList()->AddImage(
+                (void *)(ptrdiff_t)slot.sl_texID,
+                { x, y },
+                { x + w, y + h },
+                { slot.sl_uv1[0], slot.sl_uv1[1] },
+                { slot.sl_uv2[0], slot.sl_uv2[1] } );
+    };
 
-        if ( !isInSelRange && imsys.mCurSelPathFName == e.mImagePathFName )
-            isInSelRange = true;
+    DVec<u_int> thumbReqIDs;
 
-        tmak.NewCell();
+    // only the rows in view, latest image first
+    ImGuiListClipper clipper;
+    clipper.Begin( (int)rows.size() );
+    while ( clipper.Step() )
+    {
+        for (int r=clipper.DisplayStart; r < clipper.DisplayEnd; ++r)
+        {
+            c_auto i = rows.size() - 1 - (size_t)r;
+            c_auto &row = rows[i];
+            auto &e = *row.ilr_pEntry;
+
+            c_auto isInSelRange = mImgListSelIdx != DNPOS && i <= mImgListSelIdx;
 
-        beginGreenCheckbox( isInSelRange );
+            tmak.NewCell();
+
+            beginGreenCheckbox( isInSelRange );
 #if 1
-        if ( ImGui::Checkbox( SSPrintFS("##ImgItem%zu",i).c_str(), &e.mIsImageEnabled ) )
-        {
-            hasChangedVisibility = true;
-        }
+            bool isOn = e.mIsImageEnabled;
+            if ( ImGui::Checkbox( SSPrintFS("##ImgItem%u",e.mEntryID).c_str(), &isOn ) )
+            {
+                imsys.SetEntryEnabled( e.mEntryID, isOn );
+            }
 #else
-        if ( ImGui::RadioButton( SSPrintFS("##ImgItem%zu",i).c_str(), e.mIsImageEnabled ) )
-        {
-            hasChangedVisibility = true;
-            e.mIsImageEnabled = !e.mIsImageEnabled;
-        }
+            if ( ImGui::RadioButton( SSPrintFS("##ImgItem%u",e.mEntryID).c_str(), e.mIsImageEnabled ) )
+            {
+                imsys.SetEntryEnabled( e.mEntryID, !e.mIsImageEnabled );
+            }
 #endif
-        endGreenCheckbox();
+            endGreenCheckbox();
 
-        if NOT( isInSelRange )
-            IMUI_PushDisabledStyle();
+            if NOT( isInSelRange )
+                IMUI_PushDisabledStyle();
 
-        tmak.NewCell();
-        if ( ImGui::Selectable(
-                        fNames[i].substr(stemIdx).c_str(),
-                        imsys.mCurSelPathFName == e.mImagePathFName,
-                        ImGuiSelectableFlags_SpanAllColumns ) )
-        {
-            imsys.mCurSelPathFName = e.mImagePathFName;
-        }
-
-        tmak.NewCell();
-        tmak.AddText( fExts[i] );
+            if ( showThumbs )
+            {
+                tmak.NewCell();
+                drawThumb( e.mEntryID );
+                thumbReqIDs.push_back( e.mEntryID );
+            }
 
-        size_t w = 0;
-        size_t h = 0;
-        size_t laysN = 0;
-#ifdef ENABLE_OPENEXR
-        if (c_auto &oIEXR = e.moEXRImage; oIEXR)
-        {
-            w = oIEXR->ie_w;
-            h = oIEXR->ie_h;
+            tmak.NewCell();
+            if ( ImGui::Selectable(
+                            row.ilr_name.c_str() + std::min( stemIdx, row.ilr_name.size() ),
+                            i == mImgListSelIdx,
+                            ImGuiSelectableFlags_SpanAllColumns ) )
+            {
+                imsys.mCurSelPathFName = e.mImagePathFName;
+            }
 
-            // 0 layers, if it's a fummy one
-            laysN =
-                (oIEXR->ie_layers.size() == 1
-                    ? (oIEXR->ie_layers.front()->iel_name == ImageSystem::DUMMY_LAYER_NAME
-                        ? 0 : 1)
-                    : oIEXR->ie_layers.size());
-        }
-        else
-#endif
-        if ( e.moBaseImage )
-        {
-            w = e.moBaseImage->mW;
-            h = e.moBaseImage->mH;
-            laysN = 0;
-        }
+            tmak.NewCell();
+            tmak.AddText( row.ilr_ext );
 
-        tmak.NewCell();
+            tmak.NewCell();
 
-        if ( w || h )
-            tmak.AddText( SSPrintFS("%zux%zu", w, h) );
+            if NOT( row.ilr_size.empty() )
+                tmak.AddText( row.ilr_size );
 
-        tmak.NewCell();
+            tmak.NewCell();
 
-        if ( laysN )
-            tmak.AddText( std::to_string( laysN ) );
+            if NOT( row.ilr_laysN.empty() )
+                tmak.AddText( row.ilr_laysN );
 
-        tmak.NewCell();
+            tmak.NewCell();
 
 #ifdef ENABLE_OPENEXR
-        if (c_auto &oIEXR = e.moEXRImage; oIEXR)
-        {
-            if ( oIEXR->FindLayerByName(  imsys.mCurLayerAlphaName ) )
+            if (c_auto &oIEXR = e.moEXRImage; oIEXR)
             {
-                tmak.AddText( "OK" );
+                if ( oIEXR->FindLayerByName(  imsys.mCurLayerAlphaName ) )
+                {
+                    tmak.AddText( "OK" );
+                }
+                else
+                {
+                    tmak.AddText( Display::RED, "N/A" );
+                    tmak.AddTooltip( SSPrintFS(
+                        "This image is not contributing to the composite because it"
+                        " does not contain the \"%s\" layer that is selected as Alpha Mask.",
+                        imsys.mCurLayerAlphaName.c_str() ) );
+                }
             }
             else
+#endif
             {
-                tmak.AddText( Display::RED, "N/A" );
-                tmak.AddTooltip( SSPrintFS(
-                    "This image is not contributing to the composite because it"
-                    " does not contain the \"%s\" layer that is selected as Alpha Mask.",
-                    imsys.mCurLayerAlphaName.c_str() ) );
+                tmak.AddText( "OK" );
             }
-        }
-        else
-#endif
-        {
-            tmak.AddText( "OK" );
-        }
 
-        if NOT( isInSelRange )
-            IMUI_PopDisabledStyle();
+            if NOT( isInSelRange )
+                IMUI_PopDisabledStyle();
+        }
     }
+    clipper.End();
+
+    // the ones in view, or none
+    imsys.RequestThumbs( thumbReqIDs );
+
+    if ( moThumbAtlas )
+        moThumbAtlas->EndFrame();
 
-    if ( savedSelPathFName != imsys.mCurSelPathFName || hasChangedVisibility )
+    // nothing else may ask for a frame
+    if ( hasDeferredThumbs )
+        GraphicsApp::PostWakeUp();
+
+    if ( savedSelPathFName != imsys.mCurSelPathFName )
         imsys.ReqRebuildComposite();
 }
 
 //==================================================================
-void XCompUI::drawLayersList()
+void XCompUI::updateLayerListCache()
 {
     auto &imsys = *mXComp.moIMSys;
 
+    if ( mLayerListGen == imsys.mEntriesGen &&
+         mLayerListSelPathFName == imsys.mCurSelPathFName )
+        return;
+
+    mLayerListGen = imsys.mEntriesGen;
+    mLayerListSelPathFName = imsys.mCurSelPathFName;
+
     std::map<DStr,DVec<const ImageEntry*>>   pIEntsInLays;
 
     // start adding layers only once we find the selected image
@@ -319,7 +444,7 @@ void XCompUI::drawLayersList()
 
     for (auto it = imsys.mEntries.rbegin(); it != imsys.mEntries.rend(); ++it)
     {
-        c_auto &e = it->second;
+        c_auto &e = *it;
 
         if ( e.mImagePathFName == imsys.mCurSelPathFName )
             foundSelImage = true;
@@ -334,46 +459,142 @@ void XCompUI::drawLayersList()
         if (c_auto &oIEImage = e.moEXRImage; oIEImage)
         {
             for (c_auto &oLayer : oIEImage->ie_layers)
-                pIEntsInLays[ oLayer->iel_name ].push_back( &it->second );
+                pIEntsInLays[ oLayer->iel_name ].push_back( &*it );
+        }
+        else
+#endif
+        {
+            pIEntsInLays[ ImageSystem::DUMMY_LAYER_NAME ].push_back( &*it );
+        }
+    }
+
+    mLayerListRows.clear();
+
+    for (c_auto &[k, v] : pIEntsInLays)
+    {
+        LayerListRow row;
+        row.llr_name     = k;
+        row.llr_entriesN = v.size();
+
+        c_auto &e = *v.front();
+#ifdef ENABLE_OPENEXR
+        if ( e.moEXRImage )
+        {
+            if (c_auto *pLayer = e.moEXRImage->FindLayerByName( k ))
+            {
+                for (c_auto &ch : pLayer->iel_chans)
+                {
+                    if NOT( row.llr_chNames.empty() )
+                        row.llr_chNames += ',';
+
+                    if ( ch.iec_chanName.empty() )
+                        continue;
+
+                    row.llr_hasAlpha |= ch.GetChanNameOnly() == "A";
+
+                    row.llr_chNames += ch.GetChanNameOnly();
+
+                    //
+                    if NOT( row.llr_chTypes.empty() )
+                        row.llr_chTypes += ',';
+
+                    switch ( ch.iec_dataType )
+                    {
+                    case IEXR_DTYPE_UINT : row.llr_chTypes += 'U'; break;
+                    case IEXR_DTYPE_HALF : row.llr_chTypes += 'H'; break;
+                    default:
+                    case IEXR_DTYPE_FLOAT: row.llr_chTypes += 'F'; break;
+                    }
+                }
+            }
         }
         else
 #endif
+        if ( e.moBaseImage )
         {
-            pIEntsInLays[ ImageSystem::DUMMY_LAYER_NAME ].push_back( &it->second );
+            row.llr_chNames = "R,G,B,A";
+            row.llr_chTypes = "8,8,8,8";
+            row.llr_hasAlpha = true;
         }
+
+        mLayerListRows.push_back( std::move( row ) );
     }
 
+    mLayerListCommonStem = {};
+    mLayerListStemIdx = DNPOS;
+#ifdef HIDE_LAYERS_COMMON_PREFIX
+    if NOT( mLayerListRows.empty() )
+    {
+        c_auto &refLayerName = mLayerListRows.front().llr_name;
+
+        auto &commonStem = mLayerListCommonStem;
+        auto &stemIdx = mLayerListStemIdx;
+
+        stemIdx = refLayerName.find_first_of( '.' );
+        if ( stemIdx != DStr::npos )
+        {
+            commonStem = refLayerName.substr( 0, stemIdx+1 );
+            for (c_auto &row : mLayerListRows)
+            {
+                if NOT( StrStartsWithI( row.llr_name, commonStem ) )
+                {
+                    commonStem = {};
+                    stemIdx = DNPOS;
+                    break;
+                }
+            }
+        }
+    }
+#endif
+}
+
+//==================================================================
+void XCompUI::drawLayersList()
+{
+    auto &imsys = *mXComp.moIMSys;
+
+    updateLayerListCache();
+
+    c_auto &rows = mLayerListRows;
+
     //
-    if ( pIEntsInLays.empty() )
+    if ( rows.empty() )
         return;
 
+    c_auto findRow = [&]( const DStr &name )
+    {
+        return std::find_if( rows.begin(), rows.end(),
+                    [&]( c_auto &row ){ return row.llr_name == name; } );
+    };
+
     // is current layer now invalid ?
     auto assingDefLayer = [&]( auto &io_name )
     {
-        if ( pIEntsInLays.find( io_name ) != pIEntsInLays.end())
+        if ( findRow( io_name ) != rows.end() )
             return false;
 
         // select a layer name
         io_name = {};
         size_t bestCnt = 0;
-        for (c_auto &[k, v] : pIEntsInLays)
+        for (c_auto &row : rows)
         {
+            c_auto &k = row.llr_name;
             if ( StrEndsWithI( k, "combined" )  ||
                  StrEndsWithI( k, "composite" ) ||
                  StrEndsWithI( k, "beauty" ) )
             {
                 // assign the new layer name if this one is present
                 //  in more entries/images than the current one
-                if ( v.size() > bestCnt )
+                if ( row.llr_entriesN > bestCnt )
                 {
-                    bestCnt = v.size();
+                    bestCnt = row.llr_entriesN;
                     io_name = k;
                 }
             }
         }
 
         if ( io_name.empty() )
-            io_name = pIEntsInLays.begin()->first;
+            io_name = rows.front().llr_name;
 
         return true;
     };
@@ -384,31 +605,11 @@ void XCompUI::drawLayersList()
     if ( didReplaceLayerBase || didReplaceLayerAlpha )
         imsys.ReqRebuildComposite();
 
-    if ( pIEntsInLays.size() == 1 )
+    if ( rows.size() == 1 )
         return;
 
-    DStr commonStem;
-    size_t stemIdx = DNPOS;
-#ifdef HIDE_LAYERS_COMMON_PREFIX
-    {
-        c_auto &refLayerName = pIEntsInLays.begin()->first;
-
-        stemIdx = refLayerName.find_first_of( '.' );
-        if ( stemIdx != DStr::npos )
-        {
-            commonStem = refLayerName.substr( 0, stemIdx+1 );
-            for (c_auto &[k, v] : pIEntsInLays)
-            {
-                if NOT( StrStartsWithI( k, commonStem ) )
-                {
-                    commonStem = {};
-                    stemIdx = DNPOS;
-                    break;
-                }
-            }
-        }
-    }
-#endif
+    c_auto &commonStem = mLayerListCommonStem;
+    c_auto stemIdx = mLayerListStemIdx;
 
     IMUI_DrawHeader( "Layers", false );
 
@@ -428,94 +629,55 @@ void XCompUI::drawLayersList()
 
     bool hasChangedLayer = false;
 
-    for (c_auto &[k, v] : pIEntsInLays)
+    // only the rows in view
+    ImGuiListClipper clipper;
+    clipper.Begin( (int)rows.size() );
+    while ( clipper.Step() )
     {
-        c_auto isCurSel = imsys.mCurLayerName == k;
-
-        //
-        tmak.NewCell();
-        IMUI_PushButtonColors( isCurSel
-                                ? Display::GREEN.ScaleRGB(0.80f)
-                                : Display::GRAY.ScaleRGB(0.50f) );
-        if ( IMUI_SmallButtonEnabled( ("##SelBut"+k).c_str(), true, {20,0} ) )
+        for (int r=clipper.DisplayStart; r < clipper.DisplayEnd; ++r)
         {
-            if NOT( isCurSel )
-            {
-                hasChangedLayer = true;
-                imsys.mCurLayerName = k;
-            }
-        }
-        IMUI_PopButtonColors();
+            c_auto &row = rows[ (size_t)r ];
+            c_auto &k = row.llr_name;
 
-        //
-        tmak.NewCell();
-        if ( ImGui::Selectable(
-                    k.c_str() + (stemIdx != DNPOS ? stemIdx+1 : 0),
-                    isCurSel,
-                    ImGuiSelectableFlags_SpanAllColumns |
-                    ImGuiSelectableFlags_AllowItemOverlap ) )
-        {
-            if NOT( isCurSel )
-            {
-                hasChangedLayer = true;
-                imsys.mCurLayerName = k;
-            }
-        }
+            c_auto isCurSel = imsys.mCurLayerName == k;
 
-        if NOT( v.empty() )
-        {
-            DStr chNames;
-            DStr chTypes;
-
-            bool hasAlpha = false;
-
-            c_auto &e = *v.front();
-#ifdef ENABLE_OPENEXR
-            if ( e.moEXRImage )
+            //
+            tmak.NewCell();
+            IMUI_PushButtonColors( isCurSel
+                                    ? Display::GREEN.ScaleRGB(0.80f)
+                                    : Display::GRAY.ScaleRGB(0.50f) );
+            if ( IMUI_SmallButtonEnabled( ("##SelBut"+k).c_str(), true, {20,0} ) )
             {
-                if (c_auto *pLayer = e.moEXRImage->FindLayerByName( k ))
+                if NOT( isCurSel )
                 {
-                    for (c_auto &ch : pLayer->iel_chans)
-                    {
-                        if NOT( chNames.empty() )
-                            chNames += ',';
-
-                        if ( ch.iec_chanName.empty() )
-                            continue;
-
-                        hasAlpha |= ch.GetChanNameOnly() == "A";
-
-                        chNames += ch.GetChanNameOnly();
-
-                        //
-                        if NOT( chTypes.empty() )
-                            chTypes += ',';
-
-                        switch ( ch.iec_dataType )
-                        {
-                        case IEXR_DTYPE_UINT : chTypes += 'U'; break;
-                        case IEXR_DTYPE_HALF : chTypes += 'H'; break;
-                        default:
-                        case IEXR_DTYPE_FLOAT: chTypes += 'F'; break;
-                        }
-                    }
+                    hasChangedLayer = true;
+                    imsys.mCurLayerName = k;
                 }
             }
-            else
-#endif
-            if ( e.moBaseImage )
+            IMUI_PopButtonColors();
+
+            //
+            tmak.NewCell();
+            if ( ImGui::Selectable(
+                        k.c_str() + (stemIdx != DNPOS ? stemIdx+1 : 0),
+                        isCurSel,
+                        ImGuiSelectableFlags_SpanAllColumns |
+                        ImGuiSelectableFlags_AllowItemOverlap ) )
             {
-                chNames = "R,G,B,A";
-                chTypes = "8,8,8,8";
-                hasAlpha = true;
+                if NOT( isCurSel )
+                {
+                    hasChangedLayer = true;
+                    imsys.mCurLayerName = k;
+                }
             }
+
             tmak.NewCell();
-            IMUI_Text( chNames );
+            IMUI_Text( row.llr_chNames );
             tmak.NewCell();
-            IMUI_Text( chTypes );
+            IMUI_Text( row.llr_chTypes );
 
             tmak.NewCell( 0 );
-            if ( hasAlpha )
+            if ( row.llr_hasAlpha )
             {
 #if 0
                 bool useAlpha = imsys.mCurLayerAlphaName == k;
@@ -540,13 +702,8 @@ void XCompUI::drawLayersList()
 #endif
             }
         }
-        else
-        {
-            tmak.NewCell();
-            tmak.NewCell();
-            tmak.NewCell();
-        }
     }
+    clipper.End();
 
     if ( hasChangedLayer )
         imsys.ReqRebuildComposite();
@@ -580,12 +737,16 @@ void XCompUI::drawCompositeDisp()
 
     c_auto &img = *imsys.moComposite;
 
+    // the composite may be at a reduced level, display it at full size
+    c_auto fullW = (float)imsys.mCompositeFullW;
+    c_auto fullH = (float)imsys.mCompositeFullH;
+
     if ( moConfigWin->GetConfigCW().cfg_dispAutoFit )
     {
-        c_auto sW = (float)dispW / img.mW;
-        c_auto sH = (float)dispH / img.mH;
+        c_auto sW = (float)dispW / fullW;
+        c_auto sH = (float)dispH / fullH;
 
-        c_auto imgWHR = (float)img.mW / img.mH;
+        c_auto imgWHR = fullW / fullH;
 
         if ( sH > sW )
         {
@@ -600,46 +761,225 @@ void XCompUI::drawCompositeDisp()
     }
     else
     {
-        useDispW = (float)img.mW;
-        useDispH = (float)img.mH;
+        useDispW = fullW;
+        useDispH = fullH;
     }
 
-#ifdef ENABLE_IMGUITEXINSPECT
-    ImGuiTexInspect::SetZoomRate( 2.0f );
-
-    ImGuiTexInspect::SetPanButton(
-        moConfigWin->GetConfigCW().cfg_ctrlPanButton == "left"
-            ? ImGuiMouseButton_Left
-            : ImGuiMouseButton_Right );
-
-    //if ( moConfigWin->GetConfigCW().cfg_dispAutoFit )
-    //{
-    //    ImGui::Image( (void *)(ptrdiff_t)img.GetTextureID(), { useDispW, useDispH } );
-    //}
-    //else
-    {
-        ImGuiTexInspect::BeginInspectorPanel(
-                "Inspector",
-                (void *)(ptrdiff_t)img.GetTextureID(),
-                { (float)img.mW, (float)img.mH },
-                ImGuiTexInspect::InspectorFlags_NoTooltip |
-                ImGuiTexInspect::InspectorFlags_NoGrid |
-                (moConfigWin->GetConfigCW().cfg_imsConfig.imsc_useBilinear
-                    ? ImGuiTexInspect::InspectorFlags_NoForceFilterNearest
-                    : 0),
-                ImGuiTexInspect::SizeIncludingBorder{
-                    ImGui::GetContentRegionAvail() }
-                );
-
-        ImGuiTexInspect::SetInspectorZoomRange( 0.125f, 4.f );
-
-        mCurZoom = ImGuiTexInspect::GetInspectorZoom();
-
-        ImGuiTexInspect::EndInspectorPanel();
+    if ( imsys.mCompositeIsTiled )
+    {
+        drawCompositeTiled( img, useDispW );
     }
+    else
+    {
+        // not needed anymore, release the textures
+        if ( moTileTexCache )
+            moTileTexCache->Clear();
+
+        mTiledIsSet = false;
+
+#ifdef ENABLE_IMGUITEXINSPECT
+        ImGuiTexInspect::SetZoomRate( 2.0f );
+
+        ImGuiTexInspect::SetPanButton(
+            moConfigWin->GetConfigCW().cfg_ctrlPanButton == "left"
+                ? ImGuiMouseButton_Left
+                : ImGuiMouseButton_Right );
+
+        //if ( moConfigWin->GetConfigCW().cfg_dispAutoFit )
+        //{
+        //    ImGui::Image( (void *)(ptrdiff_t)img.GetTextureID(), { useDispW, useDispH } );
+        //}
+        //else
+        {
+            ImGuiTexInspect::BeginInspectorPanel(
+                    "Inspector",
+                    (void *)(ptrdiff_t)img.GetTextureID(),
+                    { fullW, fullH },
+                    ImGuiTexInspect::InspectorFlags_NoTooltip |
+                    ImGuiTexInspect::InspectorFlags_NoGrid |
+                    (moConfigWin->GetConfigCW().cfg_imsConfig.imsc_useBilinear
+                        ? ImGuiTexInspect::InspectorFlags_NoForceFilterNearest
+                        : 0),
+                    ImGuiTexInspect::SizeIncludingBorder{
+                        ImGui::GetContentRegionAvail() }
+                    );
+
+            ImGuiTexInspect::SetInspectorZoomRange( 0.125f, 4.f );
+
+            mCurZoom = ImGuiTexInspect::GetInspectorZoom();
+
+            ImGuiTexInspect::EndInspectorPanel();
+        }
 #else
-    ImGui::Image( (void *)(ptrdiff_t)img.GetTextureID(), { useDispW, useDispH } );
+        ImGui::Image( (void *)(ptrdiff_t)img.GetTextureID(), { useDispW, useDispH } );
+
+        mCurZoom = useDispW / fullW;
 #endif
+    }
+
+    // let the image system pick the level of detail that is needed
+    mXComp.moIMSys->SetDisplayScale(
+            mCurZoom * ImGui::GetIO().DisplayFramebufferScale.x );
+}
+
+//==================================================================
+void XCompUI::drawCompositeTiled( const image &img, float fitW )
+{
+    c_auto &imsys = *mXComp.moIMSys;
+    c_auto &cfg = moConfigWin->GetConfigCW();
+
+    c_auto fullW = (double)imsys.mCompositeFullW;
+    c_auto fullH = (double)imsys.mCompositeFullH;
+
+    c_auto availSiz = ImGui::GetContentRegionAvail();
+    if ( availSiz.x < 1 || availSiz.y < 1 )
+        return;
+
+    c_auto viewPos = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton( "##tiled", availSiz,
+                ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonRight );
+
+    // fit the view the first time or when asked to
+    if ( !mTiledIsSet || cfg.cfg_dispAutoFit )
+    {
+        mTiledIsSet = true;
+        mTiledCenter = { fullW * 0.5, fullH * 0.5 };
+        mCurZoom = fitW / (float)fullW;
+    }
+
+    c_auto &io = ImGui::GetIO();
+
+    if ( ImGui::IsItemHovered() && !cfg.cfg_dispAutoFit )
+    {
+        // zoom around the mouse
+        if ( io.MouseWheel != 0 )
+        {
+            c_auto mouseOff = Double2(
+                        io.MousePos.x - (viewPos.x + availSiz.x * 0.5f),
+                        io.MousePos.y - (viewPos.y + availSiz.y * 0.5f) );
+
+            c_auto pointed = mTiledCenter + mouseOff / (double)mCurZoom;
+
+            mCurZoom = std::clamp(
+                        mCurZoom * std::pow( 2.f, io.MouseWheel * 0.5f ),
+                        1.f / 128, 4.f );
+
+            mTiledCenter = pointed - mouseOff / (double)mCurZoom;
+        }
+    }
+
+    c_auto panButton = cfg.cfg_ctrlPanButton == "left"
+                        ? ImGuiMouseButton_Left
+                        : ImGuiMouseButton_Right;
+
+    if ( ImGui::IsItemActive() && ImGui::IsMouseDragging( panButton ) && !cfg.cfg_dispAutoFit )
+    {
+        mTiledCenter -= Double2( io.MouseDelta.x, io.MouseDelta.y ) / (double)mCurZoom;
+    }
+
+    c_auto zoom = (double)mCurZoom;
+
+    // visible rect in full pixels
+    c_auto visRC = Double4(
+                    mTiledCenter[0] - availSiz.x * 0.5 / zoom,
+                    mTiledCenter[1] - availSiz.y * 0.5 / zoom,
+                    availSiz.x / zoom,
+                    availSiz.y / zoom );
+
+    ImageTiler tiler;
+    tiler.Setup( imsys.mCompositeFullW, imsys.mCompositeFullH,
+                 imsys.mCompositeLevel, img.mW, img.mH );
+
+    DVec<ImageTiler::Tile> tiles;
+    tiler.CalcVisibleTiles( tiles, visRC );
+
+    if NOT( moTileTexCache )
+        moTileTexCache = std::make_unique<TileTexCache>();
+
+    c_auto fmt = TexStreamer::FormatFromName( cfg.cfg_imsConfig.imsc_texUploadFmt );
+
+    auto *pDL = ImGui::GetWindowDrawList();
+    pDL->PushClipRect( viewPos, { viewPos.x + availSiz.x, viewPos.y + availSiz.y }, true );
+
+    auto toScreen = [&]( double x, double y )
+    {
+        return ImVec2(
+            (float)(viewPos.x + (x - visRC[0]) * zoom),
+            (float)(viewPos.y + (y - visRC[1]) * zoom) );
+    };
+
+    for (c_auto &t : tiles)
+    {
+        c_auto texID = moTileTexCache->GetTileTexID( img, imsys.mCompositeGen, t, fmt );
+
+        c_auto &rc = t.tl_fullRC;
+        pDL->AddImage(
+                (void *)(ptrdiff_t)texID,
+                toScreen( rc[0], rc[1] ),
+                toScreen( rc[0] + rc[2], rc[1] + rc[3] ) );
+    }
+
+    pDL->PopClipRect();
+
+    moTileTexCache->EndFrame();
+}
+
+//==================================================================
+// the save in progress, or how the last one went
+void XCompUI::drawExportStatus()
+{
+    // the composite and the layers are built before they're queued
+    size_t builtN {};
+    size_t layersN {};
+    if ( mXComp.moIMSys->GetSaveLayersProgress( builtN, layersN ) )
+    {
+        ImGui::SameLine();
+        IMUI_Text( SSPrintFS( "Building layers %zu/%zu", builtN, layersN ) );
+    }
+    else
+    if ( mXComp.moIMSys->IsBuildingSaveComposite() )
+    {
+        ImGui::SameLine();
+        IMUI_Text( "Building the composite" );
+    }
+
+    c_auto jobs = mXComp.moIMSys->moExportQueue->GetStatus();
+    if ( jobs.empty() )
+        return;
+
+    size_t pendingN = 0;
+    const ExportQueue::JobStatus *pCur {};
+    for (c_auto &js : jobs)
+    {
+        if ( js.js_state == ExportQueue::STATE_QUEUED || js.js_state == ExportQueue::STATE_SAVING )
+        {
+            ++pendingN;
+            if ( js.js_state == ExportQueue::STATE_SAVING )
+                pCur = &js;
+        }
+    }
+
+    ImGui::SameLine();
+
+    if ( pCur )
+    {
+        IMUI_Text( SSPrintFS( "Saving %.0f%%", pCur->js_progress * 100 ) );
+        if ( pendingN > 1 )
+        {
+            ImGui::SameLine();
+            IMUI_Text( SSPrintFS( "(%zu more queued)", pendingN - 1 ) );
+        }
+        return;
+    }
+
+    c_auto &last = jobs.back();
+    if ( last.js_state == ExportQueue::STATE_FAILED )
+        IMUI_Text( "Save failed" );
+    else
+        IMUI_Text( SSPrintFS( "Saved in %.1fs", last.js_saveS ) );
+
+    if ( ImGui::IsItemHovered() )
+        ImGui::SetTooltip( "%s", last.js_pathFName.c_str() );
 }
 
 //==================================================================
@@ -652,10 +992,48 @@ void XCompUI::drawDisplayHead()
 
     ImGui::SameLine();
 
+    if ( ImGui::Button( "Save all layers" ) )
+    {
+        mXComp.SaveAllLayersXC();
+    }
+
+    drawExportStatus();
+
+    ImGui::SameLine();
+
     IMUI_Text( SSPrintFS( "%.1f%%",  mCurZoom * 100 ) );
 
     IMUI_LongSameLine();
 
+    auto &imsys = *mXComp.moIMSys;
+
+    if ( ImGui::Button( imsys.IsPlaying() ? "Stop" : "Play" ) )
+        mXComp.TogglePlaybackXC();
+
+    ImGui::SameLine();
+
+    IMUI_SetNextItemWidth( 50 );
+    if ( ImGui::InputDouble( "FPS", &moConfigWin->GetConfigCW().cfg_playFPS, 0, 0, "%.0f" ) )
+    {
+        auto &fps = moConfigWin->GetConfigCW().cfg_playFPS;
+        fps = DClamp( fps, 1.0, 120.0 );
+        mXComp.reqLazySaveConfig();
+    }
+
+    if ( imsys.IsPlaying() )
+    {
+        c_auto &st = imsys.GetPlaybackStats();
+
+        ImGui::SameLine();
+        IMUI_Text( SSPrintFS( "%.1f fps, dropped %zu of %zu, %zu ready",
+                        st.ps_actualFPS,
+                        st.ps_droppedN,
+                        st.ps_droppedN + st.ps_shownN,
+                        st.ps_ringN ) );
+    }
+
+    IMUI_LongSameLine();
+
     if ( ImGui::Button( "Config..." ) )
         moConfigWin->ActivateConfigWin( true, ConfigWin::TAB_GENERAL );
 
@@ -665,7 +1043,7 @@ void XCompUI::drawDisplayHead()
         moConfigWin->ActivateConfigWin( true, ConfigWin::TAB_COLOR_CORR );
 
     // visible message for possible UI freeze
-    if ( mXComp.moIMSys->IsRebuildingComposite() )
+    if ( imsys.IsRebuildingComposite() )
     {
         ImGui::SameLine();
         IMUI_TextColored( Display::YELLOW, "Updating..." );
@@ -681,6 +1059,109 @@ void XCompUI::drawDisplayHead()
 #endif
 }
 
+//==================================================================
+void XCompUI::drawPerfWin()
+{
+    auto &timers = StageTimers::Get();
+
+    if ( ImGui::Button( "Save JSON" ) )
+    {
+        c_auto pathFName = FU_JPath( mXComp.GetCacheDir(), "xcomp_timings.json" );
+        timers.SaveJSON( pathFName );
+        LogOut( 0, "Saved the timings to %s", pathFName.c_str() );
+    }
+
+    // timeline of all the threads, for chrome://tracing or ui.perfetto.dev
+    ImGui::SameLine();
+    if ( ImGui::Button( DTR_IsTracing() ? "Stop Trace" : "Start Trace" ) )
+    {
+        if ( DTR_IsTracing() )
+            DTR_StopTrace();
+        else
+            DTR_StartTrace();
+    }
+
+    ImGui::SameLine();
+    if ( ImGui::Button( "Save Trace" ) )
+        DTR_SaveTrace( FU_JPath( mXComp.GetCacheDir(), "xcomp_trace.json" ) );
+
+    auto &infos = mPerfInfos;
+    timers.GetStageInfos( infos );
+
+    if ( infos.empty() )
+        return;
+
+    // the stages don't nest, but they run at the same time on several
+    //  threads. What they add up to is the CPU time, which can be a few
+    //  times the frame time
+    c_auto histN = infos[0].si_histMS.size();
+    mPerfTotHistMS.assign( histN, 0.f );
+    for (c_auto &si : infos)
+        for (size_t i=0; i < histN && i < si.si_histMS.size(); ++i)
+            mPerfTotHistMS[i] += si.si_histMS[i];
+
+    if ( ImPlot::BeginPlot( "##StageTimes", ImVec2(-1, 200) ) )
+    {
+        ImPlot::SetupAxes( "Frame", "ms", 0, ImPlotAxisFlags_AutoFit );
+        ImPlot::SetupAxisLimits( ImAxis_X1, 0, (double)StageTimers::HISTORY_N, ImGuiCond_Always );
+
+        for (c_auto &si : infos)
+        {
+            if ( si.si_histMS.empty() )
+                continue;
+
+            ImPlot::PlotLine(
+                    si.si_name.c_str(),
+                    si.si_histMS.data(),
+                    (int)si.si_histMS.size() );
+        }
+
+        if ( histN )
+            ImPlot::PlotLine( "cpu total", mPerfTotHistMS.data(), (int)histN );
+
+        ImPlot::EndPlot();
+    }
+
+    RU_IMUITableMaker tmak( "Stages", 6, false );
+    tmak.BeginHead();
+    tmak.NewCell(); tmak.AddText( "Stage" );
+    tmak.NewCell(); tmak.AddText( "Last ms" );
+    tmak.NewCell(); tmak.AddText( "Avg ms" );
+    tmak.NewCell(); tmak.AddText( "Max ms" );
+    tmak.NewCell(); tmak.AddText( "Total s" );
+    tmak.NewCell(); tmak.AddText( "Calls" );
+    tmak.EndHead();
+
+    // summed over the threads, as in the plot
+    StageTimers::StageInfo tot;
+    tot.si_name = "cpu total";
+
+    auto addRow = [&]( c_auto &si )
+    {
+        tmak.NewCell();   tmak.AddText( si.si_name );
+        tmak.NewCell(1);  tmak.AddText( SSPrintFS( "%.2f", si.si_lastMS ) );
+        tmak.NewCell(1);  tmak.AddText( SSPrintFS( "%.2f", si.si_avgMS ) );
+        tmak.NewCell(1);  tmak.AddText( SSPrintFS( "%.2f", si.si_maxMS ) );
+        tmak.NewCell(1);  tmak.AddText( SSPrintFS( "%.2f", si.si_totMS / 1000 ) );
+        tmak.NewCell(1);  tmak.AddText( SSPrintFS( "%llu", (unsigned long long)si.si_callsN ) );
+    };
+
+    for (c_auto &si : infos)
+    {
+        addRow( si );
+
+        tot.si_lastMS += si.si_lastMS;
+        tot.si_avgMS  += si.si_avgMS;
+        tot.si_totMS  += si.si_totMS;
+        tot.si_callsN += si.si_callsN;
+    }
+
+    for (c_auto v : mPerfTotHistMS)
+        tot.si_maxMS = std::max( tot.si_maxMS, (double)v );
+
+    addRow( tot );
+}
+
 //==================================================================
 void XCompUI::SetupGraphicsAppParams( GraphicsAppParams &par )
 {
@@ -725,6 +1206,15 @@ void XCompUI::SetupGraphicsAppParams( GraphicsAppParams &par )
 
     par.mpUILogger = &mUILogger;
 
+    par.mWinDefs.push_back({
+          .wd_name = "Performance"
+        , .wd_dir = "down"
+        , .wd_ratio = 0.40f
+        , .wd_startOpen = false
+        , .wd_closeCross = true
+        , .wd_winDrawFn = [this]() { drawPerfWin(); }
+    });
+
     par.mWinDefs.push_back({
           .wd_name = "Assets"
         , .wd_dir = "left"
@@ -821,6 +1311,14 @@ void XCompUI::SetupGraphicsAppParamsDispConfigMenu( GraphicsAppParams &par )
                 [this](){ moDisplayConfigWin->DrawDisplayConfigWin( mXComp.mpGfxApp ); }
     });
 
+    par.mMenuItems.push_back({
+              .mi_menuName   = "File"
+            , .mi_itemName   = "Performance..."
+            , .mi_pCheckOnOff = nullptr
+            , .mi_onItemSelectFn =
+                [this](){ mXComp.mpGfxApp->SetUIWindowOpen( "Performance", true ); }
+    });
+
     par.mMenuItems.push_back({
               .mi_menuName   = "Help"
             , .mi_itemName   = "About..."
@@ -891,6 +1389,7 @@ void XCompUI::OnAnimateXCUI()
 
         // set the new configuration and rebuild the composite
         mXComp.moIMSys->ReqRebuildComposite( moConfigWin->GetConfigCW().cfg_imsConfig );
+        mXComp.UpdateDecodeCacheXC();
     }
 }
 
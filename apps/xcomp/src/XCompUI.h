@@ -11,11 +11,16 @@
 
 #include "DBase.h"
 #include "UILogger.h"
+#include "StageTimers.h"
 
 class XComp;
 class DisplayConfigWin;
 struct GraphicsAppParams;
 class ConfigWin;
+class TileTexCache;
+class TexAtlas;
+class image;
+struct ImageEntry;
 
 //==================================================================
 class XCompUI
@@ -38,6 +43,44 @@ class XCompUI
 
     float               mCurZoom = 1.0f;
 
+    // tiled display, for frames too large for a single texture
+    uptr<TileTexCache>  moTileTexCache;
+    Double2             mTiledCenter {0,0};     // full pixels at the view center
+    bool                mTiledIsSet {};
+
+    // derived from the entries, rebuilt only when they change
+    struct ImgListRow
+    {
+        ImageEntry  *ilr_pEntry {};
+        DStr        ilr_name;
+        DStr        ilr_ext;
+        DStr        ilr_size;
+        DStr        ilr_laysN;
+    };
+    DVec<ImgListRow>    mImgListRows;
+    uptr<TexAtlas>      moThumbAtlas;
+    uint64_t            mImgListGen = (uint64_t)-1;
+    DStr                mImgListCommonStem;
+    DStr                mImgListSelPathFName;
+    size_t              mImgListSelIdx = DNPOS;
+
+    struct LayerListRow
+    {
+        DStr        llr_name;
+        size_t      llr_entriesN {};    // images that have the layer
+        DStr        llr_chNames;
+        DStr        llr_chTypes;
+        bool        llr_hasAlpha {};
+    };
+    DVec<LayerListRow>  mLayerListRows;
+    uint64_t            mLayerListGen = (uint64_t)-1;
+    DStr                mLayerListSelPathFName;
+    DStr                mLayerListCommonStem;
+    size_t              mLayerListStemIdx = DNPOS;
+
+    DVec<StageTimers::StageInfo>    mPerfInfos;
+    DVec<float>                     mPerfTotHistMS;
+
 public:
     XCompUI( XComp &bl );
     ~XCompUI();
@@ -47,10 +90,15 @@ public:
     void OnAnimateXCUI();
 
 private:
+    void updateImgListCache();
     void drawImgList();
+    void updateLayerListCache();
     void drawLayersList();
+    void drawExportStatus();
     void drawDisplayHead();
     void drawCompositeDisp();
+    void drawCompositeTiled( const image &img, float fitW );
+    void drawPerfWin();
 };
 
 #endif
@@ -0,0 +1,260 @@
+//==================================================================
+/// BatchCompositor.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <filesystem>
+#include "TimeUtils.h"
+#include "DExceptions.h"
+#include "DLogOut.h"
+#include "DThreads.h"
+#include "FileUtils.h"
+#include "StringUtils.h"
+#include "SerializeJS.h"
+#include "Image_PNG.h"
+#include "Image_EXR.h"
+#include "BatchCompositor.h"
+
+namespace fs = std::filesystem;
+
+//==================================================================
+void BatchResult::Serialize( SerialJS &v_ ) const
+{
+    v_.MSerializeObjectStart();
+    SERIALIZE_THIS_MEMBER( v_, bres_dir             );
+    SERIALIZE_THIS_MEMBER( v_, bres_outPathFName    );
+    SERIALIZE_THIS_MEMBER( v_, bres_error           );
+    SERIALIZE_THIS_MEMBER( v_, bres_imagesN         );
+    SERIALIZE_THIS_MEMBER( v_, bres_w               );
+    SERIALIZE_THIS_MEMBER( v_, bres_h               );
+    SERIALIZE_THIS_MEMBER( v_, bres_loadMS          );
+    SERIALIZE_THIS_MEMBER( v_, bres_compMS          );
+    SERIALIZE_THIS_MEMBER( v_, bres_saveMS          );
+    SERIALIZE_THIS_MEMBER( v_, bres_mpixPerS        );
+    v_.MSerializeObjectEnd();
+}
+
+//==================================================================
+BatchCompositor::BatchCompositor( const BatchParams &par )
+    : mPar(par)
+{
+    if ( mPar.bp_layerName.empty() )
+        mPar.bp_layerName = ImageSystem::DUMMY_LAYER_NAME;
+
+    mPar.bp_jobsN = std::max( mPar.bp_jobsN, (size_t)1 );
+}
+
+//==================================================================
+DStr BatchCompositor::makeOutPathFName( const DStr &dir ) const
+{
+    c_auto ext = mPar.bp_format == "exr" ? ".exr" : ".png";
+
+    // in the folder itself, the scan skips it when run again
+    if ( mPar.bp_outDir.empty() )
+        return FU_JPath( dir, DStr("xComp_out") + ext );
+
+    // named after the folder, so that many can go in the same place
+    auto p = fs::path( dir ).lexically_normal();
+    if ( p.filename().empty() )
+        p = p.parent_path();
+
+    return FU_JPath( mPar.bp_outDir, p.filename().string() + ext );
+}
+
+//==================================================================
+BatchResult BatchCompositor::compositeDir( const DStr &dir ) const
+{
+    BatchResult res;
+    res.bres_dir = dir;
+    res.bres_outPathFName = makeOutPathFName( dir );
+
+    if NOT( FU_DirectoryExists( dir ) )
+    {
+        res.bres_error = "Not a directory";
+        return res;
+    }
+
+    auto names = ImageSystem::FindDirImages( dir );
+
+    // the selection range
+    if ( mPar.bp_last < names.size() )
+        names.resize( mPar.bp_last + 1 );
+
+    names.erase( names.begin(), names.begin() + (ptrdiff_t)std::min( mPar.bp_first, names.size() ) );
+
+    if ( names.empty() )
+    {
+        res.bres_error = "No images in range";
+        return res;
+    }
+
+    ImageSystem ims( mPar.bp_imsCfg );
+    ims.mCurLayerName       = mPar.bp_layerName;
+    ims.mCurLayerAlphaName  = mPar.bp_alphaLayerName;
+
+    c_auto t0 = GetSteadyTimeS();
+
+    ims.SetImages( names );
+
+    c_auto t1 = GetSteadyTimeS();
+
+    c_auto oComp = ims.MakeCompositeNow();
+
+    c_auto t2 = GetSteadyTimeS();
+
+    if NOT( oComp )
+    {
+        res.bres_error = SSPrintFS( "Nothing to composite for the layer %s", mPar.bp_layerName.c_str() );
+        return res;
+    }
+
+#if defined(ENABLE_OPENEXR)
+    if ( mPar.bp_format == "exr" )
+        ImageEXR_SaveImage( res.bres_outPathFName, *oComp, mPar.bp_isHalf );
+    else
+#endif
+    {
+        // float is converted to 8 bit by the saver
+        PNGSaveParams par;
+        par.pss_level   = mPar.bp_pngLevel;
+        par.pss_filter  = Image_PNGSaveFilterFromName( mPar.bp_pngFilter );
+        Image_PNGSave( *oComp, res.bres_outPathFName.c_str(), par );
+    }
+
+    c_auto t3 = GetSteadyTimeS();
+
+    res.bres_imagesN    = names.size();
+    res.bres_w          = oComp->mW;
+    res.bres_h          = oComp->mH;
+    res.bres_loadMS     = (t1 - t0) * 1000.0;
+    res.bres_compMS     = (t2 - t1) * 1000.0;
+    res.bres_saveMS     = (t3 - t2) * 1000.0;
+
+    c_auto inMPix = (double)oComp->mW * oComp->mH * names.size() / 1e6;
+    res.bres_mpixPerS   = inMPix / std::max( t3 - t0, 1e-9 );
+
+    return res;
+}
+
+//==================================================================
+size_t BatchCompositor::Run( const DVec<DStr> &dirs )
+{
+    if ( !mPar.bp_outDir.empty() &&
+         !(FU_CreateDirectories( mPar.bp_outDir ) || FU_DirectoryExists( mPar.bp_outDir )) )
+        DEX_RUNTIME_ERROR( "Could not create %s", mPar.bp_outDir.c_str() );
+
+    mResults.clear();
+    mResults.resize( dirs.size() );
+
+    c_auto startS = GetSteadyTimeS();
+
+    // each folder has its own ImageSystem, which also spreads its work
+    //  on the shared workers. More at once helps with small folders
+    DT_QuickThreadPool pool( mPar.bp_jobsN );
+    for (size_t i=0; i < dirs.size(); ++i)
+    {
+        pool.AddThread( [this, &dirs, i]()
+        {
+            try {
+                mResults[i] = compositeDir( dirs[i] );
+            } catch (const std::exception &ex)
+            {
+                mResults[i].bres_dir   = dirs[i];
+                mResults[i].bres_error = ex.what();
+            }
+
+            c_auto &r = mResults[i];
+            if ( r.bres_error.empty() )
+                LogOut( 0, "Saved %s", r.bres_outPathFName.c_str() );
+            else
+                LogOut( LOG_ERR, "Failed %s: %s", r.bres_dir.c_str(), r.bres_error.c_str() );
+        });
+    }
+    pool.JoinTheads();
+
+    mTotTimeS = GetSteadyTimeS() - startS;
+
+    return (size_t)std::count_if( mResults.begin(), mResults.end(), []( c_auto &r )
+    {
+        return !r.bres_error.empty();
+    });
+}
+
+//==================================================================
+void BatchCompositor::Print() const
+{
+    printf( "%-40s %6s %11s %9s %9s %9s %9s\n",
+            "folder", "images", "size", "load_ms", "comp_ms", "save_ms", "MPix/s" );
+
+    size_t  totImagesN = 0;
+    double  totMPix = 0;
+    for (c_auto &r : mResults)
+    {
+        if NOT( r.bres_error.empty() )
+        {
+            printf( "%-40s %s\n", r.bres_dir.c_str(), r.bres_error.c_str() );
+            continue;
+        }
+
+        printf( "%-40s %6zu %5ux%-5u %9.1f %9.1f %9.1f %9.1f\n",
+                r.bres_dir.c_str(),
+                r.bres_imagesN,
+                r.bres_w,
+                r.bres_h,
+                r.bres_loadMS,
+                r.bres_compMS,
+                r.bres_saveMS,
+                r.bres_mpixPerS );
+
+        totImagesN += r.bres_imagesN;
+        totMPix    += (double)r.bres_w * r.bres_h * r.bres_imagesN / 1e6;
+    }
+
+    printf( "\n%zu folders, %zu images in %.2f s: %.1f images/s, %.1f MPix/s\n",
+            mResults.size(),
+            totImagesN,
+            mTotTimeS,
+            (double)totImagesN / std::max( mTotTimeS, 1e-9 ),
+            totMPix / std::max( mTotTimeS, 1e-9 ) );
+}
+
+//==================================================================
+struct BatchReport
+{
+    double              brep_epochTimeS {};
+    size_t              brep_threadsN {};
+    size_t              brep_jobsN {};
+    double              brep_totTimeS {};
+    DVec<BatchResult>   brep_results;
+
+    void Serialize( SerialJS &v_ ) const
+    {
+        v_.MSerializeObjectStart();
+        SERIALIZE_THIS_MEMBER( v_, brep_epochTimeS  );
+        SERIALIZE_THIS_MEMBER( v_, brep_threadsN    );
+        SERIALIZE_THIS_MEMBER( v_, brep_jobsN       );
+        SERIALIZE_THIS_MEMBER( v_, brep_totTimeS    );
+        SERIALIZE_THIS_MEMBER( v_, brep_results     );
+        v_.MSerializeObjectEnd();
+    }
+    friend void Serialize( SerialJS &v_, const BatchReport &o_ ){ o_.Serialize(v_); }
+};
+
+//==================================================================
+void BatchCompositor::SaveJSON( const DStr &pathFName ) const
+{
+    BatchReport rep;
+    rep.brep_epochTimeS = GetEpochTimeS();
+    rep.brep_threadsN   = DT_GetParallelThreadsN();
+    rep.brep_jobsN      = mPar.bp_jobsN;
+    rep.brep_totTimeS   = mTotTimeS;
+    rep.brep_results    = mResults;
+
+    SerializeToFile( pathFName, rep );
+
+    LogOut( 0, "Saved %zu results to %s", mResults.size(), pathFName.c_str() );
+}
+
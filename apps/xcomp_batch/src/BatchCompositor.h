@@ -0,0 +1,79 @@
+//==================================================================
+/// BatchCompositor.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef BATCHCOMPOSITOR_H
+#define BATCHCOMPOSITOR_H
+
+#include "DBase.h"
+#include "DContainers.h"
+#include "ImageSystem.h"
+
+class SerialJS;
+
+//==================================================================
+struct BatchParams
+{
+    DStr        bp_layerName;               // default is the top RGBA
+    DStr        bp_alphaLayerName;
+    IMSConfig   bp_imsCfg;
+    size_t      bp_first    {0};            // range of the images, in name order
+    size_t      bp_last     {DNPOS};
+    DStr        bp_format   {"png"};        // "png" or "exr"
+    bool        bp_isHalf   {true};         // for "exr"
+    int         bp_pngLevel {6};            // for "png"
+    DStr        bp_pngFilter{"adaptive"};
+    DStr        bp_outDir;                  // default is each folder
+    size_t      bp_jobsN    {1};            // folders at the same time
+};
+
+//==================================================================
+struct BatchResult
+{
+    DStr        bres_dir;
+    DStr        bres_outPathFName;
+    DStr        bres_error;                 // empty if it went well
+    size_t      bres_imagesN {};
+    u_int       bres_w {};
+    u_int       bres_h {};
+    double      bres_loadMS {};
+    double      bres_compMS {};
+    double      bres_saveMS {};
+    double      bres_mpixPerS {};           // of the images in, over the whole time
+
+    void Serialize( SerialJS &v_ ) const;
+    friend void Serialize( SerialJS &v_, const BatchResult &o_ ){ o_.Serialize(v_); }
+};
+
+//==================================================================
+// Composites folders of images to files, as xcomp would show them,
+//  without a display
+//==================================================================
+class BatchCompositor
+{
+    BatchParams         mPar;
+    DVec<BatchResult>   mResults;
+    double              mTotTimeS {};
+
+public:
+    BatchCompositor( const BatchParams &par );
+
+    // returns the number of folders that failed
+    size_t Run( const DVec<DStr> &dirs );
+
+    const DVec<BatchResult> &GetResults() const { return mResults; }
+
+    void Print() const;
+    void SaveJSON( const DStr &pathFName ) const;
+
+private:
+    DStr makeOutPathFName( const DStr &dir ) const;
+    BatchResult compositeDir( const DStr &dir ) const;
+};
+
+#endif
+
@@ -0,0 +1,220 @@
+//==================================================================
+/// main.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <filesystem>
+
+#include "DExceptions.h"
+#include "StringUtils.h"
+#include "FileUtils.h"
+#include "DLogOut.h"
+#include "BatchCompositor.h"
+
+//==================================================================
+static void printUsage( const char *pArgv0, const char *pMsg, ... )
+{
+    if ( pMsg )
+    {
+        va_list vl;
+        va_start( vl, pMsg );
+        vprintf( pMsg, vl );
+        va_end( vl );
+    }
+
+    printf(
+R"RAW(
+
+Usage:
+ %s [options] <dir> [<dir>...]
+
+Composites the images of each folder, as xcomp would show them with the
+last image selected, and saves the result.
+
+Options:
+ --help                 : This help
+ --layer <name>         : EXR layer to composite (default is the top RGBA)
+ --alpha-layer <name>   : EXR layer to use as alpha
+ --first <i>            : First image of the range, in name order (default 0)
+ --last <i>             : Last image of the range (default is the last one)
+ --xform <name>         : Color transform: none, filmic or ocio (default none)
+ --no-srgb              : Don't apply the sRGB curve
+ --ccor-all             : Color correct also the layers that aren't RGBA
+ --ocio-config <file>   : OCIO config, for --xform ocio
+ --ocio-display <name>  : OCIO display
+ --ocio-view <name>     : OCIO view
+ --ocio-look <name>     : OCIO look
+ --format <fmt>         : png or exr (default png)
+ --float                : 32 bit float EXR, instead of half
+ --png-level <n>        : PNG compression, 0 to 9 (default 6)
+ --png-filter <name>    : PNG filter: adaptive, none, sub, up, average or paeth
+                          (default adaptive)
+ --out <dir>            : Save as <dir>/<folder name>.<fmt> (default <dir>/xComp_out.<fmt>)
+ --jobs <n>             : Folders to composite at the same time (default 1)
+ --json <file>          : Save the timings as JSON
+ --log-dir <dir>        : Where to write the log
+
+Examples:
+ %s /renders/shot010 --layer diffuse --format exr
+ %s --jobs 4 --xform ocio --ocio-config aces.ocio --out /review /renders/shot*
+)RAW",
+    pArgv0,
+    pArgv0,
+    pArgv0 );
+}
+
+//==================================================================
+struct BatchArgs
+{
+    BatchParams     bta_par;
+    DVec<DStr>      bta_dirs;
+    DStr            bta_jsonPathFName;
+    DStr            bta_logDir;
+};
+
+//==================================================================
+static BatchArgs parseArgs( int argc, const char* argv[] )
+{
+    auto nextParam = [&]( auto &io_idx )
+    {
+        if ( ++io_idx >= argc )
+        {
+            printUsage( argv[0], "Missing parameters ?" );
+            exit( -1 );
+        }
+
+        return argv[io_idx];
+    };
+
+    BatchArgs args;
+    auto &bp = args.bta_par;
+    auto &cfg = bp.bp_imsCfg;
+
+	for (int i=1; i < argc; ++i)
+	{
+        auto isparam = [&]( c_auto &src ) { return !strcasecmp( argv[i], src ); };
+
+		if (isparam("--help" ))
+        {
+            printUsage( argv[0], nullptr );
+            exit( 0 );
+        }
+		else if (isparam("--layer" ))           { bp.bp_layerName = nextParam( i ); }
+		else if (isparam("--alpha-layer" ))     { bp.bp_alphaLayerName = nextParam( i ); }
+		else if (isparam("--first" ))           { bp.bp_first = (size_t)atoll( nextParam( i ) ); }
+		else if (isparam("--last" ))            { bp.bp_last = (size_t)atoll( nextParam( i ) ); }
+		else if (isparam("--xform" ))           { cfg.imsc_ccorXform = StrMakeLower( nextParam( i ) ); }
+		else if (isparam("--no-srgb" ))         { cfg.imsc_ccorSRGB = false; }
+		else if (isparam("--ccor-all" ))        { cfg.imsc_ccorRGBOnly = false; }
+		else if (isparam("--ocio-config" ))     { cfg.SetOCIOFName( nextParam( i ) ); }
+		else if (isparam("--ocio-display" ))    { cfg.imsc_ccorOCIODisp = nextParam( i ); }
+		else if (isparam("--ocio-view" ))       { cfg.imsc_ccorOCIOView = nextParam( i ); }
+		else if (isparam("--ocio-look" ))       { cfg.imsc_ccorOCIOLook = nextParam( i ); }
+		else if (isparam("--format" ))          { bp.bp_format = StrMakeLower( nextParam( i ) ); }
+		else if (isparam("--float" ))           { bp.bp_isHalf = false; }
+		else if (isparam("--png-level" ))       { bp.bp_pngLevel = DClamp( atoi( nextParam( i ) ), 0, 9 ); }
+		else if (isparam("--png-filter" ))      { bp.bp_pngFilter = StrMakeLower( nextParam( i ) ); }
+		else if (isparam("--out" ))             { bp.bp_outDir = nextParam( i ); }
+		else if (isparam("--jobs" ))            { bp.bp_jobsN = (size_t)std::max( 1, atoi( nextParam( i ) ) ); }
+		else if (isparam("--json" ))            { args.bta_jsonPathFName = nextParam( i ); }
+		else if (isparam("--log-dir" ))         { args.bta_logDir = nextParam( i ); }
+        else
+        if ( argv[i][0] == '-' )
+        {
+            printUsage( argv[0], "Unknown parameter %s", argv[i] );
+            exit( -1 );
+        }
+        else
+            args.bta_dirs.push_back( argv[i] );
+	}
+
+    if ( args.bta_dirs.empty() )
+    {
+        printUsage( argv[0], "No folders ?" );
+        exit( -1 );
+    }
+
+    if ( cfg.imsc_ccorXform != "none" && cfg.imsc_ccorXform != "filmic" && cfg.imsc_ccorXform != "ocio" )
+    {
+        printUsage( argv[0], "Unknown transform %s", cfg.imsc_ccorXform.c_str() );
+        exit( -1 );
+    }
+
+    if ( cfg.imsc_ccorXform == "ocio" && cfg.imsc_ccorOCIOCfgFName.empty() )
+    {
+        printUsage( argv[0], "--xform ocio needs --ocio-config" );
+        exit( -1 );
+    }
+
+#if defined(ENABLE_OPENEXR)
+    if ( bp.bp_format != "png" && bp.bp_format != "exr" )
+#else
+    if ( bp.bp_format != "png" )
+#endif
+    {
+        printUsage( argv[0], "Unsupported format %s", bp.bp_format.c_str() );
+        exit( -1 );
+    }
+
+    if ( Image_PNGSaveFilterName( Image_PNGSaveFilterFromName( bp.bp_pngFilter ) ) != bp.bp_pngFilter )
+    {
+        printUsage( argv[0], "Unknown PNG filter %s", bp.bp_pngFilter.c_str() );
+        exit( -1 );
+    }
+
+    if ( bp.bp_first > bp.bp_last )
+    {
+        printUsage( argv[0], "--first is past --last" );
+        exit( -1 );
+    }
+
+    if ( args.bta_logDir.empty() )
+    {
+        args.bta_logDir = FU_JPath(
+                std::filesystem::temp_directory_path().string(), "xcomp_batch" );
+    }
+
+    return args;
+}
+
+//==================================================================
+int main( int argc, const char* argv[] )
+{
+    c_auto args = parseArgs( argc, argv );
+
+    if NOT( FU_CreateDirectories( args.bta_logDir ) || FU_DirectoryExists( args.bta_logDir ) )
+    {
+        printf( "Could not create %s\n", args.bta_logDir.c_str() );
+        return -1;
+    }
+
+    LogCreate( "xcomp_batch", args.bta_logDir );
+
+    size_t failedN = 0;
+    try
+    {
+        BatchCompositor bc( args.bta_par );
+
+        failedN = bc.Run( args.bta_dirs );
+
+        bc.Print();
+
+        if NOT( args.bta_jsonPathFName.empty() )
+            bc.SaveJSON( args.bta_jsonPathFName );
+    }
+    catch (const std::exception& ex)
+    {
+        LogOut( LOG_ERR, "Uncaught Exception: %s", ex.what() );
+        return -1;
+    }
+
+    // for the render farm, the step fails if any folder did
+	return failedN ? 1 : 0;
+}
+
@@ -0,0 +1,18 @@
+//==================================================================
+
+#ifndef __STDAFX_H__
+#define __STDAFX_H__
+
+#include <set>
+#include <map>
+#include <unordered_map>
+#include "DBase.h"
+#include "StatUtils.h"
+#include "FileUtils.h"
+#include "TimeUtils.h"
+#include "DExceptions.h"
+#include "DLogOut.h"
+
+#endif
+
+
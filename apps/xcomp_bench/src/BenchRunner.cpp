@@ -0,0 +1,134 @@
+//==================================================================
+/// BenchRunner.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <algorithm>
+#include "TimeUtils.h"
+#include "DLogOut.h"
+#include "DThreads.h"
+#include "SerializeJS.h"
+#include "StringUtils.h"
+#include "BenchRunner.h"
+
+//==================================================================
+void BenchResult::Serialize( SerialJS &v_ ) const
+{
+    v_.MSerializeObjectStart();
+    SERIALIZE_THIS_MEMBER( v_, br_name      );
+    SERIALIZE_THIS_MEMBER( v_, br_args      );
+    SERIALIZE_THIS_MEMBER( v_, br_itersN    );
+    SERIALIZE_THIS_MEMBER( v_, br_minMS     );
+    SERIALIZE_THIS_MEMBER( v_, br_medMS     );
+    SERIALIZE_THIS_MEMBER( v_, br_mpixPerS  );
+    SERIALIZE_THIS_MEMBER( v_, br_gbPerS    );
+    v_.MSerializeObjectEnd();
+}
+
+//==================================================================
+BenchRunner::BenchRunner( const Params &par )
+    : mPar(par)
+{
+    printf( "%-24s %-28s %8s %10s %10s %10s\n",
+            "bench", "args", "iters", "med ms", "MPix/s", "GB/s" );
+}
+
+//==================================================================
+bool BenchRunner::IsSelected( const DStr &name, const DStr &args ) const
+{
+    return mPar.bp_filter.empty() ||
+           StrStrI_( (name + " " + args).c_str(), mPar.bp_filter.c_str() );
+}
+
+//==================================================================
+void BenchRunner::Run(
+            const DStr &name,
+            const DStr &args,
+            size_t pixN,
+            size_t bytesN,
+            const DFun<void ()> &fn,
+            const DFun<void ()> &setupFn )
+{
+    if NOT( IsSelected( name, args ) )
+        return;
+
+    // warm up the caches and the allocator
+    if ( setupFn )
+        setupFn();
+    fn();
+
+    DVec<double> timesS;
+
+    double totS = 0;
+    while ( timesS.size() < mPar.bp_maxItersN &&
+            (timesS.size() < mPar.bp_minItersN || totS < mPar.bp_minTimeS) )
+    {
+        if ( setupFn )
+            setupFn();
+
+        c_auto t0 = GetSteadyTimeUS();
+        fn();
+        c_auto dt = (GetSteadyTimeUS() - t0).CalcTimeS();
+
+        timesS.push_back( dt );
+        totS += dt;
+    }
+
+    std::sort( timesS.begin(), timesS.end() );
+
+    // no zero times, the clock is in microseconds
+    c_auto medS = std::max( timesS[ timesS.size() / 2 ], 1e-6 );
+
+    BenchResult br;
+    br.br_name      = name;
+    br.br_args      = args;
+    br.br_itersN    = timesS.size();
+    br.br_minMS     = timesS[0] * 1000;
+    br.br_medMS     = medS * 1000;
+    br.br_mpixPerS  = (double)pixN / medS / 1e6;
+    br.br_gbPerS    = (double)bytesN / medS / 1e9;
+
+    printf( "%-24s %-28s %8zu %10.3f %10.1f %10.2f\n",
+            br.br_name.c_str(),
+            br.br_args.c_str(),
+            br.br_itersN,
+            br.br_medMS,
+            br.br_mpixPerS,
+            br.br_gbPerS );
+
+    mResults.push_back( std::move( br ) );
+}
+
+//==================================================================
+struct BenchReport
+{
+    double              brp_epochTimeS {};
+    size_t              brp_threadsN {};
+    DVec<BenchResult>   brp_results;
+
+    void Serialize( SerialJS &v_ ) const
+    {
+        v_.MSerializeObjectStart();
+        SERIALIZE_THIS_MEMBER( v_, brp_epochTimeS );
+        SERIALIZE_THIS_MEMBER( v_, brp_threadsN   );
+        SERIALIZE_THIS_MEMBER( v_, brp_results    );
+        v_.MSerializeObjectEnd();
+    }
+    friend void Serialize( SerialJS &v_, const BenchReport &o_ ){ o_.Serialize(v_); }
+};
+
+void BenchRunner::SaveJSON( const DStr &pathFName ) const
+{
+    BenchReport rep;
+    rep.brp_epochTimeS  = GetEpochTimeS();
+    rep.brp_threadsN    = DT_GetParallelThreadsN();
+    rep.brp_results     = mResults;
+
+    SerializeToFile( pathFName, rep );
+
+    LogOut( 0, "Saved %zu results to %s", mResults.size(), pathFName.c_str() );
+}
+
@@ -0,0 +1,73 @@
+//==================================================================
+/// BenchRunner.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include "DBase.h"
+#include "DContainers.h"
+
+class SerialJS;
+
+//==================================================================
+struct BenchResult
+{
+    DStr        br_name;
+    DStr        br_args;            // size, channels, etc.
+    size_t      br_itersN {};
+    double      br_minMS {};
+    double      br_medMS {};
+    double      br_mpixPerS {};     // at the median time
+    double      br_gbPerS {};       // at the median time
+
+    void Serialize( SerialJS &v_ ) const;
+    friend void Serialize( SerialJS &v_, const BenchResult &o_ ){ o_.Serialize(v_); }
+};
+
+//==================================================================
+// Times a function until enough iterations and time have gone by,
+//  and reports the median, so that a stray slow run doesn't count.
+//==================================================================
+class BenchRunner
+{
+public:
+    struct Params
+    {
+        double      bp_minTimeS     {0.5};
+        size_t      bp_minItersN    {3};
+        size_t      bp_maxItersN    {1000};
+        DStr        bp_filter;          // substring of "name args"
+    };
+
+private:
+    Params              mPar;
+    DVec<BenchResult>   mResults;
+
+public:
+    BenchRunner( const Params &par );
+
+    // false if the filter leaves it out, to skip the setup
+    bool IsSelected( const DStr &name, const DStr &args ) const;
+
+    // fn does one iteration, of pixN pixels and bytesN bytes read + written.
+    //  setupFn, if any, runs before each iteration, outside of the timing
+    void Run(
+            const DStr &name,
+            const DStr &args,
+            size_t pixN,
+            size_t bytesN,
+            const DFun<void ()> &fn,
+            const DFun<void ()> &setupFn={} );
+
+    const DVec<BenchResult> &GetResults() const { return mResults; }
+
+    void SaveJSON( const DStr &pathFName ) const;
+};
+
+#endif
+
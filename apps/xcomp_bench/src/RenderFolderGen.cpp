@@ -0,0 +1,292 @@
+//==================================================================
+/// RenderFolderGen.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <cmath>
+#include <random>
+#include <iterator>
+
+#if defined(ENABLE_OPENEXR)
+# include <ImfNamespace.h>
+# include <ImfOutputFile.h>
+# include <ImfHeader.h>
+# include <ImfChannelList.h>
+# include <ImfFrameBuffer.h>
+# include <half.h>
+#endif
+
+#include "DExceptions.h"
+#include "DLogOut.h"
+#include "DThreads.h"
+#include "StringUtils.h"
+#include "FileUtils.h"
+#include "Image.h"
+#include "Image_PNG.h"
+#include "RenderFolderGen.h"
+
+//==================================================================
+namespace
+{
+
+// blocks of the mask, like the buckets of a renderer
+constexpr u_int MASK_BLOCK_SIZE = 16;
+
+//==================================================================
+struct FrameRegion
+{
+    u_int   fr_x {};
+    u_int   fr_y {};
+    u_int   fr_w {};
+    u_int   fr_h {};
+    float   fr_cover {};
+    float   fr_hue {};
+};
+
+//==================================================================
+inline uint32_t rfgHash( uint32_t x, uint32_t y, uint32_t s )
+{
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u ^ s * 0xcb1ab31fu;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return h;
+}
+
+//==================================================================
+// the RGBA of the frame at a pixel, 0 outside of the region
+inline void rfgGetPixel( float out[4], const FrameRegion &r, u_int frameI, u_int x, u_int y )
+{
+    out[0] = out[1] = out[2] = out[3] = 0;
+
+    if ( x < r.fr_x || y < r.fr_y || x >= r.fr_x + r.fr_w || y >= r.fr_y + r.fr_h )
+        return;
+
+    c_auto bx = (x - r.fr_x) / MASK_BLOCK_SIZE;
+    c_auto by = (y - r.fr_y) / MASK_BLOCK_SIZE;
+    if ( (float)(rfgHash( bx, by, frameI ) >> 8) > r.fr_cover * (float)(1u << 24) )
+        return;
+
+    c_auto u = (float)(x - r.fr_x) / (float)r.fr_w;
+    c_auto v = (float)(y - r.fr_y) / (float)r.fr_h;
+
+    // some grain, renders are never flat
+    c_auto grain = (float)(rfgHash( x, y, frameI + 7919 ) & 0xff) * (0.02f / 255);
+
+    out[0] = 0.2f + 0.8f * std::abs( std::sin( r.fr_hue + u * 3.f ) ) + grain;
+    out[1] = 0.2f + 0.8f * std::abs( std::sin( r.fr_hue + v * 2.f + 1.f ) ) + grain;
+    out[2] = 0.2f + 0.6f * (u + v) * 0.5f + grain;
+    out[3] = 1.f;
+}
+
+}
+
+//==================================================================
+RenderFolderGen::RenderFolderGen( const RenderFolderParams &par )
+    : mPar(par)
+{
+    mPar.rfp_regionMin  = DClamp( mPar.rfp_regionMin, 0.01f, 1.f );
+    mPar.rfp_regionMax  = DClamp( mPar.rfp_regionMax, mPar.rfp_regionMin, 1.f );
+    mPar.rfp_alphaCover = DClamp( mPar.rfp_alphaCover, 0.f, 1.f );
+
+#if !defined(ENABLE_OPENEXR)
+    if ( mPar.rfp_format != "png" )
+    {
+        LogOut( LOG_WRN, "No EXR support, making PNG frames" );
+        mPar.rfp_format = "png";
+    }
+#endif
+}
+
+//==================================================================
+DStr RenderFolderGen::MakeFrameFName( size_t frameI ) const
+{
+    c_auto isEXR = mPar.rfp_format == "exr" ||
+                  (mPar.rfp_format == "mixed" && (frameI % 2) == 0);
+
+    return SSPrintFS( "frame_%05zu.%s", frameI, isEXR ? "exr" : "png" );
+}
+
+//==================================================================
+DStr RenderFolderGen::MakeAOVName( size_t aovI )
+{
+    static const char *const sNames[] =
+    {
+        "diffuse", "specular", "emission", "transmission", "volume", "shadow",
+    };
+
+    c_auto n = std::size( sNames );
+    if ( aovI < n )
+        return sNames[ aovI ];
+
+    return SSPrintFS( "%s_%zu", sNames[ aovI % n ], aovI / n );
+}
+
+//==================================================================
+#if defined(ENABLE_OPENEXR)
+namespace IMF = OPENEXR_IMF_NAMESPACE;
+
+static void saveFrameEXR(
+            const DStr &pathFName,
+            const RenderFolderParams &par,
+            const FrameRegion &reg,
+            u_int frameI )
+{
+    c_auto w = par.rfp_w;
+    c_auto h = par.rfp_h;
+
+    // RGBA at the top, then the RGB of each AOV
+    DVec<DStr> chanNames { "R", "G", "B", "A" };
+    for (size_t ai=0; ai < par.rfp_aovsN; ++ai)
+        for (c_auto *pCh : { "R", "G", "B" })
+            chanNames.push_back( RenderFolderGen::MakeAOVName( ai ) + "." + pCh );
+
+    c_auto pixType = par.rfp_isHalf ? IMF::HALF : IMF::FLOAT;
+    c_auto valSize = par.rfp_isHalf ? sizeof(U16) : sizeof(float);
+
+    IMF::Header header( (int)w, (int)h );
+    for (c_auto &name : chanNames)
+        header.channels().insert( name.c_str(), IMF::Channel( pixType ) );
+
+    // one plane per channel
+    DVec<DVec<U8>> planes( chanNames.size() );
+    for (auto &plane : planes)
+        plane.resize( (size_t)w * h * valSize );
+
+    for (u_int y=0; y < h; ++y)
+    {
+        for (u_int x=0; x < w; ++x)
+        {
+            float rgba[4];
+            rfgGetPixel( rgba, reg, frameI, x, y );
+
+            c_auto pixI = (size_t)y * w + x;
+            for (size_t ci=0; ci < chanNames.size(); ++ci)
+            {
+                // each AOV is a different share of the beauty
+                c_auto val = ci < 4
+                                ? rgba[ci]
+                                : rgba[ (ci - 4) % 3 ] * (0.3f + 0.1f * (float)((ci - 4) / 3 % 5));
+
+                if ( par.rfp_isHalf )
+                    ((U16 *)planes[ci].data())[ pixI ] = imath_float_to_half( val );
+                else
+                    ((float *)planes[ci].data())[ pixI ] = val;
+            }
+        }
+    }
+
+    IMF::FrameBuffer fb;
+    for (size_t ci=0; ci < chanNames.size(); ++ci)
+    {
+        fb.insert( chanNames[ci].c_str(),
+                   IMF::Slice( pixType,
+                               (char *)planes[ci].data(),
+                               valSize,
+                               valSize * w ) );
+    }
+
+    IMF::OutputFile file( pathFName.c_str(), header );
+    file.setFrameBuffer( fb );
+    file.writePixels( (int)h );
+}
+#endif
+
+//==================================================================
+static void saveFramePNG(
+            const DStr &pathFName,
+            const RenderFolderParams &par,
+            const FrameRegion &reg,
+            u_int frameI )
+{
+    image::Params ipar;
+    ipar.width  = par.rfp_w;
+    ipar.height = par.rfp_h;
+    ipar.chans  = 4;
+    ipar.depth  = 32;
+
+    image img( ipar );
+
+    for (u_int y=0; y < img.mH; ++y)
+    {
+        auto *pDes = img.GetPixelPtr( 0, y );
+        for (u_int x=0; x < img.mW; ++x)
+        {
+            float rgba[4];
+            rfgGetPixel( rgba, reg, frameI, x, y );
+
+            for (size_t c=0; c < 4; ++c)
+                pDes[c] = (U8)(DClamp( rgba[c], 0.f, 1.f ) * 255 + 0.5f);
+
+            pDes += 4;
+        }
+    }
+
+    Image_PNGSave( img, pathFName.c_str(), false );
+}
+
+//==================================================================
+DStr RenderFolderGen::WriteFrame( size_t frameI, const DStr &dir ) const
+{
+    c_auto w = mPar.rfp_w;
+    c_auto h = mPar.rfp_h;
+
+    std::mt19937 rng( mPar.rfp_seed * 1000003u + (u_int)frameI );
+    std::uniform_real_distribution<float> uni( 0.f, 1.f );
+
+    FrameRegion reg;
+    reg.fr_hue = uni( rng ) * 6.28f;
+
+    // the first one is the full frame, the base for the updates
+    if ( frameI == 0 )
+    {
+        reg.fr_w     = w;
+        reg.fr_h     = h;
+        reg.fr_cover = 1.f;
+    }
+    else
+    {
+        c_auto lerpSide = [&]( u_int full )
+        {
+            c_auto t = DLerp( mPar.rfp_regionMin, mPar.rfp_regionMax, uni( rng ) );
+            return std::max( 1u, (u_int)((float)full * t) );
+        };
+        reg.fr_w     = lerpSide( w );
+        reg.fr_h     = lerpSide( h );
+        reg.fr_x     = (u_int)(uni( rng ) * (float)(w - reg.fr_w));
+        reg.fr_y     = (u_int)(uni( rng ) * (float)(h - reg.fr_h));
+        reg.fr_cover = mPar.rfp_alphaCover;
+    }
+
+    c_auto pathFName = FU_JPath( dir, MakeFrameFName( frameI ) );
+
+#if defined(ENABLE_OPENEXR)
+    if ( StrEndsWithI( pathFName, ".exr" ) )
+        saveFrameEXR( pathFName, mPar, reg, (u_int)frameI );
+    else
+#endif
+        saveFramePNG( pathFName, mPar, reg, (u_int)frameI );
+
+    return pathFName;
+}
+
+//==================================================================
+void RenderFolderGen::WriteAll( const DStr &dir ) const
+{
+    if NOT( FU_CreateDirectories( dir ) || FU_DirectoryExists( dir ) )
+        DEX_RUNTIME_ERROR( "Could not create %s", dir.c_str() );
+
+    LogOut( 0, "Writing %zu frames of %ux%u to %s",
+                mPar.rfp_framesN, mPar.rfp_w, mPar.rfp_h, dir.c_str() );
+
+    // frames are independent, one per worker
+    DT_ParallelFor( mPar.rfp_framesN, 1, [&]( size_t i1, size_t i2 )
+    {
+        for (size_t i=i1; i < i2; ++i)
+            WriteFrame( i, dir );
+    });
+}
+
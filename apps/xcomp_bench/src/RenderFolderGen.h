@@ -0,0 +1,57 @@
+//==================================================================
+/// RenderFolderGen.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef RENDERFOLDERGEN_H
+#define RENDERFOLDERGEN_H
+
+#include "DBase.h"
+#include "DContainers.h"
+
+//==================================================================
+struct RenderFolderParams
+{
+    size_t      rfp_framesN     {16};
+    u_int       rfp_w           {1920};
+    u_int       rfp_h           {1080};
+    u_int       rfp_aovsN       {3};        // layers besides the top RGBA (EXR only)
+    bool        rfp_isHalf      {true};     // or float (EXR only)
+    DStr        rfp_format      {"exr"};    // "exr", "png" or "mixed"
+    float       rfp_regionMin   {0.1f};     // region side, as a fraction of the frame
+    float       rfp_regionMax   {0.5f};
+    float       rfp_alphaCover  {0.8f};     // of the pixels in a region
+    u_int       rfp_seed        {1};
+};
+
+//==================================================================
+// A folder like the one of a render in progress: the first frame is
+//  a full render, the ones after are region updates with alpha, to
+//  be composited over it.
+//==================================================================
+class RenderFolderGen
+{
+    RenderFolderParams  mPar;
+
+public:
+    RenderFolderGen( const RenderFolderParams &par );
+
+    size_t GetFramesN() const { return mPar.rfp_framesN; }
+
+    // names sort in frame order
+    DStr MakeFrameFName( size_t frameI ) const;
+
+    // name of the AOV layer, for frames in EXR
+    static DStr MakeAOVName( size_t aovI );
+
+    // writes one frame in dir, returns its path
+    DStr WriteFrame( size_t frameI, const DStr &dir ) const;
+
+    void WriteAll( const DStr &dir ) const;
+};
+
+#endif
+
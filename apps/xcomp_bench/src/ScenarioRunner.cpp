@@ -0,0 +1,412 @@
+//==================================================================
+/// ScenarioRunner.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include "DExceptions.h"
+#include "DLogOut.h"
+#include "TimeUtils.h"
+#include "StringUtils.h"
+#include "FileUtils.h"
+#include "SerializeJS.h"
+#include "ImageSystem.h"
+#include "ScenarioRunner.h"
+
+//==================================================================
+void LatencyResult::Serialize( SerialJS &v_ ) const
+{
+    v_.MSerializeObjectStart();
+    SERIALIZE_THIS_MEMBER( v_, lr_op        );
+    SERIALIZE_THIS_MEMBER( v_, lr_samplesN  );
+    SERIALIZE_THIS_MEMBER( v_, lr_meanMS    );
+    SERIALIZE_THIS_MEMBER( v_, lr_p50MS     );
+    SERIALIZE_THIS_MEMBER( v_, lr_p90MS     );
+    SERIALIZE_THIS_MEMBER( v_, lr_p99MS     );
+    SERIALIZE_THIS_MEMBER( v_, lr_maxMS     );
+    v_.MSerializeObjectEnd();
+}
+
+//==================================================================
+void LatencyStats::AddSample( const DStr &op, double ms )
+{
+    for (auto &[name, samples] : mSamplesMS)
+    {
+        if ( name == op )
+        {
+            samples.push_back( ms );
+            return;
+        }
+    }
+
+    mSamplesMS.push_back( { op, { ms } } );
+}
+
+//==================================================================
+DVec<LatencyResult> LatencyStats::MakeResults() const
+{
+    DVec<LatencyResult> results;
+
+    for (c_auto &[name, samples] : mSamplesMS)
+    {
+        auto sorted = samples;
+        std::sort( sorted.begin(), sorted.end() );
+
+        // nearest rank
+        c_auto n = sorted.size();
+        c_auto pct = [&]( double p )
+        {
+            c_auto rank = (size_t)std::ceil( p * (double)n );
+            return sorted[ std::clamp( rank, (size_t)1, n ) - 1 ];
+        };
+
+        double sum = 0;
+        for (c_auto v : sorted)
+            sum += v;
+
+        LatencyResult lr;
+        lr.lr_op        = name;
+        lr.lr_samplesN  = n;
+        lr.lr_meanMS    = sum / (double)n;
+        lr.lr_p50MS     = pct( 0.50 );
+        lr.lr_p90MS     = pct( 0.90 );
+        lr.lr_p99MS     = pct( 0.99 );
+        lr.lr_maxMS     = sorted.back();
+        results.push_back( lr );
+    }
+
+    return results;
+}
+
+//==================================================================
+void LatencyStats::Print() const
+{
+    printf( "%-24s %8s %10s %10s %10s %10s %10s\n",
+            "op", "samples", "mean ms", "p50", "p90", "p99", "max" );
+
+    for (c_auto &lr : MakeResults())
+    {
+        printf( "%-24s %8zu %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                lr.lr_op.c_str(),
+                lr.lr_samplesN,
+                lr.lr_meanMS,
+                lr.lr_p50MS,
+                lr.lr_p90MS,
+                lr.lr_p99MS,
+                lr.lr_maxMS );
+    }
+}
+
+//==================================================================
+void LatencyStats::SaveJSON( const DStr &pathFName ) const
+{
+    SerializeToFile( pathFName, MakeResults() );
+
+    LogOut( 0, "Saved the latencies to %s", pathFName.c_str() );
+}
+
+//==================================================================
+//==================================================================
+ScenarioRunner::ScenarioRunner( const ScenarioParams &par )
+    : mPar(par)
+{
+    if ( mPar.sp_saveDir.empty() )
+        mPar.sp_saveDir = FU_JPath( mPar.sp_dir, "xcomp_scenario_out" );
+}
+
+//==================================================================
+uptr<ImageSystem> ScenarioRunner::makeIMS()
+{
+    auto oIMS = std::make_unique<ImageSystem>();
+
+    oIMS->mCurLayerName = ImageSystem::DUMMY_LAYER_NAME;
+
+    // as the app would wake up its main loop
+    oIMS->mOnWorkDoneFn = [this]()
+    {
+        {
+            std::lock_guard lock( mWakeMutex );
+            mHasWake = true;
+        }
+        mWakeCV.notify_one();
+    };
+
+    return oIMS;
+}
+
+//==================================================================
+void ScenarioRunner::waitWork( double maxWaitS )
+{
+    std::unique_lock lock( mWakeMutex );
+
+    mWakeCV.wait_for(
+            lock,
+            std::chrono::microseconds( (int64_t)(maxWaitS * 1e6) ),
+            [this](){ return mHasWake; } );
+
+    mHasWake = false;
+}
+
+//==================================================================
+// animate until the composite is up to date
+void ScenarioRunner::settle( ImageSystem &ims, const DStr &op, double startS )
+{
+    c_auto gen0 = ims.mCompositeGen;
+
+    double firstMS = -1;
+    for (;;)
+    {
+        ims.AnimateIMS();
+
+        c_auto elapsedMS = (GetSteadyTimeS() - startS) * 1000;
+
+        if ( firstMS < 0 && ims.mCompositeGen != gen0 )
+            firstMS = elapsedMS;
+
+        if NOT( ims.IsRebuildingComposite() )
+        {
+            mStats.AddSample( op, elapsedMS );
+            break;
+        }
+
+        // the job may be done before we get to wait, don't wait long
+        waitWork( 0.002 );
+    }
+
+    if ( firstMS >= 0 )
+        mStats.AddSample( op + "_first", firstMS );
+}
+
+//==================================================================
+void ScenarioRunner::Run()
+{
+    if NOT( mPar.sp_replaySrcDir.empty() )
+        runReplay();
+    else
+        runInteractive();
+}
+
+//==================================================================
+void ScenarioRunner::runInteractive()
+{
+    if NOT( FU_DirectoryExists( mPar.sp_dir ) )
+        DEX_RUNTIME_ERROR( "Could not find %s", mPar.sp_dir.c_str() );
+
+    uptr<ImageSystem> oIMS;
+
+    // scan and load everything, until the first composite
+    for (size_t i=0; i < mPar.sp_repsN; ++i)
+    {
+        oIMS = makeIMS();
+
+        c_auto t0 = GetSteadyTimeS();
+        oIMS->OnNewScanDir( mPar.sp_dir, {} );
+        mStats.AddSample( "scan_load", (GetSteadyTimeS() - t0) * 1000 );
+
+        settle( *oIMS, "scan", t0 );
+    }
+
+    auto &ims = *oIMS;
+
+    if ( ims.mEntries.size() < 2 )
+    {
+        LogOut( LOG_WRN, "Need at least 2 images in %s for the scenario", mPar.sp_dir.c_str() );
+        return;
+    }
+
+    // nothing changed, the cost of the periodic check
+    for (size_t i=0; i < mPar.sp_repsN * 4; ++i)
+    {
+        c_auto t0 = GetSteadyTimeS();
+        ims.OnNewScanDir( mPar.sp_dir, {} );
+        mStats.AddSample( "rescan", (GetSteadyTimeS() - t0) * 1000 );
+    }
+
+    // jump between the ends
+    for (size_t i=0; i < mPar.sp_repsN; ++i)
+    {
+        c_auto t0 = GetSteadyTimeS();
+        ims.SetFirstCurSel();
+        settle( ims, "select", t0 );
+
+        c_auto t1 = GetSteadyTimeS();
+        ims.SetLastCurSel();
+        settle( ims, "select", t1 );
+    }
+
+    // step back from the last, and forward again at the start
+    int step = -1;
+    for (size_t i=0; i < mPar.sp_scrubStepsN; ++i)
+    {
+        c_auto t0 = GetSteadyTimeS();
+        if NOT( ims.IncCurSel( step ) )
+        {
+            step = -step;
+            if NOT( ims.IncCurSel( step ) )
+                break;
+        }
+        settle( ims, "scrub", t0 );
+    }
+
+    // through the layers of the first EXR
+    DVec<DStr> layerNames;
+#ifdef ENABLE_OPENEXR
+    for (c_auto &e : ims.mEntries)
+    {
+        if NOT( e.moEXRImage )
+            continue;
+
+        for (c_auto &oL : e.moEXRImage->ie_layers)
+            layerNames.push_back( oL->iel_name );
+        break;
+    }
+#endif
+
+    if ( layerNames.size() > 1 )
+    {
+        for (size_t i=0; i < mPar.sp_repsN; ++i)
+        {
+            for (c_auto &name : layerNames)
+            {
+                c_auto t0 = GetSteadyTimeS();
+                ims.mCurLayerName = name;
+                ims.ReqRebuildComposite();
+                // the first round also loads the layers
+                settle( ims, i == 0 ? "layer_switch_load" : "layer_switch", t0 );
+            }
+        }
+
+        ims.mCurLayerName = ImageSystem::DUMMY_LAYER_NAME;
+        ims.ReqRebuildComposite();
+        settle( ims, "layer_switch", GetSteadyTimeS() );
+    }
+    else
+    {
+        LogOut( 0, "No EXR with more than one layer, skipping the layer switch" );
+    }
+
+    // the full resolution composite to PNG
+    if NOT( FU_CreateDirectories( mPar.sp_saveDir ) || FU_DirectoryExists( mPar.sp_saveDir ) )
+        DEX_RUNTIME_ERROR( "Could not create %s", mPar.sp_saveDir.c_str() );
+
+    for (size_t i=0; i < mPar.sp_repsN; ++i)
+    {
+        // what the UI waits for, then until it's on disk
+        c_auto t0 = GetSteadyTimeS();
+        ims.SaveComposite( mPar.sp_saveDir );
+        mStats.AddSample( "save", (GetSteadyTimeS() - t0) * 1000 );
+
+        // it's queued once it's built, if it wasn't on display
+        while ( ims.IsBuildingSaveComposite() )
+        {
+            ims.AnimateIMS();
+            waitWork( 0.002 );
+        }
+
+        ims.moExportQueue->WaitIdle();
+        mStats.AddSample( "save_done", (GetSteadyTimeS() - t0) * 1000 );
+    }
+}
+
+//==================================================================
+// new files show up while the system is running, as during a render
+void ScenarioRunner::runReplay()
+{
+    namespace fs = std::filesystem;
+
+    DVec<DStr> srcPathFNames;
+    for (c_auto &de : fs::directory_iterator( mPar.sp_replaySrcDir ))
+    {
+        c_auto pathFName = de.path().string();
+        if ( de.is_regular_file() &&
+             (StrEndsWithI( pathFName, ".png" ) || StrEndsWithI( pathFName, ".exr" )) )
+            srcPathFNames.push_back( pathFName );
+    }
+    std::sort( srcPathFNames.begin(), srcPathFNames.end() );
+
+    if ( srcPathFNames.empty() )
+        DEX_RUNTIME_ERROR( "No images in %s", mPar.sp_replaySrcDir.c_str() );
+
+    if NOT( FU_CreateDirectories( mPar.sp_dir ) || FU_DirectoryExists( mPar.sp_dir ) )
+        DEX_RUNTIME_ERROR( "Could not create %s", mPar.sp_dir.c_str() );
+
+    LogOut( 0, "Replaying %zu files into %s, one every %.2f s",
+                srcPathFNames.size(), mPar.sp_dir.c_str(), mPar.sp_arriveIntervalS );
+
+    auto oIMS = makeIMS();
+    auto &ims = *oIMS;
+
+    struct Arrival
+    {
+        DStr    ar_pathFName;
+        double  ar_timeS {};
+    };
+    std::deque<Arrival> pending;
+
+    size_t nextSrcI = 0;
+    auto nextArriveS = GetSteadyTimeS();
+    auto nextScanS   = nextArriveS;
+
+    while ( nextSrcI < srcPathFNames.size() || !pending.empty() )
+    {
+        auto curS = GetSteadyTimeS();
+
+        // copy under another name and rename, so that it shows up whole
+        if ( nextSrcI < srcPathFNames.size() && curS >= nextArriveS )
+        {
+            c_auto &srcPathFName = srcPathFNames[ nextSrcI++ ];
+            c_auto desPathFName = FU_JPath( mPar.sp_dir, fs::path( srcPathFName ).filename().string() );
+            c_auto tmpPathFName = desPathFName + ".partial";
+
+            fs::copy_file( srcPathFName, tmpPathFName, fs::copy_options::overwrite_existing );
+            fs::rename( tmpPathFName, desPathFName );
+
+            pending.push_back( { desPathFName, GetSteadyTimeS() } );
+            nextArriveS += mPar.sp_arriveIntervalS;
+        }
+
+        c_auto tickS = GetSteadyTimeS();
+
+        if ( curS >= nextScanS )
+        {
+            c_auto hasNew = ims.OnNewScanDir( mPar.sp_dir, {} );
+            mStats.AddSample( hasNew ? "rescan_load" : "rescan", (GetSteadyTimeS() - tickS) * 1000 );
+            nextScanS += mPar.sp_scanIntervalS;
+        }
+
+        ims.AnimateIMS();
+
+        // on the main thread, what a frame of the app would spend here
+        mStats.AddSample( "tick", (GetSteadyTimeS() - tickS) * 1000 );
+
+        // displayed, once it's in a finished composite
+        if ( !pending.empty() && !ims.IsRebuildingComposite() )
+        {
+            c_auto selIdx = ims.FindEntryIdx( ims.mCurSelPathFName );
+
+            c_auto doneS = GetSteadyTimeS();
+            while ( !pending.empty() )
+            {
+                c_auto idx = ims.FindEntryIdx( pending.front().ar_pathFName );
+                if ( idx == DNPOS || selIdx == DNPOS || idx > selIdx )
+                    break;
+
+                mStats.AddSample( "arrival", (doneS - pending.front().ar_timeS) * 1000 );
+                pending.pop_front();
+            }
+        }
+
+        // until the next event, or some work is done
+        c_auto nextS = std::min( nextScanS,
+                            nextSrcI < srcPathFNames.size() ? nextArriveS : nextScanS );
+
+        waitWork( std::clamp( nextS - GetSteadyTimeS(), 0.0, 0.010 ) );
+    }
+}
+
@@ -0,0 +1,96 @@
+//==================================================================
+/// ScenarioRunner.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef SCENARIORUNNER_H
+#define SCENARIORUNNER_H
+
+#include <mutex>
+#include <condition_variable>
+#include "DBase.h"
+#include "DContainers.h"
+
+class ImageSystem;
+class SerialJS;
+
+//==================================================================
+struct LatencyResult
+{
+    DStr    lr_op;
+    size_t  lr_samplesN {};
+    double  lr_meanMS {};
+    double  lr_p50MS {};
+    double  lr_p90MS {};
+    double  lr_p99MS {};
+    double  lr_maxMS {};
+
+    void Serialize( SerialJS &v_ ) const;
+    friend void Serialize( SerialJS &v_, const LatencyResult &o_ ){ o_.Serialize(v_); }
+};
+
+//==================================================================
+// latency samples by operation, in the order the operations first show up
+class LatencyStats
+{
+    DVec<std::pair<DStr,DVec<double>>>  mSamplesMS;
+
+public:
+    void AddSample( const DStr &op, double ms );
+
+    DVec<LatencyResult> MakeResults() const;
+
+    void Print() const;
+    void SaveJSON( const DStr &pathFName ) const;
+};
+
+//==================================================================
+struct ScenarioParams
+{
+    DStr        sp_dir;
+    size_t      sp_repsN            {4};    // of each operation
+    size_t      sp_scrubStepsN      {32};
+    DStr        sp_saveDir;                 // default is sp_dir/xcomp_scenario_out
+
+    // files of this dir are copied into sp_dir one at a time, as a render would
+    DStr        sp_replaySrcDir;
+    double      sp_arriveIntervalS  {1.0};
+    double      sp_scanIntervalS    {0.5};  // the app checks every 5 seconds
+};
+
+//==================================================================
+// Drives an ImageSystem without a display, as the main loop of the
+//  app would, and measures how long each operation takes until the
+//  composite is up to date. "<op>_first" is until the first, possibly
+//  reduced, composite is ready.
+//==================================================================
+class ScenarioRunner
+{
+    ScenarioParams          mPar;
+    LatencyStats            mStats;
+
+    std::mutex              mWakeMutex;
+    std::condition_variable mWakeCV;
+    bool                    mHasWake {};
+
+public:
+    ScenarioRunner( const ScenarioParams &par );
+
+    void Run();
+
+    const LatencyStats &GetStats() const { return mStats; }
+
+private:
+    uptr<ImageSystem> makeIMS();
+    void waitWork( double maxWaitS );
+    void settle( ImageSystem &ims, const DStr &op, double startS );
+
+    void runInteractive();
+    void runReplay();
+};
+
+#endif
+
@@ -0,0 +1,787 @@
+//==================================================================
+/// main.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <stdarg.h>
+#include <string.h>
+#include <random>
+#include <filesystem>
+
+#include "DExceptions.h"
+#include "StringUtils.h"
+#include "FileUtils.h"
+#include "DLogOut.h"
+#include "DUT_MemFile.h"
+#include "DUT_Files.h"
+#include "DLZ2.h"
+#include "Image.h"
+#include "ImageConv.h"
+#include "Image_PNG.h"
+#include "ImageAlphaStats.h"
+#include "Image_EXR.h"
+#include "Image_DLS.h"
+#include "ImageSystem.h"
+#include "BenchRunner.h"
+#include "RenderFolderGen.h"
+#include "ScenarioRunner.h"
+
+//==================================================================
+static void printUsage( const char *pArgv0, const char *pMsg, ... )
+{
+    if ( pMsg )
+    {
+        va_list vl;
+        va_start( vl, pMsg );
+        vprintf( pMsg, vl );
+        va_end( vl );
+    }
+
+    printf(
+R"RAW(
+
+Usage:
+ %s [options]                   : Micro benchmarks
+ %s gen <dir> [options]         : Make a synthetic render folder
+ %s scenario <dir> [options]    : Time the operations of the app on a folder
+
+Options:
+ --help                 : This help
+ --json <file>          : Save the results as JSON, to compare over time
+
+Micro benchmarks:
+ --filter <str>         : Run only the benchmarks with <str> in the name or args
+ --min-time <secs>      : Minimum time for each benchmark (default 0.5)
+ --tmp <dir>            : Directory for the files of the load/save benchmarks
+
+gen:
+ --frames <n>           : Number of frames, the first is full, then regions (default 16)
+ --size <w>x<h>         : Frame size (default 1920x1080)
+ --aovs <n>             : AOV layers besides RGBA, for EXR (default 3)
+ --float                : 32 bit float EXR, instead of half
+ --format <fmt>         : exr, png or mixed (default exr)
+ --region <min>,<max>   : Region side as a fraction of the frame (default 0.1,0.5)
+ --alpha-cover <f>      : Fraction of a region with alpha (default 0.8)
+ --seed <n>             : Random seed
+
+scenario:
+ --reps <n>             : Repetitions of each operation (default 4)
+ --scrub <n>            : Steps of the scrubbing (default 32)
+ --save-dir <dir>       : Where to save the composite (default <dir>/xcomp_scenario_out)
+ --replay <src_dir>     : Copy the images of <src_dir> into <dir> over time
+ --interval <secs>      : Time between arrivals, for --replay (default 1)
+ --scan-interval <secs> : Time between the scans, for --replay (default 0.5)
+
+Examples:
+ %s --filter composite --json bench_results.json
+ %s gen /tmp/renders --frames 64 --size 3840x2160 --format mixed
+ %s scenario /tmp/renders --json scenario.json
+ %s scenario /tmp/incoming --replay /tmp/renders --interval 0.5
+)RAW",
+    pArgv0,
+    pArgv0,
+    pArgv0,
+    pArgv0,
+    pArgv0,
+    pArgv0,
+    pArgv0 );
+}
+
+//==================================================================
+struct BenchArgs
+{
+    DStr                ba_mode;            // empty for the micro benchmarks
+    DStr                ba_dir;
+    BenchRunner::Params ba_runPar;
+    RenderFolderParams  ba_genPar;
+    ScenarioParams      ba_scenPar;
+    DStr                ba_jsonPathFName;
+    DStr                ba_tmpDir;
+};
+
+//==================================================================
+static BenchArgs parseArgs( int argc, const char* argv[] )
+{
+    auto nextParam = [&]( auto &io_idx )
+    {
+        if ( ++io_idx >= argc )
+        {
+            printUsage( argv[0], "Missing parameters ?" );
+            exit( -1 );
+        }
+
+        return argv[io_idx];
+    };
+
+    BenchArgs args;
+
+    int i = 1;
+    if ( argc > 1 && (!strcasecmp( argv[1], "gen" ) || !strcasecmp( argv[1], "scenario" )) )
+    {
+        args.ba_mode = argv[1];
+        args.ba_dir  = nextParam( i );
+        i += 1;
+    }
+
+    auto &gp = args.ba_genPar;
+    auto &sp = args.ba_scenPar;
+
+	for (; i < argc; ++i)
+	{
+        auto isparam = [&]( c_auto &src ) { return !strcasecmp( argv[i], src ); };
+
+		if (isparam("--help" ))
+        {
+            printUsage( argv[0], nullptr );
+            exit( 0 );
+        }
+		else if (isparam("--json" ))            { args.ba_jsonPathFName = nextParam( i ); }
+		else if (isparam("--filter" ))          { args.ba_runPar.bp_filter = nextParam( i ); }
+		else if (isparam("--min-time" ))        { args.ba_runPar.bp_minTimeS = atof( nextParam( i ) ); }
+		else if (isparam("--tmp" ))             { args.ba_tmpDir = nextParam( i ); }
+		else if (isparam("--frames" ))          { gp.rfp_framesN = (size_t)atoi( nextParam( i ) ); }
+		else if (isparam("--size" ))
+        {
+            if ( 2 != sscanf( nextParam( i ), "%ux%u", &gp.rfp_w, &gp.rfp_h ) || !gp.rfp_w || !gp.rfp_h )
+            {
+                printUsage( argv[0], "Bad size %s", argv[i] );
+                exit( -1 );
+            }
+        }
+		else if (isparam("--aovs" ))            { gp.rfp_aovsN = (u_int)atoi( nextParam( i ) ); }
+		else if (isparam("--float" ))           { gp.rfp_isHalf = false; }
+		else if (isparam("--format" ))          { gp.rfp_format = StrMakeLower( nextParam( i ) ); }
+		else if (isparam("--region" ))
+        {
+            if ( 2 != sscanf( nextParam( i ), "%f,%f", &gp.rfp_regionMin, &gp.rfp_regionMax ) )
+            {
+                printUsage( argv[0], "Bad region %s", argv[i] );
+                exit( -1 );
+            }
+        }
+		else if (isparam("--alpha-cover" ))     { gp.rfp_alphaCover = (float)atof( nextParam( i ) ); }
+		else if (isparam("--seed" ))            { gp.rfp_seed = (u_int)atoi( nextParam( i ) ); }
+		else if (isparam("--reps" ))            { sp.sp_repsN = std::max( 1, atoi( nextParam( i ) ) ); }
+		else if (isparam("--scrub" ))           { sp.sp_scrubStepsN = (size_t)atoi( nextParam( i ) ); }
+		else if (isparam("--save-dir" ))        { sp.sp_saveDir = nextParam( i ); }
+		else if (isparam("--replay" ))          { sp.sp_replaySrcDir = nextParam( i ); }
+		else if (isparam("--interval" ))        { sp.sp_arriveIntervalS = atof( nextParam( i ) ); }
+		else if (isparam("--scan-interval" ))   { sp.sp_scanIntervalS = std::max( 0.01, atof( nextParam( i ) ) ); }
+        else
+        {
+            printUsage( argv[0], "Unknown parameter %s", argv[i] );
+            exit( -1 );
+        }
+	}
+
+    sp.sp_dir = args.ba_dir;
+
+    if ( gp.rfp_format != "exr" && gp.rfp_format != "png" && gp.rfp_format != "mixed" )
+    {
+        printUsage( argv[0], "Unknown format %s", gp.rfp_format.c_str() );
+        exit( -1 );
+    }
+
+    if ( args.ba_tmpDir.empty() )
+        args.ba_tmpDir = FU_JPath( std::filesystem::temp_directory_path().string(), "xcomp_bench" );
+
+    return args;
+}
+
+//==================================================================
+// synthetic content, smooth gradients with some grain, so that the
+//  codecs see something closer to a render than to white noise
+//==================================================================
+static uptr<image> makeFloatImage( u_int w, u_int h, u_int chans, float alphaCover, u_int seed )
+{
+    image::Params par;
+    par.width   = w;
+    par.height  = h;
+    par.chans   = chans;
+    par.depth   = chans * sizeof(float) * 8;
+    par.flags   = image::FLG_IS_FLOAT32;
+
+    auto oImg = std::make_unique<image>( par );
+
+    std::mt19937 rng( seed );
+    std::uniform_real_distribution<float> grain( -0.02f, 0.02f );
+
+    // alpha in a band that covers the requested fraction of the rows
+    c_auto coverY1 = (u_int)((float)h * (1.f - alphaCover) * 0.5f);
+    c_auto coverY2 = coverY1 + (u_int)((float)h * alphaCover);
+
+    for (u_int y=0; y < h; ++y)
+    {
+        auto *pDes = (float *)oImg->GetPixelPtr( 0, y );
+        for (u_int x=0; x < w; ++x)
+        {
+            c_auto u = (float)x / (float)w;
+            c_auto v = (float)y / (float)h;
+
+            const float rgb[3] = { u, v, 0.5f * (u + v) };
+            for (u_int c=0; c < std::min( chans, 3u ); ++c)
+                pDes[c] = std::max( 0.f, rgb[c] * 1.5f + grain( rng ) );
+
+            if ( chans == 4 || chans == 1 )
+                pDes[chans-1] = (y >= coverY1 && y < coverY2) ? 0.25f + 0.75f * u : 0.f;
+
+            pDes += chans;
+        }
+    }
+
+    return oImg;
+}
+
+//==================================================================
+static uptr<image> makeU8Image( u_int w, u_int h, u_int chans, u_int seed )
+{
+    image::Params par;
+    par.width   = w;
+    par.height  = h;
+    par.chans   = chans;
+    par.depth   = chans * 8;
+
+    auto oImg = std::make_unique<image>( par );
+
+    std::mt19937 rng( seed );
+    std::uniform_int_distribution<int> grain( -4, 4 );
+
+    for (u_int y=0; y < h; ++y)
+    {
+        auto *pDes = oImg->GetPixelPtr( 0, y );
+        for (u_int x=0; x < w; ++x)
+        {
+            const int base[4] = { (int)(x * 255 / w), (int)(y * 255 / h), (int)((x + y) * 127 / (w + h)), 255 };
+            for (u_int c=0; c < chans; ++c)
+                pDes[c] = (U8)DClamp( base[c] + (c < 3 ? grain( rng ) : 0), 0, 255 );
+
+            pDes += chans;
+        }
+    }
+
+    return oImg;
+}
+
+//==================================================================
+static size_t imgBytes( const image &img )
+{
+    return (size_t)img.mBytesPerRow * img.mH;
+}
+
+//==================================================================
+static void benchComposite( BenchRunner &br )
+{
+    struct Size { u_int w, h; };
+    const Size sizes[] = { {1024,1024}, {1920,1080}, {3840,2160} };
+    const size_t entriesNs[] = { 2, 8, 32 };
+
+    // RGB opaque, RGBA at two alpha coverages, RGB with a separate alpha
+    struct AlphaMode { const char *pName; u_int chans; bool sepAlpha; float cover; };
+    const AlphaMode modes[] = {
+        { "rgb",        3, false, 1.00f },
+        { "rgba",       4, false, 0.25f },
+        { "rgba",       4, false, 1.00f },
+        { "rgb+a",      3, true,  0.25f },
+    };
+
+    // keep the sources within a reasonable amount of memory
+    constexpr size_t MAX_TOT_PIX = (size_t)48 << 20;
+
+    for (c_auto &sz : sizes)
+    for (c_auto entriesN : entriesNs)
+    for (c_auto &mode : modes)
+    {
+        if ( (size_t)sz.w * sz.h * entriesN > MAX_TOT_PIX )
+            continue;
+
+        c_auto args = SSPrintFS( "%ux%u n=%zu %s cov=%.2f",
+                            sz.w, sz.h, entriesN, mode.pName, mode.cover );
+
+        if NOT( br.IsSelected( "composite", args ) )
+            continue;
+
+        ImageSystem ims( IMSConfig{} );
+
+        size_t bytesN = 0;
+        for (size_t i=0; i < entriesN; ++i)
+        {
+            ImageEntry e;
+            e.mImagePathFName = SSPrintFS( "bench_%03zu.png", i );
+
+            // the first one is the opaque background
+            c_auto isBG = (i == 0);
+            c_auto chans = isBG ? 3u : mode.chans;
+
+            e.moBaseImage = makeFloatImage( sz.w, sz.h, chans, mode.cover, (u_int)i );
+
+            if ( mode.sepAlpha && !isBG )
+                e.moAlphaImage = makeFloatImage( sz.w, sz.h, 1, mode.cover, (u_int)i );
+
+            // read the sources, read and write the composite
+            bytesN += imgBytes( *e.moBaseImage ) + (size_t)sz.w * sz.h * 3 * sizeof(float) * 2;
+            if ( e.moAlphaImage )
+                bytesN += imgBytes( *e.moAlphaImage );
+
+            ims.mEntries.push_back( std::move( e ) );
+        }
+
+        ims.mCurLayerName = ImageSystem::DUMMY_LAYER_NAME;
+        ims.mCurSelPathFName = ims.mEntries.back().mImagePathFName;
+
+        br.Run( "composite", args, (size_t)sz.w * sz.h * entriesN, bytesN, [&]()
+        {
+            if NOT( ims.MakeCompositeNow() )
+                DEX_RUNTIME_ERROR( "Failed to make the composite" );
+        });
+    }
+}
+
+//==================================================================
+static void benchColorCorr( BenchRunner &br )
+{
+    struct Xform { const char *pXform; bool sRGB; };
+    const Xform xforms[] = {
+        { "none",   true },
+        { "filmic", false },
+        { "filmic", true },
+    };
+
+    constexpr u_int W = 1920;
+    constexpr u_int H = 1080;
+
+    for (c_auto &xf : xforms)
+    {
+        c_auto args = SSPrintFS( "%ux%u %s%s", W, H, xf.pXform, xf.sRGB ? "+srgb" : "" );
+
+        if NOT( br.IsSelected( "color_corr", args ) )
+            continue;
+
+        IMSConfig cfg;
+        cfg.imsc_ccorXform = xf.pXform;
+        cfg.imsc_ccorSRGB  = xf.sRGB;
+
+        ImageSystem ims( cfg );
+
+        c_auto oSrc = makeFloatImage( W, H, 3, 1.f, 0 );
+        image img( *oSrc );
+
+        br.Run( "color_corr", args, (size_t)W * H, imgBytes( img ) * 2,
+            [&](){ ims.ApplyColorCorr( img ); },
+            // start from the same values each time
+            [&](){ memcpy( img.GetPixelPtr( 0, 0 ), oSrc->GetPixelPtr( 0, 0 ), imgBytes( img ) ); } );
+    }
+}
+
+//==================================================================
+static void benchBlit( BenchRunner &br )
+{
+    struct Case { u_int sw, sh, dw, dh; u_int chans; bool isFloat; };
+    const Case cases[] = {
+        { 2048, 2048, 1024, 1024, 4, true  },
+        { 1024, 1024, 2048, 2048, 4, true  },
+        { 3840, 2160, 1920, 1080, 3, true  },
+        { 2048, 2048, 1024, 1024, 4, false },
+        { 1024, 1024, 2048, 2048, 4, false },
+    };
+
+    for (c_auto &c : cases)
+    {
+        c_auto args = SSPrintFS( "%ux%u>%ux%u %s%u",
+                            c.sw, c.sh, c.dw, c.dh, c.isFloat ? "f32x" : "u8x", c.chans );
+
+        if NOT( br.IsSelected( "blit_stretch", args ) )
+            continue;
+
+        c_auto oSrc = c.isFloat
+                        ? makeFloatImage( c.sw, c.sh, c.chans, 1.f, 0 )
+                        : makeU8Image( c.sw, c.sh, c.chans, 0 );
+
+        image::Params par;
+        par.FormatFromImage( *oSrc );
+        par.width   = c.dw;
+        par.height  = c.dh;
+        image des( par );
+
+        c_auto bytesN = (size_t)c.dw * c.dh * oSrc->mBytesPerPixel * 2;
+
+        br.Run( "blit_stretch", args, (size_t)c.dw * c.dh, bytesN, [&]()
+        {
+            ImageConv::BlitStretch( *oSrc, des );
+        });
+    }
+
+    constexpr u_int W = 1920;
+    constexpr u_int H = 1080;
+
+    auto makeDes = []( u_int chans, bool isFloat )
+    {
+        image::Params par;
+        par.width   = W;
+        par.height  = H;
+        par.chans   = chans;
+        par.depth   = chans * (isFloat ? sizeof(float) : 1) * 8;
+        par.flags   = isFloat ? image::FLG_IS_FLOAT32 : 0;
+        return std::make_unique<image>( par );
+    };
+
+    auto runProc = [&]( c_auto *pArgs, c_auto &src, c_auto &des, c_auto &fn )
+    {
+        br.Run( "blit_process", SSPrintFS( "%ux%u %s", W, H, pArgs ),
+                (size_t)W * H, imgBytes( src ) + imgBytes( des ), fn );
+    };
+
+    if ( br.IsSelected( "blit_process", "u8x4>f32x4" ) )
+    {
+        c_auto oSrc = makeU8Image( W, H, 4, 0 );
+        c_auto oDes = makeDes( 4, true );
+        runProc( "u8x4>f32x4", *oSrc, *oDes, [&]()
+        {
+            ImageConv::BlitProcess<U8,float>( *oSrc, *oDes, []( c_auto *pS, auto *pD )
+            {
+                for (size_t i=0; i < 4; ++i)
+                    pD[i] = (float)pS[i] * (1.f / 255);
+            });
+        });
+    }
+
+    if ( br.IsSelected( "blit_process", "f32x3>u8x3" ) )
+    {
+        c_auto oSrc = makeFloatImage( W, H, 3, 1.f, 0 );
+        c_auto oDes = makeDes( 3, false );
+        runProc( "f32x3>u8x3", *oSrc, *oDes, [&]()
+        {
+            ImageConv::BlitProcess<float,U8>( *oSrc, *oDes, []( c_auto *pS, auto *pD )
+            {
+                for (size_t i=0; i < 3; ++i)
+                    pD[i] = (U8)(DClamp( pS[i], 0.f, 1.f ) * 255 + 0.5f);
+            });
+        });
+    }
+
+    if ( br.IsSelected( "blit_process", "f32x3>f32x4" ) )
+    {
+        c_auto oSrc = makeFloatImage( W, H, 3, 1.f, 0 );
+        c_auto oDes = makeDes( 4, true );
+        runProc( "f32x3>f32x4", *oSrc, *oDes, [&]()
+        {
+            ImageConv::BlitProcess<float,float>( *oSrc, *oDes, []( c_auto *pS, auto *pD )
+            {
+                pD[0] = pS[0];
+                pD[1] = pS[1];
+                pD[2] = pS[2];
+                pD[3] = 1.f;
+            });
+        });
+    }
+}
+
+//==================================================================
+static void benchPNG( BenchRunner &br, const DStr &tmpDir )
+{
+    constexpr u_int W = 1920;
+    constexpr u_int H = 1080;
+
+    for (u_int chans : { 3u, 4u })
+    {
+        c_auto args = SSPrintFS( "%ux%u u8x%u", W, H, chans );
+
+        c_auto doSave = br.IsSelected( "png_save", args ) ||
+                        br.IsSelected( "png_save_fast", args );
+        c_auto doLoad = br.IsSelected( "png_load", args ) ||
+                        br.IsSelected( "png_load_float", args ) ||
+                        br.IsSelected( "png_stream_float", args );
+        if ( !doSave && !doLoad )
+            continue;
+
+        c_auto oImg = makeU8Image( W, H, chans, 0 );
+        c_auto pathFName = FU_JPath( tmpDir, SSPrintFS( "bench_%u.png", chans ) );
+
+        // the file is needed by the load too
+        Image_PNGSave( *oImg, pathFName.c_str(), false );
+
+        c_auto fileSize = (size_t)std::filesystem::file_size( pathFName );
+
+        br.Run( "png_save", args, (size_t)W * H, imgBytes( *oImg ) + fileSize, [&]()
+        {
+            Image_PNGSave( *oImg, pathFName.c_str(), false );
+        });
+
+        // the quickest settings, for comparison
+        br.Run( "png_save_fast", args, (size_t)W * H, imgBytes( *oImg ) + fileSize, [&]()
+        {
+            PNGSaveParams par;
+            par.pss_level   = 1;
+            par.pss_filter  = PNGSAVE_FILTER_SUB;
+            Image_PNGSave( *oImg, pathFName.c_str(), par );
+        });
+
+        br.Run( "png_load", args, (size_t)W * H, imgBytes( *oImg ) + fileSize, [&]()
+        {
+            image img { image::LoadParams( pathFName ) };
+        });
+
+        // to float as the app wants it, through an 8 bit image or a row at a time
+        c_auto floatBytesN = (size_t)W * H * chans * sizeof(float) + fileSize;
+        br.Run( "png_load_float", args, (size_t)W * H, floatBytesN, [&]()
+        {
+            image img { image::LoadParams( pathFName ) };
+
+            image::Params par;
+            par.width   = img.mW;
+            par.height  = img.mH;
+            par.chans   = img.mChans;
+            par.depth   = img.mChans * sizeof(float) * 8;
+            par.flags   = img.mFlags | image::FLG_IS_FLOAT32;
+            image fimg( par );
+            ImageConv::ConvertFormat( img, fimg );
+        });
+
+        br.Run( "png_stream_float", args, (size_t)W * H, floatBytesN, [&]()
+        {
+            ImageAlphaStats stats;
+
+            PNGStreamParams spar;
+            spar.psp_targetFlags = image::FLG_IS_FLOAT32;
+            spar.psp_pAlphaStats = &stats;
+
+            image img;
+            Image_PNGLoadStream( img, pathFName.c_str(), spar );
+        });
+    }
+}
+
+//==================================================================
+// what the decoders get to read from, copied or mapped
+static void benchFileRead( BenchRunner &br, const DStr &tmpDir )
+{
+    constexpr size_t FILE_SIZE = 64 * 1024 * 1024;
+
+    c_auto args = SSPrintFS( "%zu MB", FILE_SIZE / (1024 * 1024) );
+
+    if ( !br.IsSelected( "file_grab", args ) && !br.IsSelected( "file_map", args ) )
+        return;
+
+    c_auto pathFName = FU_JPath( tmpDir, "bench_file.bin" );
+    {
+        DVec<U8> data( FILE_SIZE );
+        for (size_t i=0; i < data.size(); ++i)
+            data[i] = (U8)(i * 2654435761u >> 24);
+
+        DUT::SaveFile( pathFName.c_str(), data.data(), data.size() );
+    }
+
+    // touch every page, as a decoder would
+    c_auto sumPages = []( const DFileData &fd )
+    {
+        size_t sum = 0;
+        for (size_t i=0; i < fd.size(); i += 4096)
+            sum += fd[i];
+        return sum;
+    };
+
+    volatile size_t sink = 0;
+
+    br.Run( "file_grab", args, 0, FILE_SIZE, [&]()
+    {
+        DFileData fd;
+        DUT::GrabFile( pathFName.c_str(), fd );
+        sink = sink + sumPages( fd );
+    });
+
+    br.Run( "file_map", args, 0, FILE_SIZE, [&]()
+    {
+        DFileData fd;
+        DUT::MapFile( pathFName.c_str(), fd );
+        sink = sink + sumPages( fd );
+    });
+
+    std::error_code ec;
+    std::filesystem::remove( pathFName, ec );
+}
+
+//==================================================================
+static void benchEXR( BenchRunner &br, const DStr &tmpDir )
+{
+#if defined(ENABLE_OPENEXR)
+    RenderFolderParams par;
+    par.rfp_framesN = 1;
+    par.rfp_aovsN   = 3;
+    par.rfp_isHalf  = true;
+    par.rfp_format  = "exr";
+
+    c_auto W = par.rfp_w;
+    c_auto H = par.rfp_h;
+
+    c_auto args = SSPrintFS( "%ux%u f16 %u layers", W, H, par.rfp_aovsN + 1 );
+
+    c_auto doLoad  = br.IsSelected( "exr_load", args );
+    c_auto doLayer = br.IsSelected( "exr_load_layer", args );
+    if ( !doLoad && !doLayer )
+        return;
+
+    // the full frame, RGBA plus the AOVs
+    c_auto pathFName = RenderFolderGen( par ).WriteFrame( 0, tmpDir );
+    c_auto layerName = RenderFolderGen::MakeAOVName( 0 );
+
+    c_auto fileSize = (size_t)std::filesystem::file_size( pathFName );
+
+    // the header and the layers list, as when scanning a folder
+    br.Run( "exr_load", args, 0, fileSize, [&]()
+    {
+        ImageEXR_Load( pathFName, ImageSystem::DUMMY_LAYER_NAME );
+    });
+
+    // one AOV decoded and made into an image, as when switching layers
+    c_auto layerBytesN = (size_t)W * H * 3 * (sizeof(U16) + sizeof(float));
+    br.Run( "exr_load_layer", args, (size_t)W * H, layerBytesN, [&]()
+    {
+        auto oEXR = ImageEXR_Load( pathFName, ImageSystem::DUMMY_LAYER_NAME );
+        ImageEXR_LoadLayer( *oEXR, layerName );
+
+        auto *pLayer = oEXR->FindLayerByName( layerName );
+        ImageEXR_MakeImageFromLayer( *pLayer, *oEXR );
+    });
+#else
+    (void)br;
+    (void)tmpDir;
+#endif
+}
+
+//==================================================================
+static void benchDLS( BenchRunner &br )
+{
+    constexpr u_int W = 1920;
+    constexpr u_int H = 1080;
+
+    // 100 is the lossless LSS encoding, below that it's the lossy LOS
+    for (u_int quality : { 100u, 90u })
+    for (u_int chans : { 3u, 4u })
+    {
+        c_auto args = SSPrintFS( "%ux%u u8x%u %s q=%u",
+                            W, H, chans, quality == 100 ? "lss" : "los", quality );
+
+        c_auto doEnc = br.IsSelected( "dls_encode", args );
+        c_auto doDec = br.IsSelected( "dls_decode", args );
+        if ( !doEnc && !doDec )
+            continue;
+
+        c_auto oImg = makeU8Image( W, H, chans, 0 );
+
+        DUT::MemWriterDynamic mwEnc;
+        ImgDLS::SaveDLS( *oImg, mwEnc, quality );
+
+        c_auto bytesN = imgBytes( *oImg ) + mwEnc.GetCurSize();
+
+        br.Run( "dls_encode", args, (size_t)W * H, bytesN, [&]()
+        {
+            DUT::MemWriterDynamic mw;
+            ImgDLS::SaveDLS( *oImg, mw, quality );
+        });
+
+        br.Run( "dls_decode", args, (size_t)W * H, bytesN, [&]()
+        {
+            DUT::MemReader mr( mwEnc.GetDataBegin(), mwEnc.GetCurSize() );
+            image img;
+            ImgDLS::LoadDLS( img, 0, 0, 0, mr, nullptr );
+        });
+    }
+}
+
+//==================================================================
+static void benchDLZ2( BenchRunner &br )
+{
+    constexpr u_int W = 1920;
+    constexpr u_int H = 1080;
+
+    c_auto args = SSPrintFS( "%ux%u u8x4", W, H );
+
+    if ( !br.IsSelected( "dlz2_compress", args ) && !br.IsSelected( "dlz2_expand", args ) )
+        return;
+
+    c_auto oImg = makeU8Image( W, H, 4, 0 );
+    c_auto *pSrc = oImg->GetPixelPtr( 0, 0 );
+    c_auto srcSize = imgBytes( *oImg );
+
+    DUT::MemWriterDynamic mwComp;
+    DLZ2_Compress( mwComp, pSrc, srcSize );
+
+    c_auto bytesN = srcSize + mwComp.GetCurSize();
+
+    br.Run( "dlz2_compress", args, (size_t)W * H, bytesN, [&]()
+    {
+        DUT::MemWriterDynamic mw;
+        DLZ2_Compress( mw, pSrc, srcSize );
+    });
+
+    br.Run( "dlz2_expand", args, (size_t)W * H, bytesN, [&]()
+    {
+        DUT::MemWriterDynamic mw;
+        DLZ2_Expand( mw, srcSize, mwComp.GetDataBegin(), mwComp.GetCurSize() );
+    });
+}
+
+//==================================================================
+static void runMicroBenchmarks( const BenchArgs &args )
+{
+    BenchRunner br( args.ba_runPar );
+
+    benchComposite( br );
+    benchColorCorr( br );
+    benchBlit( br );
+    benchFileRead( br, args.ba_tmpDir );
+    benchPNG( br, args.ba_tmpDir );
+    benchEXR( br, args.ba_tmpDir );
+    benchDLS( br );
+    benchDLZ2( br );
+
+    if NOT( args.ba_jsonPathFName.empty() )
+        br.SaveJSON( args.ba_jsonPathFName );
+}
+
+//==================================================================
+static void runScenario( const BenchArgs &args )
+{
+    ScenarioRunner runner( args.ba_scenPar );
+
+    runner.Run();
+
+    runner.GetStats().Print();
+
+    if NOT( args.ba_jsonPathFName.empty() )
+        runner.GetStats().SaveJSON( args.ba_jsonPathFName );
+}
+
+//==================================================================
+int main( int argc, const char* argv[] )
+{
+    c_auto args = parseArgs( argc, argv );
+
+    if NOT( FU_CreateDirectories( args.ba_tmpDir ) || FU_DirectoryExists( args.ba_tmpDir ) )
+    {
+        printf( "Could not create %s\n", args.ba_tmpDir.c_str() );
+        return -1;
+    }
+
+    LogCreate( "xcomp_bench", FU_JPath( args.ba_tmpDir, "logs" ) );
+
+    try
+    {
+        if ( args.ba_mode == "gen" )
+            RenderFolderGen( args.ba_genPar ).WriteAll( args.ba_dir );
+        else
+        if ( args.ba_mode == "scenario" )
+            runScenario( args );
+        else
+            runMicroBenchmarks( args );
+    }
+    catch (const std::exception& ex)
+    {
+        LogOut( LOG_ERR, "Uncaught Exception: %s", ex.what() );
+        return -1;
+    }
+
+	return 0;
+}
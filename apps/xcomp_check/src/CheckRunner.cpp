@@ -0,0 +1,49 @@
+//==================================================================
+/// CheckRunner.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "DLogOut.h"
+#include "CheckRunner.h"
+
+//==================================================================
+bool CheckRunner::BeginGroup( const DStr &name )
+{
+    if ( !mFilter.empty() && name.find( mFilter ) == DStr::npos )
+        return false;
+
+    mCurGroup = name;
+    LogOut( 0, "Checking %s", name.c_str() );
+    return true;
+}
+
+//==================================================================
+bool CheckRunner::Check( bool isOK, const char *pExpr, const char *pFile, int line )
+{
+    return CheckF( isOK, pFile, line, "%s", pExpr );
+}
+
+//==================================================================
+bool CheckRunner::CheckF( bool isOK, const char *pFile, int line, const char *pFmt, ... )
+{
+    ++mChecksN;
+
+    if ( isOK )
+        return true;
+
+    ++mFailsN;
+
+    char buff[1024];
+    va_list vl;
+    va_start( vl, pFmt );
+    vsnprintf( buff, sizeof(buff), pFmt, vl );
+    va_end( vl );
+
+    LogOut( LOG_ERR, "FAILED [%s] %s (%s:%i)", mCurGroup.c_str(), buff, pFile, line );
+    return false;
+}
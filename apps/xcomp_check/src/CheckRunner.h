@@ -0,0 +1,45 @@
+//==================================================================
+/// CheckRunner.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef CHECKRUNNER_H
+#define CHECKRUNNER_H
+
+#include "DBase.h"
+#include "DContainers.h"
+
+//==================================================================
+// Counts the checks of each group, and prints the ones that fail.
+//==================================================================
+class CheckRunner
+{
+    DStr        mFilter;
+    DStr        mCurGroup;
+    size_t      mChecksN {};
+    size_t      mFailsN {};
+
+public:
+    CheckRunner( const DStr &filter={} ) : mFilter(filter) {}
+
+    // false if the filter leaves it out
+    bool BeginGroup( const DStr &name );
+
+    bool Check( bool isOK, const char *pExpr, const char *pFile, int line );
+    bool CheckF( bool isOK, const char *pFile, int line, const char *pFmt, ... );
+
+    size_t GetChecksN() const { return mChecksN; }
+    size_t GetFailsN() const { return mFailsN; }
+};
+
+#define XC_CHECK( _CR_, _COND_ ) \
+    (_CR_).Check( !!(_COND_), #_COND_, __FILE__, __LINE__ )
+
+// with a message, for checks in loops
+#define XC_CHECKF( _CR_, _COND_, ... ) \
+    (_CR_).CheckF( !!(_COND_), __FILE__, __LINE__, __VA_ARGS__ )
+
+#endif
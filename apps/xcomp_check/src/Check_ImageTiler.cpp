@@ -0,0 +1,151 @@
+//==================================================================
+/// Check_ImageTiler.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <cmath>
+#include "ImageTiler.h"
+#include "Checks.h"
+
+//==================================================================
+static bool isNear( double a, double b )
+{
+    return std::abs( a - b ) < 1e-6;
+}
+
+//==================================================================
+static DVec<ImageTiler::Tile> calcVis( const ImageTiler &tiler, const Double4 &rc )
+{
+    DVec<ImageTiler::Tile> tiles;
+    tiler.CalcVisibleTiles( tiles, rc );
+    return tiles;
+}
+
+//==================================================================
+// the partial tiles of the last row and column
+static void checkPartialTiles( CheckRunner &cr )
+{
+    ImageTiler tiler( 256 );
+    tiler.Setup( 1000, 600, 0, 1000, 600 );
+
+    XC_CHECK( cr, tiler.GetTilesW() == 4 && tiler.GetTilesH() == 3 );
+
+    c_auto t = tiler.MakeTile( 3, 2 );
+    XC_CHECK( cr, t.tl_x == 768 && t.tl_w == 232 );
+    XC_CHECK( cr, t.tl_y == 512 && t.tl_h == 88 );
+    XC_CHECK( cr, isNear( t.tl_fullRC[0] + t.tl_fullRC[2], 1000 ) );
+    XC_CHECK( cr, isNear( t.tl_fullRC[1] + t.tl_fullRC[3], 600 ) );
+
+    // the whole image, row by row
+    c_auto all = calcVis( tiler, { 0, 0, 1000, 600 } );
+    XC_CHECK( cr, all.size() == 12 );
+    for (size_t i=0; i < all.size(); ++i)
+        XC_CHECKF( cr, all[i].tl_tx == i % 4 && all[i].tl_ty == i / 4, "order at %zu", i );
+
+    // a larger view is the same
+    XC_CHECK( cr, calcVis( tiler, { -500, -500, 3000, 3000 } ).size() == 12 );
+
+    // the last pixel
+    c_auto last = calcVis( tiler, { 999, 599, 1, 1 } );
+    XC_CHECK( cr, last.size() == 1 && last[0].tl_tx == 3 && last[0].tl_ty == 2 );
+
+    // the edge between two tiles belongs to the second one
+    c_auto edge = calcVis( tiler, { 256, 0, 1, 1 } );
+    XC_CHECK( cr, edge.size() == 1 && edge[0].tl_tx == 1 );
+
+    // up to the edge, not past it
+    XC_CHECK( cr, calcVis( tiler, { 0, 0, 256, 1 } ).size() == 1 );
+    XC_CHECK( cr, calcVis( tiler, { 0, 0, 257, 1 } ).size() == 2 );
+}
+
+//==================================================================
+static void checkOutside( CheckRunner &cr )
+{
+    ImageTiler tiler( 256 );
+    tiler.Setup( 1000, 600, 0, 1000, 600 );
+
+    // past the partial tiles, which the grid still covers
+    XC_CHECK( cr, calcVis( tiler, { 1010, 0, 10, 10 } ).empty() );
+    XC_CHECK( cr, calcVis( tiler, { 0, 610, 10, 10 } ).empty() );
+
+    // touching an edge from outside
+    XC_CHECK( cr, calcVis( tiler, { 1000, 0, 10, 10 } ).empty() );
+    XC_CHECK( cr, calcVis( tiler, { -10, 0, 10, 10 } ).empty() );
+    XC_CHECK( cr, calcVis( tiler, { 0, -10, 10, 10 } ).empty() );
+
+    // far away
+    XC_CHECK( cr, calcVis( tiler, { 5000, 5000, 100, 100 } ).empty() );
+    XC_CHECK( cr, calcVis( tiler, { -5000, -5000, 100, 100 } ).empty() );
+
+    // no area
+    XC_CHECK( cr, calcVis( tiler, { 10, 10, 0, 10 } ).empty() );
+    XC_CHECK( cr, calcVis( tiler, { 10, 10, 10, -10 } ).empty() );
+
+    // nothing set up
+    ImageTiler empty( 256 );
+    XC_CHECK( cr, calcVis( empty, { 0, 0, 100, 100 } ).empty() );
+}
+
+//==================================================================
+// a level of an odd size, rounded down from the full one
+static void checkRoundedLevel( CheckRunner &cr )
+{
+    ImageTiler tiler( 256 );
+    tiler.Setup( 1001, 601, 1, 500, 300 );
+
+    XC_CHECK( cr, tiler.GetTilesW() == 2 && tiler.GetTilesH() == 2 );
+
+    // the tiles still span the full image
+    c_auto t = tiler.MakeTile( 1, 1 );
+    XC_CHECK( cr, t.tl_level == 1 );
+    XC_CHECK( cr, t.tl_w == 244 && t.tl_h == 44 );
+    XC_CHECK( cr, isNear( t.tl_fullRC[0] + t.tl_fullRC[2], 1001 ) );
+    XC_CHECK( cr, isNear( t.tl_fullRC[1] + t.tl_fullRC[3], 601 ) );
+
+    // the last full pixel is in the last tile
+    c_auto last = calcVis( tiler, { 1000, 600, 1, 1 } );
+    XC_CHECK( cr, last.size() == 1 && last[0].tl_tx == 1 && last[0].tl_ty == 1 );
+
+    // the edge between the tiles is at 256 * 1001 / 500 = 512.512
+    XC_CHECK( cr, calcVis( tiler, { 0, 0, 512, 1 } ).size() == 1 );
+    XC_CHECK( cr, calcVis( tiler, { 0, 0, 513, 1 } ).size() == 2 );
+
+    XC_CHECK( cr, calcVis( tiler, { 0, 0, 1001, 601 } ).size() == 4 );
+
+    // the keys tell the levels and the positions apart
+    XC_CHECK( cr, ImageTiler::MakeKey( 1, 2, 3 ) != ImageTiler::MakeKey( 1, 3, 2 ) );
+    XC_CHECK( cr, ImageTiler::MakeKey( 0, 1, 1 ) != ImageTiler::MakeKey( 1, 1, 1 ) );
+}
+
+//==================================================================
+static void checkLevelForScale( CheckRunner &cr )
+{
+    // a level is used when it still has a pixel per screen pixel
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 1.0,  8 ) == 0 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 4.0,  8 ) == 0 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 0.5,  8 ) == 1 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 0.51, 8 ) == 0 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 0.25, 8 ) == 2 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 0.26, 8 ) == 1 );
+
+    // up to the last level
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 1.0 / 256, 8 ) == 8 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 1e-6, 8 ) == 8 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 1e-6, 0 ) == 0 );
+    XC_CHECK( cr, ImageTiler::CalcLevelForScale( 0.25, 1 ) == 1 );
+}
+
+//==================================================================
+void CheckImageTiler( CheckRunner &cr )
+{
+    if NOT( cr.BeginGroup( "image_tiler" ) )
+        return;
+
+    checkPartialTiles( cr );
+    checkOutside( cr );
+    checkRoundedLevel( cr );
+    checkLevelForScale( cr );
+}
@@ -0,0 +1,237 @@
+//==================================================================
+/// Check_PNGSave.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <math.h>
+#include <string.h>
+#include <filesystem>
+#include "StringUtils.h"
+#include "FileUtils.h"
+#include "Image.h"
+#include "ImageConv.h"
+#include "Image_PNG.h"
+#include "Checks.h"
+
+//==================================================================
+// tall enough that every format is split in a few bands, see
+//  PNGSAVE_BAND_BYTES, and an odd width for the filters' edges
+static constexpr u_int PNGCHK_W = 301;
+static constexpr u_int PNGCHK_H = 2500;
+
+//==================================================================
+// gradients with some grain, so that all the filters have work to do
+static uptr<image> pngcMakeImage( u_int w, u_int h, u_int chans, ImageConv::ChanType ct )
+{
+    image::Params par;
+    par.width   = w;
+    par.height  = h;
+    par.chans   = chans;
+    par.depth   = chans * (u_int)ImageConv::GetChanTypeSize( ct ) * 8;
+    par.flags   = ct == ImageConv::CHANTYPE_F32 ? image::FLG_IS_FLOAT32 : 0;
+
+    auto oImg = std::make_unique<image>( par );
+
+    uint32_t seed = 1234567u + chans;
+    auto rnd = [&]()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 16;
+    };
+
+    for (u_int y=0; y < h; ++y)
+    {
+        auto *pRow = oImg->GetPixelPtr( 0, y );
+        for (u_int x=0; x < w; ++x)
+        {
+            for (u_int c=0; c < chans; ++c)
+            {
+                c_auto grad = (x * (c + 1) + y * 3) & 0xff;
+                c_auto grain = (int)(rnd() & 7) - 4;
+                c_auto v8 = (u_int)std::clamp( (int)grad + grain, 0, 255 );
+                c_auto i = (size_t)x * chans + c;
+
+                switch ( ct )
+                {
+                case ImageConv::CHANTYPE_U8:
+                    pRow[i] = (U8)v8;
+                    break;
+
+                case ImageConv::CHANTYPE_U16:
+                    ((U16 *)pRow)[i] = (U16)(v8 << 8 | (rnd() & 0xff));
+                    break;
+
+                case ImageConv::CHANTYPE_F32:
+                    // some out of range, the rest off the 8 bit steps,
+                    //  but far from the rounding point
+                    if ( (x + y + c) % 97 == 0 )
+                        ((float *)pRow)[i] = (x & 1) ? 1.7f : -0.3f;
+                    else
+                        ((float *)pRow)[i] = (v8 + (float)(rnd() & 7) / 32.f) / 255.f;
+                    break;
+
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
+    return oImg;
+}
+
+//==================================================================
+// what the file should hold for a row of the source: the same for the
+//  integer formats, 8 bit clamped and rounded for float
+static void pngcMakeExpectedRow( DVec<U8> &out_row, const image &src, u_int y )
+{
+    c_auto ct = ImageConv::GetChanType( src );
+    c_auto n = (size_t)src.mW * src.mChans;
+    c_auto *pSrc = src.GetPixelPtr( 0, y );
+
+    if ( ct == ImageConv::CHANTYPE_F32 )
+    {
+        out_row.resize( n );
+        for (size_t i=0; i < n; ++i)
+        {
+            c_auto v = ((const float *)pSrc)[i] * 255.f;
+            out_row[i] = (U8)std::clamp( (int)lrintf( v ), 0, 255 );
+        }
+    }
+    else
+    {
+        c_auto bytesN = n * ImageConv::GetChanTypeSize( ct );
+        out_row.assign( pSrc, pSrc + bytesN );
+    }
+}
+
+//==================================================================
+static void pngcRoundTrip(
+            CheckRunner &cr,
+            const DStr &tmpDir,
+            const image &src,
+            const PNGSaveParams &par,
+            const DStr &tag )
+{
+    c_auto pathFName = FU_JPath( tmpDir, "png_" + tag + ".png" );
+
+    image loaded;
+    try {
+        Image_PNGSave( src, pathFName.c_str(), par );
+        Image_PNGLoad( loaded, 0, pathFName.c_str() );
+    }
+    catch ( const std::exception &ex )
+    {
+        XC_CHECKF( cr, false, "%s: %s", tag.c_str(), ex.what() );
+        return;
+    }
+
+    c_auto isFloat = src.IsFloat32();
+    c_auto expDepth = isFloat ? src.mChans * 8 : src.mDepth;
+
+    if NOT( XC_CHECKF( cr,
+                loaded.mW == src.mW && loaded.mH == src.mH &&
+                loaded.mChans == src.mChans && loaded.mDepth == expDepth &&
+                !loaded.IsFloat32(),
+                "%s: loaded as %ux%u, %u chans, depth %u",
+                tag.c_str(), loaded.mW, loaded.mH, loaded.mChans, loaded.mDepth ) )
+        return;
+
+    DVec<U8> expRow;
+    for (u_int y=0; y < src.mH; ++y)
+    {
+        c_auto srcY = par.pss_flipY ? src.mH-1 - y : y;
+        pngcMakeExpectedRow( expRow, src, srcY );
+
+        c_auto *pLoaded = loaded.GetPixelPtr( 0, y );
+        if ( memcmp( pLoaded, expRow.data(), expRow.size() ) != 0 )
+        {
+            size_t i = 0;
+            while ( pLoaded[i] == expRow[i] )
+                ++i;
+
+            XC_CHECKF( cr, false, "%s: differs at row %u, byte %zu (%u instead of %u)",
+                            tag.c_str(), y, i, pLoaded[i], expRow[i] );
+            return;
+        }
+    }
+
+    XC_CHECK( cr, true );
+
+    // the files of the failed ones are left to look at
+    std::error_code ec;
+    std::filesystem::remove( pathFName, ec );
+}
+
+//==================================================================
+void CheckPNGSave( CheckRunner &cr, const DStr &tmpDir )
+{
+    if NOT( cr.BeginGroup( "png_save" ) )
+        return;
+
+    struct Fmt
+    {
+        u_int               chans;
+        ImageConv::ChanType ct;
+        const char          *pName;
+    };
+    static const Fmt sFmts[] =
+    {
+        { 1, ImageConv::CHANTYPE_U8,  "u8x1"  },
+        { 2, ImageConv::CHANTYPE_U8,  "u8x2"  },
+        { 3, ImageConv::CHANTYPE_U8,  "u8x3"  },
+        { 4, ImageConv::CHANTYPE_U8,  "u8x4"  },
+        { 1, ImageConv::CHANTYPE_U16, "u16x1" },
+        { 3, ImageConv::CHANTYPE_F32, "f32x3" },
+        { 4, ImageConv::CHANTYPE_F32, "f32x4" },
+    };
+
+    static const PNGSaveFilter sFilters[] =
+    {
+        PNGSAVE_FILTER_NONE,
+        PNGSAVE_FILTER_SUB,
+        PNGSAVE_FILTER_UP,
+        PNGSAVE_FILTER_AVERAGE,
+        PNGSAVE_FILTER_PAETH,
+        PNGSAVE_FILTER_ADAPTIVE,
+    };
+
+    for (c_auto &fmt : sFmts)
+    {
+        c_auto oSrc = pngcMakeImage( PNGCHK_W, PNGCHK_H, fmt.chans, fmt.ct );
+
+        for (c_auto filter : sFilters)
+        {
+            PNGSaveParams par;
+            par.pss_filter = filter;
+            pngcRoundTrip( cr, tmpDir, *oSrc, par,
+                    SSPrintFS( "%s_%s", fmt.pName, Image_PNGSaveFilterName( filter ) ) );
+        }
+
+        // stored blocks, and the slowest
+        for (c_auto level : { 0, 9 })
+        {
+            PNGSaveParams par;
+            par.pss_level = level;
+            pngcRoundTrip( cr, tmpDir, *oSrc, par, SSPrintFS( "%s_level%i", fmt.pName, level ) );
+        }
+    }
+
+    // upside down
+    {
+        c_auto oSrc = pngcMakeImage( PNGCHK_W, PNGCHK_H, 4, ImageConv::CHANTYPE_U8 );
+        PNGSaveParams par;
+        par.pss_flipY = true;
+        pngcRoundTrip( cr, tmpDir, *oSrc, par, "u8x4_flip" );
+    }
+
+    // a single pixel, and a single row wider than a band
+    for (c_auto &[w, h] : { std::pair<u_int,u_int>{ 1, 1 }, { 140000, 1 } })
+    {
+        c_auto oSrc = pngcMakeImage( w, h, 4, ImageConv::CHANTYPE_U8 );
+        pngcRoundTrip( cr, tmpDir, *oSrc, {}, SSPrintFS( "u8x4_%ux%u", w, h ) );
+    }
+}
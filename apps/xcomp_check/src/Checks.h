@@ -0,0 +1,18 @@
+//==================================================================
+/// Checks.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef CHECKS_H
+#define CHECKS_H
+
+#include "CheckRunner.h"
+
+void CheckImageTiler( CheckRunner &cr );
+// save, load back with the libpng decoder, compare
+void CheckPNGSave( CheckRunner &cr, const DStr &tmpDir );
+
+#endif
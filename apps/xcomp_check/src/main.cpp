@@ -0,0 +1,120 @@
+//==================================================================
+/// main.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <stdarg.h>
+#include <string.h>
+#include <filesystem>
+
+#include "DExceptions.h"
+#include "FileUtils.h"
+#include "DLogOut.h"
+#include "Checks.h"
+
+//==================================================================
+static void printUsage( const char *pArgv0, const char *pMsg, ... )
+{
+    if ( pMsg )
+    {
+        va_list vl;
+        va_start( vl, pMsg );
+        vprintf( pMsg, vl );
+        va_end( vl );
+    }
+
+    printf(
+R"RAW(
+
+Usage:
+ %s [options]           : Checks of the imaging code, headless
+
+Options:
+ --help                 : This help
+ --filter <str>         : Run only the groups with <str> in the name
+ --tmp <dir>            : Directory for the files of the checks
+
+Exits with 1 if any check fails.
+)RAW", pArgv0 );
+}
+
+//==================================================================
+struct CheckArgs
+{
+    DStr    ca_filter;
+    DStr    ca_tmpDir;
+};
+
+//==================================================================
+static CheckArgs parseArgs( int argc, const char* argv[] )
+{
+    auto nextParam = [&]( auto &io_idx )
+    {
+        if ( ++io_idx >= argc )
+        {
+            printUsage( argv[0], "Missing parameters ?" );
+            exit( -1 );
+        }
+
+        return argv[io_idx];
+    };
+
+    CheckArgs args;
+
+	for (int i=1; i < argc; ++i)
+	{
+        auto isparam = [&]( c_auto &src ) { return !strcasecmp( argv[i], src ); };
+
+		if (isparam("--help" ))
+        {
+            printUsage( argv[0], nullptr );
+            exit( 0 );
+        }
+		else if (isparam("--filter" ))          { args.ca_filter = nextParam( i ); }
+		else if (isparam("--tmp" ))             { args.ca_tmpDir = nextParam( i ); }
+		else
+        {
+            printUsage( argv[0], "Unknown parameter %s", argv[i] );
+            exit( -1 );
+        }
+    }
+
+    if ( args.ca_tmpDir.empty() )
+        args.ca_tmpDir = FU_JPath( std::filesystem::temp_directory_path().string(), "xcomp_check" );
+
+    return args;
+}
+
+//==================================================================
+int main( int argc, const char* argv[] )
+{
+    c_auto args = parseArgs( argc, argv );
+
+    if NOT( FU_CreateDirectories( args.ca_tmpDir ) || FU_DirectoryExists( args.ca_tmpDir ) )
+    {
+        printf( "Could not create %s\n", args.ca_tmpDir.c_str() );
+        return -1;
+    }
+
+    LogCreate( "xcomp_check", FU_JPath( args.ca_tmpDir, "logs" ) );
+
+    CheckRunner cr( args.ca_filter );
+
+    try
+    {
+        CheckImageTiler( cr );
+        CheckPNGSave( cr, args.ca_tmpDir );
+    }
+    catch (const std::exception& ex)
+    {
+        LogOut( LOG_ERR, "Uncaught Exception: %s", ex.what() );
+        return -1;
+    }
+
+    LogOut( 0, "%zu checks, %zu failed", cr.GetChecksN(), cr.GetFailsN() );
+
+	return cr.GetFailsN() ? 1 : 0;
+}
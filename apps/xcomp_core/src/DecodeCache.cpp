@@ -0,0 +1,419 @@
+//==================================================================
+/// DecodeCache.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <filesystem>
+#include <thread>
+#include "DLogOut.h"
+#include "DTrace.h"
+#include "FileUtils.h"
+#include "StageTimers.h"
+#include "DecodeCache.h"
+
+//==================================================================
+static constexpr char   DCC_MAGIC[8]    = { 'X','C','D','C','A','C','H','1' };
+static constexpr size_t DCC_ALIGN       = 4096;     // of the pixels, for the mapping
+static constexpr char   DCC_EXT[]       = ".xcd";
+
+//==================================================================
+// at the start of the file, followed by the key, then the pixels
+struct DCCHeader
+{
+    char        dch_magic[8];
+    uint32_t    dch_w;
+    uint32_t    dch_h;
+    uint32_t    dch_depth;
+    uint32_t    dch_chans;
+    uint32_t    dch_flags;
+    uint32_t    dch_rowPitch;
+    uint64_t    dch_dataOffset;
+    uint64_t    dch_dataSize;
+    uint32_t    dch_keyLen;
+    uint32_t    dch_pad;
+};
+
+//==================================================================
+static int64_t dccGetNowTime()
+{
+    return (int64_t)std::filesystem::file_time_type::clock::now().time_since_epoch().count();
+}
+
+//==================================================================
+DecodeCache::DecodeCache( const DecodeCacheParams &par )
+    : mPar(par)
+{
+    std::error_code ec;
+    std::filesystem::create_directories( mPar.dcp_dir, ec );
+    if ( ec )
+        LogOut( LOG_ERR, "Could not create the decode cache dir %s", mPar.dcp_dir.c_str() );
+
+    scanDir();
+
+    std::unique_lock lock( mMutex );
+    evictOverLimit( lock );
+}
+
+//==================================================================
+// what's there from the previous runs
+void DecodeCache::scanDir()
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    for (auto it = fs::directory_iterator( mPar.dcp_dir, ec );
+              !ec && it != fs::directory_iterator(); it.increment( ec ))
+    {
+        c_auto &p = it->path();
+
+        // left over by a run that ended while storing
+        if ( p.extension() == ".tmp" )
+        {
+            std::error_code ec2;
+            fs::remove( p, ec2 );
+            continue;
+        }
+
+        if ( p.extension() != DCC_EXT )
+            continue;
+
+        std::error_code ec2;
+        c_auto siz = fs::file_size( p, ec2 );
+        if ( ec2 )
+            continue;
+
+        c_auto tim = fs::last_write_time( p, ec2 );
+        if ( ec2 )
+            continue;
+
+        auto &fi = mFiles[ p.filename().string() ];
+        fi.fi_bytes     = (size_t)siz;
+        fi.fi_lastUse   = (int64_t)tim.time_since_epoch().count();
+        mCacheBytes += fi.fi_bytes;
+    }
+
+    LogOut( 0, "Cache %s: %zu files, %.1f MB",
+                mPar.dcp_dir.c_str(), mFiles.size(), (double)mCacheBytes / (1024.0 * 1024.0) );
+}
+
+//==================================================================
+DStr DecodeCache::MakeKey( const DStr &srcPathFName, const DStr &what )
+{
+    std::error_code ec;
+    c_auto path = std::filesystem::path( srcPathFName );
+
+    c_auto siz = std::filesystem::file_size( path, ec );
+    if ( ec )
+        return {};
+
+    c_auto tim = std::filesystem::last_write_time( path, ec );
+    if ( ec )
+        return {};
+
+    return SSPrintFS( "%s|%llu|%lld|%s",
+                srcPathFName.c_str(),
+                (unsigned long long)siz,
+                (long long)tim.time_since_epoch().count(),
+                what.c_str() );
+}
+
+//==================================================================
+DStr DecodeCache::makeFileName( const DStr &key ) const
+{
+    return SSPrintFS( "%016llx%s", (unsigned long long)std::hash<DStr>{}( key ), DCC_EXT );
+}
+
+//==================================================================
+bool DecodeCache::Has( const DStr &key )
+{
+    if ( key.empty() )
+        return false;
+
+    c_auto fname = makeFileName( key );
+
+    std::lock_guard lock( mMutex );
+    return mFiles.count( fname ) != 0;
+}
+
+//==================================================================
+// the file of the key, checked and touched. Null on a miss
+uptr<DFileData> DecodeCache::mapFile( const DStr &key, DCCHeader &out_hdr )
+{
+    if ( key.empty() || !mPar.dcp_maxBytes )
+        return {};
+
+    c_auto fname = makeFileName( key );
+    c_auto pathFName = FU_JPath( mPar.dcp_dir, fname );
+
+    {
+        std::lock_guard lock( mMutex );
+        if NOT( mFiles.count( fname ) )
+        {
+            ++mStats.dcs_missesN;
+            return {};
+        }
+    }
+
+    // written to a temporary and renamed, so never truncated while mapped
+    DUT::MapFileParams mpar;
+    mpar.mfp_minAgeS = 0;
+
+    auto oData = std::make_unique<DFileData>();
+    if NOT( DUT::MapFile( pathFName.c_str(), *oData, -1, mpar ) )
+    {
+        std::lock_guard lock( mMutex );
+        dropFile( fname );
+        ++mStats.dcs_missesN;
+        return {};
+    }
+
+    // a file of another key with the same name, or damaged
+    c_auto isValid = [&]()
+    {
+        if ( oData->size() < sizeof(DCCHeader) )
+            return false;
+
+        auto &hdr = out_hdr;
+        memcpy( &hdr, oData->GetData(), sizeof(hdr) );
+
+        if ( memcmp( hdr.dch_magic, DCC_MAGIC, sizeof(DCC_MAGIC) ) ||
+             hdr.dch_keyLen != key.size() ||
+             sizeof(hdr) + hdr.dch_keyLen > oData->size() ||
+             memcmp( oData->GetData() + sizeof(hdr), key.data(), key.size() ) ||
+             hdr.dch_dataOffset + hdr.dch_dataSize > oData->size() )
+        {
+            return false;
+        }
+
+        // no channels for the files of StoreBytes()
+        if ( hdr.dch_chans &&
+                (hdr.dch_dataSize != (uint64_t)hdr.dch_rowPitch * hdr.dch_h ||
+                 !hdr.dch_w || !hdr.dch_h ||
+                 hdr.dch_rowPitch < hdr.dch_w * (hdr.dch_depth / 8)) )
+        {
+            return false;
+        }
+        return true;
+    };
+
+    if NOT( isValid() )
+    {
+        std::lock_guard lock( mMutex );
+        dropFile( fname );
+        ++mStats.dcs_missesN;
+        return {};
+    }
+
+    // most recently used, also for the next runs
+    {
+        std::lock_guard lock( mMutex );
+        if (auto it = mFiles.find( fname ); it != mFiles.end())
+            it->second.fi_lastUse = dccGetNowTime();
+        ++mStats.dcs_hitsN;
+    }
+
+    std::error_code ec;
+    std::filesystem::last_write_time(
+            pathFName, std::filesystem::file_time_type::clock::now(), ec );
+
+    return oData;
+}
+
+//==================================================================
+uptr<image> DecodeCache::Load( const DStr &key, uptr<DFileData> &out_oData )
+{
+    DTR_SCOPE( "decode_cache_load" );
+
+    DCCHeader hdr;
+    auto oData = mapFile( key, hdr );
+    if ( !oData || !hdr.dch_chans )
+        return {};
+
+    image::Params par;
+    par.width       = hdr.dch_w;
+    par.height      = hdr.dch_h;
+    par.depth       = hdr.dch_depth;
+    par.chans       = hdr.dch_chans;
+    par.flags       = hdr.dch_flags;
+    par.rowPitch    = hdr.dch_rowPitch;
+    par.pUseData    = oData->GetData() + hdr.dch_dataOffset;
+
+    auto oImg = std::make_unique<image>( par );
+    out_oData = std::move( oData );
+
+    return oImg;
+}
+
+//==================================================================
+bool DecodeCache::LoadBytes( const DStr &key, DVec<U8> &out_data )
+{
+    DCCHeader hdr;
+    auto oData = mapFile( key, hdr );
+    if ( !oData || hdr.dch_chans )
+        return false;
+
+    c_auto *pData = oData->GetData() + hdr.dch_dataOffset;
+    out_data.assign( pData, pData + hdr.dch_dataSize );
+    return true;
+}
+
+//==================================================================
+void DecodeCache::Store( const DStr &key, const image &img )
+{
+    STAGE_TIMER( "decode_cache_store" );
+
+    DCCHeader hdr {};
+    hdr.dch_w           = img.mW;
+    hdr.dch_h           = img.mH;
+    hdr.dch_depth       = img.mDepth;
+    hdr.dch_chans       = img.mChans;
+    hdr.dch_flags       = img.mFlags;
+    hdr.dch_rowPitch    = img.mBytesPerRow;
+
+    storeFile( key, hdr, DCC_ALIGN, img.GetPixelPtr( 0, 0 ), (size_t)img.mBytesPerRow * img.mH );
+}
+
+//==================================================================
+void DecodeCache::StoreBytes( const DStr &key, const void *pData, size_t size )
+{
+    // not mapped, no need to align
+    storeFile( key, DCCHeader {}, 1, pData, size );
+}
+
+//==================================================================
+void DecodeCache::storeFile(
+            const DStr &key,
+            DCCHeader hdr,
+            size_t dataAlign,
+            const void *pData,
+            size_t dataSize )
+{
+    if ( key.empty() || !mPar.dcp_maxBytes )
+        return;
+
+    c_auto dataOffset = (sizeof(DCCHeader) + key.size() + dataAlign - 1) / dataAlign * dataAlign;
+    c_auto fileBytes = dataOffset + dataSize;
+
+    if ( fileBytes > mPar.dcp_maxBytes )
+        return;
+
+    memcpy( hdr.dch_magic, DCC_MAGIC, sizeof(DCC_MAGIC) );
+    hdr.dch_dataOffset  = dataOffset;
+    hdr.dch_dataSize    = dataSize;
+    hdr.dch_keyLen      = (uint32_t)key.size();
+
+    c_auto fname = makeFileName( key );
+    c_auto pathFName = FU_JPath( mPar.dcp_dir, fname );
+
+    // written aside and renamed, readers never see it half done
+    c_auto tmpPathFName = pathFName + SSPrintFS( ".%zx.tmp",
+                std::hash<std::thread::id>{}( std::this_thread::get_id() ) );
+
+    auto *pFile = fopen( tmpPathFName.c_str(), "wb" );
+    if NOT( pFile )
+    {
+        LogOut( LOG_WRN, "Could not write %s", tmpPathFName.c_str() );
+        return;
+    }
+
+    DVec<U8> pad( dataOffset - sizeof(hdr) - key.size() );
+
+    auto ok =
+        fwrite( &hdr, sizeof(hdr), 1, pFile ) == 1 &&
+        fwrite( key.data(), 1, key.size(), pFile ) == key.size() &&
+        fwrite( pad.data(), 1, pad.size(), pFile ) == pad.size() &&
+        fwrite( pData, 1, dataSize, pFile ) == dataSize;
+
+    ok = (fclose( pFile ) == 0) && ok;
+
+    std::error_code ec;
+    if ( ok )
+        std::filesystem::rename( tmpPathFName, pathFName, ec );
+
+    if ( !ok || ec )
+    {
+        LogOut( LOG_WRN, "Could not write %s", pathFName.c_str() );
+        std::filesystem::remove( tmpPathFName, ec );
+        return;
+    }
+
+    std::unique_lock lock( mMutex );
+
+    auto &fi = mFiles[ fname ];
+    mCacheBytes -= fi.fi_bytes;
+    fi.fi_bytes     = fileBytes;
+    fi.fi_lastUse   = dccGetNowTime();
+    mCacheBytes += fileBytes;
+
+    ++mStats.dcs_storedN;
+
+    evictOverLimit( lock );
+}
+
+//==================================================================
+void DecodeCache::SetMaxBytes( size_t maxBytes )
+{
+    std::unique_lock lock( mMutex );
+    mPar.dcp_maxBytes = maxBytes;
+    evictOverLimit( lock );
+}
+
+//==================================================================
+DecodeCache::Stats DecodeCache::GetStats()
+{
+    std::lock_guard lock( mMutex );
+
+    auto stats = mStats;
+    stats.dcs_cacheBytes = mCacheBytes;
+    return stats;
+}
+
+//==================================================================
+// call with the lock. Mapped files stay readable after the removal
+void DecodeCache::dropFile( const DStr &fname )
+{
+    auto it = mFiles.find( fname );
+    if ( it == mFiles.end() )
+        return;
+
+    mCacheBytes -= it->second.fi_bytes;
+    mFiles.erase( it );
+
+    std::error_code ec;
+    std::filesystem::remove( FU_JPath( mPar.dcp_dir, fname ), ec );
+}
+
+//==================================================================
+// the least recently used go first. The files are removed without the
+//  lock, it's held again on return
+void DecodeCache::evictOverLimit( std::unique_lock<std::mutex> &lock )
+{
+    DVec<DStr> pathFNames;
+    while ( mCacheBytes > mPar.dcp_maxBytes && !mFiles.empty() )
+    {
+        auto itOldest = mFiles.begin();
+        for (auto it = mFiles.begin(); it != mFiles.end(); ++it)
+            if ( it->second.fi_lastUse < itOldest->second.fi_lastUse )
+                itOldest = it;
+
+        pathFNames.push_back( FU_JPath( mPar.dcp_dir, itOldest->first ) );
+        mCacheBytes -= itOldest->second.fi_bytes;
+        mFiles.erase( itOldest );
+        ++mStats.dcs_evictedN;
+    }
+
+    if ( pathFNames.empty() )
+        return;
+
+    lock.unlock();
+
+    std::error_code ec;
+    for (c_auto &pathFName : pathFNames)
+        std::filesystem::remove( pathFName, ec );
+
+    lock.lock();
+}
+
@@ -0,0 +1,101 @@
+//==================================================================
+/// DecodeCache.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef DECODECACHE_H
+#define DECODECACHE_H
+
+#include <mutex>
+#include <unordered_map>
+#include "Image.h"
+#include "DUT_Files.h"
+
+//==================================================================
+struct DecodeCacheParams
+{
+    DStr    dcp_dir;                                            // created if needed
+    size_t  dcp_maxBytes    { (size_t)8 * 1024 * 1024 * 1024 }; // 0 to turn it off
+};
+
+struct DCCHeader;
+
+//==================================================================
+// Decoded images kept on disk across runs, one file each. The pixels
+//  are stored as they are in the image, after a header, at a page
+//  aligned offset, so that a hit is a mapping of the file with the
+//  image pointing into it, with nothing to decode or copy.
+// Keys are of the source file, its size and time, and of what was
+//  made of it, see MakeKey(). A changed source is a miss.
+// Other data can go in as plain bytes, see StoreBytes().
+// Past the size limit, the least recently used files go. The times of
+//  the files keep that order across runs.
+//==================================================================
+class DecodeCache
+{
+public:
+    struct Stats
+    {
+        size_t  dcs_hitsN {};
+        size_t  dcs_missesN {};
+        size_t  dcs_storedN {};
+        size_t  dcs_evictedN {};
+        size_t  dcs_cacheBytes {};
+    };
+
+private:
+    struct FileInfo
+    {
+        size_t  fi_bytes {};
+        int64_t fi_lastUse {};
+    };
+
+    DecodeCacheParams                       mPar;
+
+    std::mutex                              mMutex;
+    std::unordered_map<DStr,FileInfo>       mFiles;     // by file name
+    size_t                                  mCacheBytes {};
+    Stats                                   mStats;
+
+public:
+    DecodeCache( const DecodeCacheParams &par );
+
+    // for an image made from srcPathFName, what is the layer or any
+    //  other variant. Empty if the source can't be found
+    static DStr MakeKey( const DStr &srcPathFName, const DStr &what );
+
+    // the image views the data of the mapped file, which must be kept
+    //  for as long as the image. Null on a miss
+    uptr<image> Load( const DStr &key, uptr<DFileData> &out_oData );
+    bool Has( const DStr &key );
+    // any thread. Failures are logged and otherwise ignored
+    void Store( const DStr &key, const image &img );
+
+    // for data that isn't an image as it is, i.e. encoded
+    bool LoadBytes( const DStr &key, DVec<U8> &out_data );
+    void StoreBytes( const DStr &key, const void *pData, size_t size );
+
+    // evicts what's over it
+    void SetMaxBytes( size_t maxBytes );
+
+    Stats GetStats();
+
+private:
+    DStr makeFileName( const DStr &key ) const;
+    void scanDir();
+    uptr<DFileData> mapFile( const DStr &key, DCCHeader &out_hdr );
+    void storeFile(
+            const DStr &key,
+            DCCHeader hdr,
+            size_t dataAlign,
+            const void *pData,
+            size_t dataSize );
+    void dropFile( const DStr &fname );
+    void evictOverLimit( std::unique_lock<std::mutex> &lock );
+};
+
+#endif
+
@@ -0,0 +1,164 @@
+//==================================================================
+/// ExportQueue.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include "DLogOut.h"
+#include "TimeUtils.h"
+#include "StageTimers.h"
+#include "ExportQueue.h"
+
+//==================================================================
+ExportQueue::ExportQueue()
+{
+    mThread = std::thread( [this](){ threadLoop(); } );
+}
+
+//==================================================================
+ExportQueue::~ExportQueue()
+{
+    WaitIdle();
+
+    {
+        std::lock_guard lock( mMutex );
+        mIsQuitting = true;
+    }
+    mCV.notify_all();
+
+    mThread.join();
+}
+
+//==================================================================
+u_int ExportQueue::AddPNGJob( uptr<image> oImage, const DStr &pathFName, const PNGSaveParams &par )
+{
+    // shared, for the function to be copyable
+    sptr<image> sImage( std::move( oImage ) );
+
+    return AddJob( pathFName, [sImage, pathFName, par]( c_auto &onProgressFn )
+    {
+        STAGE_TIMER( "png_save" );
+
+        auto usePar = par;
+        usePar.pss_onProgressFn = onProgressFn;
+        Image_PNGSave( *sImage, pathFName.c_str(), usePar );
+    });
+}
+
+//==================================================================
+u_int ExportQueue::AddJob( const DStr &pathFName, SaveFn saveFn )
+{
+    u_int id {};
+    {
+        std::lock_guard lock( mMutex );
+
+        id = ++mLastJobID;
+
+        Job job;
+        job.jo_status.js_id         = id;
+        job.jo_status.js_pathFName  = pathFName;
+        job.jo_saveFn               = std::move( saveFn );
+        mJobs.push_back( std::move( job ) );
+    }
+    mCV.notify_all();
+
+    return id;
+}
+
+//==================================================================
+DVec<ExportQueue::JobStatus> ExportQueue::GetStatus()
+{
+    std::lock_guard lock( mMutex );
+
+    DVec<JobStatus> out( mHistory.begin(), mHistory.end() );
+    for (c_auto &job : mJobs)
+    {
+        out.push_back( job.jo_status );
+        if ( job.jo_status.js_state == STATE_SAVING )
+            out.back().js_progress = mCurProgress;
+    }
+
+    return out;
+}
+
+//==================================================================
+bool ExportQueue::IsBusy()
+{
+    std::lock_guard lock( mMutex );
+    return !mJobs.empty();
+}
+
+//==================================================================
+void ExportQueue::WaitIdle()
+{
+    std::unique_lock lock( mMutex );
+    mCV.wait( lock, [this](){ return mJobs.empty(); } );
+}
+
+//==================================================================
+void ExportQueue::threadLoop()
+{
+    LogSetThreadName( "export" );
+
+    std::unique_lock lock( mMutex );
+
+    for (;;)
+    {
+        mCV.wait( lock, [this](){ return mIsQuitting || !mJobs.empty(); } );
+        if ( mJobs.empty() )
+            return;
+
+        // the job stays in the queue while saving, so that it shows
+        auto &job = mJobs.front();
+        job.jo_status.js_state = STATE_SAVING;
+        mCurProgress = 0.f;
+
+        c_auto onProgressFn = [this]( size_t doneN, size_t totN )
+        {
+            mCurProgress = (float)doneN / (float)totN;
+            if ( mOnProgressFn )
+                mOnProgressFn();
+        };
+
+        c_auto &saveFn = job.jo_saveFn;
+        c_auto pathFName = job.jo_status.js_pathFName;
+        lock.unlock();
+
+        LogOut( 0, "Saving %s", pathFName.c_str() );
+
+        c_auto t0 = GetSteadyTimeS();
+        auto isOK = true;
+        try {
+            saveFn( onProgressFn );
+        } catch (...)
+        {
+            LogOut( LOG_ERR, "Failed to save %s", pathFName.c_str() );
+            isOK = false;
+        }
+        c_auto saveS = GetSteadyTimeS() - t0;
+
+        lock.lock();
+
+        auto status = mJobs.front().jo_status;
+        status.js_state     = isOK ? STATE_DONE : STATE_FAILED;
+        status.js_progress  = 1.f;
+        status.js_saveS     = saveS;
+
+        mHistory.push_back( status );
+        if ( mHistory.size() > HISTORY_N )
+            mHistory.pop_front();
+
+        mJobs.pop_front();
+        mCV.notify_all();
+
+        if ( mOnProgressFn )
+        {
+            lock.unlock();
+            mOnProgressFn();
+            lock.lock();
+        }
+    }
+}
+
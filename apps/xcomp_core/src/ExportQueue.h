@@ -0,0 +1,89 @@
+//==================================================================
+/// ExportQueue.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef EXPORTQUEUE_H
+#define EXPORTQUEUE_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include "Image.h"
+#include "Image_PNG.h"
+
+//==================================================================
+// Saves images on a thread of its own, one job at a time, so that
+//  the caller only pays for the snapshot that it hands over.
+//==================================================================
+class ExportQueue
+{
+public:
+    enum State : u_int
+    {
+        STATE_QUEUED,
+        STATE_SAVING,
+        STATE_DONE,
+        STATE_FAILED,
+    };
+
+    struct JobStatus
+    {
+        u_int       js_id {};
+        DStr        js_pathFName;
+        State       js_state { STATE_QUEUED };
+        float       js_progress {};     // 0 to 1, while saving
+        double      js_saveS {};        // once done
+    };
+
+    // does the saving of a job, reporting as it goes
+    using SaveFn = DFun<void (const DFun<void (size_t doneN, size_t totN)> &onProgressFn)>;
+
+    // called from the saving thread as the jobs go on
+    DFun<void ()>   mOnProgressFn;
+
+private:
+    static constexpr size_t HISTORY_N = 8;
+
+    struct Job
+    {
+        JobStatus       jo_status;
+        SaveFn          jo_saveFn;
+    };
+
+    std::thread                 mThread;
+    std::mutex                  mMutex;
+    std::condition_variable     mCV;
+    std::deque<Job>             mJobs;          // the first is being saved
+    std::deque<JobStatus>       mHistory;       // of the latest done, oldest first
+    std::atomic<float>          mCurProgress {};
+    u_int                       mLastJobID {};
+    bool                        mIsQuitting {};
+
+public:
+    ExportQueue();
+    // saves what's still queued before returning
+    ~ExportQueue();
+
+    // takes the image, returns the ID of the job
+    u_int AddPNGJob( uptr<image> oImage, const DStr &pathFName, const PNGSaveParams &par );
+    // for other formats. The function owns what it saves
+    u_int AddJob( const DStr &pathFName, SaveFn saveFn );
+
+    // done, saving and queued, oldest first
+    DVec<JobStatus> GetStatus();
+
+    bool IsBusy();
+    void WaitIdle();
+
+private:
+    void threadLoop();
+};
+
+#endif
+
@@ -0,0 +1,2721 @@
+//==================================================================
+/// ImageSystem.cpp
+///
+/// Created by Davide Pasca - 2022/01/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include "DLogOut.h"
+#include "DThreads.h"
+#include "ImageTiler.h"
+#include "TimeUtils.h"
+#include "StageTimers.h"
+#include "DTrace.h"
+#include "FileUtils.h"
+#include "SerializeJS.h"
+#include "ImageConv.h"
+#include "Image_PNG.h"
+#include "Image_EXR.h"
+#include "Image_DLS.h"
+#include "ImageSystemOCIO.h"
+#include "ImageSystem.h"
+
+//==================================================================
+void IMSConfig::Serialize( SerialJS &v_ ) const
+{
+    v_.MSerializeObjectStart();
+    SERIALIZE_THIS_MEMBER( v_, imsc_useBilinear             );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorRGBOnly             );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorSRGB                );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorXform               );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOCfgFName        );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOCfgFNameHist    );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIODisp            );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOView            );
+    SERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOLook            );
+    SERIALIZE_THIS_MEMBER( v_, imsc_texUploadFmt            );
+    v_.MSerializeObjectEnd();
+}
+
+void IMSConfig::Deserialize( DeserialJS &v_ )
+{
+    DESERIALIZE_THIS_MEMBER( v_, imsc_useBilinear           );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorRGBOnly           );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorSRGB              );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorXform             );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOCfgFName      );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOCfgFNameHist  );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIODisp          );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOView          );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_ccorOCIOLook          );
+    DESERIALIZE_THIS_MEMBER( v_, imsc_texUploadFmt          );
+
+    // remove empty or unreachable files
+    auto &h = imsc_ccorOCIOCfgFNameHist;
+    for (auto it=h.begin(); it != h.end();)
+    {
+        if ( it->empty() || !FU_FileExists( *it ) )
+            it = h.erase( it );
+        else
+            ++it;
+    }
+}
+
+//==================================================================
+void IMSConfig::SetOCIOFName( const DStr &fname )
+{
+    imsc_ccorOCIOCfgFName = fname;
+    addOCIOFNameToHistory();
+}
+
+//==================================================================
+bool IMSConfig::addOCIOFNameToHistory()
+{
+    auto &v = imsc_ccorOCIOCfgFNameHist;
+    if ( !imsc_ccorOCIOCfgFName.empty() &&
+         v.end() == std::find( v.begin(), v.end(), imsc_ccorOCIOCfgFName ) )
+    {
+        // erase the oldest, if there are too many entries
+        if ( v.size() >= 10 )
+            v.erase( v.begin() );
+
+        // append the new one
+        v.push_back( imsc_ccorOCIOCfgFName );
+        return true;
+    }
+
+    return false;
+}
+
+//==================================================================
+// granularity of the empty areas that the compositing skips
+static constexpr u_int ALPHA_STATS_TILE_DIM = 64;
+
+// many reads in flight hide the latency of network storage
+static constexpr size_t PREFETCH_THREADS_N      = 8;
+static constexpr size_t PREFETCH_CACHE_BYTES    = (size_t)1024 * 1024 * 1024;
+
+//==================================================================
+ImageEntry::ImageEntry(
+            const DStr &pathFName,
+            FilePrefetcher *pPrefetcher,
+            DecodeCache *pDecodeCache )
+    : mImagePathFName(pathFName)
+{
+    LogOut( 0, "Loading %s", mImagePathFName.c_str() );
+
+    try {
+        if ( StrEndsWithI( pathFName, ".exr" ) )
+            loadEXRImage();
+        else
+            loadStdImage( pPrefetcher, pDecodeCache );
+    } catch (...)
+    {
+        LogOut( LOG_ERR, "Failed to load %s", mImagePathFName.c_str() );
+    }
+}
+
+//==================================================================
+void ImageEntry::loadStdImage( FilePrefetcher *pPrefetcher, DecodeCache *pDecodeCache )
+{
+    c_auto key = pDecodeCache ? DecodeCache::MakeKey( mImagePathFName, "" ) : DStr();
+
+    if ( pDecodeCache )
+    {
+        if (auto oImg = pDecodeCache->Load( key, moBaseImageFile ))
+        {
+            moBaseImage = std::move( oImg );
+
+            // PNGs are the ones that get the stats, see below
+            if ( StrEndsWithI( mImagePathFName, ".png" ) )
+            {
+                moBaseAlphaStats = std::make_unique<ImageAlphaStats>( ALPHA_STATS_TILE_DIM );
+                moBaseAlphaStats->AddImage( *moBaseImage );
+            }
+            return;
+        }
+    }
+
+    // "decode" ends before the store, which has its own stage
+    bool isSupported {};
+    {
+        STAGE_TIMER( "decode" );
+
+        // already read, or read now by the decoder
+        uptr<DFileData> oData;
+        if ( pPrefetcher )
+            pPrefetcher->Take( mImagePathFName, oData );
+
+        uptr<image> oImg;
+
+        // PNG goes straight to float a row at a time, and the empty tiles
+        //  are found along the way
+        if ( StrEndsWithI( mImagePathFName, ".png" ) )
+        {
+            auto oStats = std::make_unique<ImageAlphaStats>( ALPHA_STATS_TILE_DIM );
+
+            PNGStreamParams spar;
+            spar.psp_targetFlags = image::FLG_IS_FLOAT32;
+            spar.psp_pAlphaStats = oStats.get();
+
+            oImg = std::make_unique<image>();
+            if ( oData )
+            {
+                spar.psp_forceAsSRGB = Image_PNG_DetectSRGBFromFileName( mImagePathFName );
+                Image_PNGLoadStream( *oImg, oData->GetData(), oData->size(), spar );
+            }
+            else
+                Image_PNGLoadStream( *oImg, mImagePathFName.c_str(), spar );
+
+            moBaseAlphaStats = std::move( oStats );
+        }
+        else
+        {
+            image::LoadParams par;
+            par.mLP_FName = mImagePathFName;
+            if ( oData )
+                par.mLP_DataSrc.assign( oData->GetData(), oData->GetData() + oData->size() );
+
+            // load
+            oImg = std::make_unique<image>( par );
+        }
+
+        c_auto chanBits = oImg->IsFloat32() ? 32 : 8;
+
+        // verify that we support the format, or replace with a dummy
+        isSupported =
+            (oImg->mChans == 3 || oImg->mChans == 4) &&
+            ((int)oImg->mDepth / (int)oImg->mChans) == chanBits;
+
+        if NOT( isSupported )
+        {
+            LogOut( LOG_ERR, "Unsupported format for %s. Should be RGB or RGBA",
+                        mImagePathFName.c_str() );
+
+            image::Params newPar;
+            newPar.width    = oImg->mW;
+            newPar.height   = oImg->mH;
+            newPar.depth    = 32;
+            newPar.chans    = 4;
+            oImg = std::make_unique<image>( newPar );
+            oImg->Clear();
+
+            moBaseAlphaStats = {};
+        }
+
+        if ( oImg->IsFloat32() )
+        {
+            moBaseImage = std::move( oImg );
+        }
+        else
+        {
+            // convert to float
+            image::Params newPar;
+            newPar.width    = oImg->mW;
+            newPar.height   = oImg->mH;
+            newPar.depth    = oImg->mChans * sizeof(float) * 8;
+            newPar.chans    = oImg->mChans;
+            newPar.flags    = oImg->mFlags | image::FLG_IS_FLOAT32;
+            moBaseImage = std::make_unique<image>( newPar );
+
+            ImageConv::ConvertFormat( *oImg, *moBaseImage );
+        }
+    }
+
+    // the dummy isn't kept, the error shows at each run
+    if ( pDecodeCache && isSupported )
+        pDecodeCache->Store( key, *moBaseImage );
+}
+
+//==================================================================
+void ImageEntry::loadEXRImage()
+{
+#ifdef ENABLE_OPENEXR
+    STAGE_TIMER( "exr_load" );
+    moEXRImage = ImageEXR_Load( mImagePathFName, ImageSystem::DUMMY_LAYER_NAME );
+#endif
+}
+
+//==================================================================
+static const image *getMipLevel(
+            const uptr<image> &oBase,
+            DVec<uptr<image>> &oMips,
+            u_int level )
+{
+    if ( !oBase || !level )
+        return oBase.get();
+
+    if ( oMips.size() < level )
+        oMips.resize( level );
+
+    // build the missing levels, each from the previous one
+    const image *pPrev = oBase.get();
+    for (u_int i=0; i < level; ++i)
+    {
+        if NOT( oMips[i] )
+        {
+            // can't go any smaller
+            if ( pPrev->mW < 2 || pPrev->mH < 2 )
+                return pPrev;
+
+            image::Params par;
+            par.FormatFromImage( *pPrev );
+            par.width  = pPrev->mW / 2;
+            par.height = pPrev->mH / 2;
+            oMips[i] = std::make_unique<image>( par );
+
+            STAGE_TIMER( "resample" );
+            ImageConv::BlitQuarter(
+                    *pPrev, 0, 0, *oMips[i], 0, 0, (int)par.width, (int)par.height );
+        }
+        pPrev = oMips[i].get();
+    }
+
+    return pPrev;
+}
+
+//==================================================================
+const image *ImageEntry::getBaseMip( u_int level )
+{
+    return getMipLevel( moBaseImage, moBaseMips, level );
+}
+
+const image *ImageEntry::getAlphaMip( u_int level )
+{
+    return getMipLevel( moAlphaImage, moAlphaMips, level );
+}
+
+//==================================================================
+void ImageEntry::resetDerivedImages()
+{
+    moBaseImageScaled = {};
+    moAlphaImageScaled = {};
+    moBaseMips.clear();
+    moAlphaMips.clear();
+}
+
+//==================================================================
+//==================================================================
+ImageSystem::ImageSystem( const IMSConfig &initCfg )
+    : mIMSCfg(initCfg)
+{
+    FilePrefetcherParams fpar;
+    fpar.fpp_threadsN       = PREFETCH_THREADS_N;
+    fpar.fpp_maxCacheBytes  = PREFETCH_CACHE_BYTES;
+    moPrefetcher = std::make_unique<FilePrefetcher>( fpar );
+
+    moExportQueue = std::make_unique<ExportQueue>();
+    moExportQueue->mOnProgressFn = [this]()
+    {
+        if ( mOnWorkDoneFn )
+            mOnWorkDoneFn();
+    };
+
+#ifdef ENABLE_OCIO
+    moIS_OCIO = std::make_unique<ImageSystemOCIO>();
+#endif
+}
+
+//
+ImageSystem::~ImageSystem()
+{
+    cancelJob();
+}
+
+//==================================================================
+bool ImageSystem::SaveComposite( const DStr &path, const PNGSaveParams &par )
+{
+    auto pathFName = FU_JPath( path, "xComp_out.png" );
+
+    if ( mSaveFuture.valid() )
+    {
+        LogOut( LOG_WRN, "The previous save is still being built" );
+        return false;
+    }
+
+    // the display gets its rebuild now, one started later cancels the save
+    if ( mHasRebuildReq )
+    {
+        mHasRebuildReq = false;
+        rebuildComposite( mDispLevel, true );
+    }
+
+    // the display may be using a reduced level, or be behind the latest
+    //  changes. The full resolution is built for the save
+    if ( mCompositeLevel != 0 || IsRebuildingComposite() )
+        return startSaveCompositeJob( pathFName, par );
+
+    try {
+        if NOT( moComposite )
+            return false;
+
+        // the queue gets a copy, the composite goes on changing. Float
+        //  is converted to 8 bit by the saver
+        uptr<image> oSnap;
+        {
+            STAGE_TIMER( "save_snapshot" );
+            // pSrcImg would copy the pixels, but not the size
+            c_auto &comp = *moComposite;
+            image::Params ipar;
+            ipar.FormatFromImage( comp );
+            ipar.width      = comp.mW;
+            ipar.height     = comp.mH;
+            ipar.rowPitch   = comp.mBytesPerRow;
+            ipar.pSrcData   = comp.GetPixelPtr( 0, 0 );
+            oSnap = std::make_unique<image>( ipar );
+        }
+
+        return moExportQueue->AddPNGJob( std::move( oSnap ), pathFName, par ) != 0;
+    } catch (...)
+    {
+        LogOut( LOG_ERR, "Failed to save %s", pathFName.c_str() );
+        return false;
+    }
+}
+
+//==================================================================
+// level 0 in a buffer of its own, which then goes to moExportQueue
+bool ImageSystem::startSaveCompositeJob( const DStr &pathFName, const PNGSaveParams &par )
+{
+    c_auto doApplyColorCorr = loadEntryLayers();
+
+    DVec<ImageEntry *> pEntries;
+    c_auto curSelIdx = collectEntries( pEntries );
+
+    if ( pEntries.empty() || curSelIdx == DNPOS )
+        return false;
+
+    c_auto n = curSelIdx + 1;
+    c_auto gen = mJobGenLatest.load();
+
+    mIsSavingLayers = false;
+
+    // Entries stay put until cancelJob() is called, which stops it
+    mSaveFuture = std::async( std::launch::async,
+        [this, pEntries, n, cfg=mIMSCfg, doApplyColorCorr, gen, pathFName, par]()
+        {
+            LogThreadNameScope nameScope( "save_composite" );
+            DTR_SCOPE( "save_composite_job" );
+
+            c_auto isCancelled = [this, gen]() { return mJobGenLatest != gen; };
+
+            BuiltComposite bc;
+            if ( makeComposite( bc, pEntries, n, 0, cfg, doApplyColorCorr, isCancelled ) )
+                moExportQueue->AddPNGJob( std::move( bc.bc_oImage ), pathFName, par );
+            else
+                LogOut( LOG_WRN, "Saving of %s cancelled", pathFName.c_str() );
+
+            if ( mOnWorkDoneFn )
+                mOnWorkDoneFn();
+        });
+
+    return true;
+}
+
+//==================================================================
+#ifdef ENABLE_OPENEXR
+// none of the channels is other than R, G, B or A
+static bool isRGBALayer( const ImageEXRLayer &layer )
+{
+    for (c_auto &ch : layer.iel_chans)
+    {
+        if (c_auto name = StrMakeUpper( ch.GetChanNameOnly() );
+                    name != "R" &&
+                    name != "G" &&
+                    name != "B" &&
+                    name != "A" )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+//==================================================================
+// a view on the pixels of an image, no copy
+static uptr<image> makeImageView( const image &img )
+{
+    image::Params par;
+    par.FormatFromImage( img );
+    par.width       = img.mW;
+    par.height      = img.mH;
+    par.rowPitch    = img.mBytesPerRow;
+    par.pUseData    = (U8 *)img.GetPixelPtr( 0, 0 );
+
+    return std::make_unique<image>( par );
+}
+
+//==================================================================
+// for the names of the files and of the EXR parts
+static DStr makeLayerTag( const DStr &layerName )
+{
+    if ( layerName == ImageSystem::DUMMY_LAYER_NAME )
+        return "rgba";
+
+    DStr out;
+    for (c_auto c : layerName)
+    {
+        c_auto isSafe = isalnum( (unsigned char)c ) || c == '.' || c == '-' || c == '_';
+        out += isSafe ? c : '_';
+    }
+    return out;
+}
+
+//==================================================================
+size_t ImageSystem::SaveAllLayers( const DStr &path, const LayersSaveParams &par )
+{
+    DTR_SCOPE( "save_all_layers" );
+
+    if ( mSaveFuture.valid() )
+    {
+        LogOut( LOG_WRN, "The previous save is still being built" );
+        return 0;
+    }
+
+    // the display gets its rebuild now, one started later cancels the save
+    if ( mHasRebuildReq )
+    {
+        mHasRebuildReq = false;
+        rebuildComposite( mDispLevel, true );
+    }
+
+    // the current layers are up to date, their images are shared
+    c_auto doCCorCurLayer = loadEntryLayers();
+
+    // the range of the stack, up to the selection
+    c_auto selIdx = FindEntryIdx( mCurSelPathFName );
+    if ( selIdx == DNPOS )
+        return 0;
+
+    DVec<ImageEntry *> pRange;
+    for (size_t i=0; i <= selIdx; ++i)
+    {
+        auto &e = mEntries[i];
+#ifdef ENABLE_OPENEXR
+        if ( e.mIsImageEnabled && (e.moBaseImage || e.moEXRImage) )
+#else
+        if ( e.mIsImageEnabled && e.moBaseImage )
+#endif
+            pRange.push_back( &e );
+    }
+
+    // all the layers in the range, in order of appearance
+    DVec<DStr> layerNames;
+    c_auto addLayerName = [&]( const DStr &name )
+    {
+        if ( std::find( layerNames.begin(), layerNames.end(), name ) == layerNames.end() )
+            layerNames.push_back( name );
+    };
+
+    for (c_auto *pE : pRange)
+    {
+#ifdef ENABLE_OPENEXR
+        if ( pE->moEXRImage )
+        {
+            for (c_auto &oL : pE->moEXRImage->ie_layers)
+                addLayerName( oL->iel_name );
+            continue;
+        }
+#endif
+        addLayerName( DUMMY_LAYER_NAME );
+    }
+
+    if ( layerNames.empty() )
+        return 0;
+
+    // same rule as for the current layer in loadEntryLayers()
+    c_auto isColorCorrected = [&]( const DStr &name )
+    {
+        if ( name == mCurLayerName )
+            return doCCorCurLayer;
+
+        bool hasEXRImage = false;
+#ifdef ENABLE_OPENEXR
+        for (c_auto &e : mEntries)
+        {
+            if ( !e.moEXRImage || !e.mIsImageEnabled )
+                continue;
+
+            hasEXRImage = true;
+
+            if ( mIMSCfg.imsc_ccorRGBOnly )
+                if (c_auto *pLayer = e.moEXRImage->FindLayerByName( name ))
+                    if NOT( isRGBALayer( *pLayer ) )
+                        return false;
+        }
+#endif
+        return hasEXRImage;
+    };
+
+    // the EXR keeps the data linear, as it comes
+    DVec<U8> doLayersCCor( layerNames.size() );
+    for (size_t l=0; l < layerNames.size(); ++l)
+        doLayersCCor[l] = !par.lsp_isMultiPartEXR && isColorCorrected( layerNames[l] );
+
+#ifdef ENABLE_OCIO
+    // load the config now, the layers use it at the same time
+    try {
+        moIS_OCIO->UpdateConfigOCIO( mIMSCfg.imsc_ccorOCIOCfgFName );
+    } catch (...)
+    {
+        LogOut( LOG_ERR, "Failed to load the OCIO config" );
+    }
+#endif
+
+    mIsSavingLayers = true;
+    mSaveLayersDoneN = 0;
+    mSaveLayersTotN = layerNames.size();
+
+    c_auto gen = mJobGenLatest.load();
+
+    // loaded and built in the background, then saved by moExportQueue.
+    //  Entries stay put until cancelJob() is called, which stops it
+    mSaveFuture = std::async( std::launch::async,
+        [this, pRange, layerNames, doLayersCCor, path, par, cfg=mIMSCfg, gen]()
+        {
+            LogThreadNameScope nameScope( "save_layers" );
+            DTR_SCOPE( "save_layers_job" );
+
+            c_auto isCancelled = [this, gen]() { return mJobGenLatest != gen; };
+
+            saveLayersJob( pRange, layerNames, doLayersCCor, path, par, cfg, isCancelled );
+
+            if ( mOnWorkDoneFn )
+                mOnWorkDoneFn();
+        });
+
+    return layerNames.size();
+}
+
+//==================================================================
+bool ImageSystem::GetSaveLayersProgress( size_t &out_doneN, size_t &out_totN ) const
+{
+    if ( !mSaveFuture.valid() || !mIsSavingLayers )
+        return false;
+
+    out_doneN = mSaveLayersDoneN;
+    out_totN = mSaveLayersTotN;
+    return true;
+}
+
+//==================================================================
+void ImageSystem::saveLayersJob(
+            const DVec<ImageEntry *> &pRange,
+            const DVec<DStr> &layerNames,
+            const DVec<U8> &doLayersCCor,
+            const DStr &path,
+            const LayersSaveParams &par,
+            const IMSConfig &cfg,
+            const DFun<bool ()> &isCancelled )
+{
+#ifdef ENABLE_OPENEXR
+    // the layers not loaded yet, one file per thread. What's loaded stays,
+    //  for when the layer is picked for display
+    {
+        c_auto needsLoad = [&]( const ImageEntry &e, const ImageEXRLayer &layer )
+        {
+            return !layer.IsLayerDataLoaded() &&
+                   !(moDecodeCache &&
+                     moDecodeCache->Has( makeLayerImageKey( e, layer.iel_name, false ) ));
+        };
+
+        DVec<DStr> warmNames;
+        for (c_auto *pE : pRange)
+        {
+            if NOT( pE->moEXRImage )
+                continue;
+
+            for (c_auto &oL : pE->moEXRImage->ie_layers)
+            {
+                if ( needsLoad( *pE, *oL ) )
+                {
+                    warmNames.push_back( pE->mImagePathFName );
+                    break;
+                }
+            }
+        }
+        moPrefetcher->Warm( warmNames );
+
+        DT_ParallelFor( pRange.size(), 1, [&]( size_t i1, size_t i2 )
+        {
+            for (size_t i=i1; i < i2; ++i)
+            {
+                auto *pEXR = pRange[i]->moEXRImage.get();
+                if NOT( pEXR )
+                    continue;
+
+                for (c_auto &oL : pEXR->ie_layers)
+                {
+                    if ( isCancelled() )
+                        return;
+
+                    if NOT( needsLoad( *pRange[i], *oL ) )
+                        continue;
+
+                    STAGE_TIMER( "exr_layer_load" );
+                    try {
+                        ImageEXR_LoadLayer( *pEXR, oL->iel_name );
+                    } catch (...)
+                    {
+                        LogOut( LOG_ERR, "Failed to load layer %s of %s",
+                                    oL->iel_name.c_str(), pEXR->ie_pathFName.c_str() );
+                    }
+                }
+            }
+        });
+    }
+#endif
+
+    // the composite of a layer, or null if there's none
+    c_auto buildLayer = [&]( size_t idx ) -> uptr<image>
+    {
+        c_auto &name = layerNames[ idx ];
+
+        // stand-ins for the entries, with the images of this layer
+        DVec<ImageEntry> tmpEntries;
+        tmpEntries.reserve( pRange.size() );
+
+        for (auto *pE : pRange)
+        {
+            uptr<image> oBase;
+            uptr<DFileData> oBaseFile;
+#ifdef ENABLE_OPENEXR
+            if ( pE->moEXRImage )
+            {
+                auto *pLayer = pE->moEXRImage->FindLayerByName( name );
+                if NOT( pLayer )
+                    continue;
+
+                if ( pE->moBaseImage && pE->mBaseImageCurLayer == name )
+                    oBase = makeImageView( *pE->moBaseImage );
+                else
+                    oBase = makeLayerImage( *pE, *pLayer, false, oBaseFile );
+            }
+            else
+#endif
+            {
+                if ( name != DUMMY_LAYER_NAME )
+                    continue;
+
+                oBase = makeImageView( *pE->moBaseImage );
+            }
+
+            auto &te = tmpEntries.emplace_back();
+            te.mImagePathFName  = pE->mImagePathFName;
+            te.moBaseImage      = std::move( oBase );
+            te.moBaseImageFile  = std::move( oBaseFile );
+            if ( pE->moAlphaImage )
+                te.moAlphaImage = makeImageView( *pE->moAlphaImage );
+        }
+
+        if ( tmpEntries.empty() )
+            return {};
+
+        DVec<ImageEntry *> pTmpEntries;
+        for (auto &te : tmpEntries)
+            pTmpEntries.push_back( &te );
+
+        BuiltComposite bc;
+        if NOT( makeComposite(
+                    bc,
+                    pTmpEntries,
+                    pTmpEntries.size(),
+                    0,
+                    cfg,
+                    doLayersCCor[ idx ] != 0,
+                    isCancelled ) )
+            return {};
+
+        return std::move( bc.bc_oImage );
+    };
+
+    DVec<uptr<image>> oComps( layerNames.size() );
+
+    // the layers are independent, they're built at the same time
+    DT_ParallelFor( layerNames.size(), 1, [&]( size_t l1, size_t l2 )
+    {
+        for (size_t l=l1; l < l2; ++l)
+        {
+            if ( isCancelled() )
+                return;
+
+            c_auto &name = layerNames[l];
+
+            uptr<image> oComp;
+            try {
+                oComp = buildLayer( l );
+            } catch (...)
+            {
+                LogOut( LOG_ERR, "Failed to build the composite of layer %s", name.c_str() );
+            }
+
+            // stopped halfway
+            if ( isCancelled() )
+                return;
+
+            ++mSaveLayersDoneN;
+            if ( mOnWorkDoneFn )
+                mOnWorkDoneFn();
+
+            if NOT( oComp )
+                continue;
+
+            // PNGs are saved as they come, while the others are built
+            if NOT( par.lsp_isMultiPartEXR )
+            {
+                moExportQueue->AddPNGJob(
+                        std::move( oComp ),
+                        FU_JPath( path, "xComp_out_" + makeLayerTag( name ) + ".png" ),
+                        par.lsp_pngPar );
+            }
+            else
+            {
+                oComps[l] = std::move( oComp );
+            }
+        }
+    });
+
+    // the layers queued so far are saved all the same
+    if ( isCancelled() )
+    {
+        LogOut( LOG_WRN, "Saving of the layers cancelled, after %zu of %zu",
+                    (size_t)mSaveLayersDoneN, layerNames.size() );
+        return;
+    }
+
+    if NOT( par.lsp_isMultiPartEXR )
+        return;
+
+#ifdef ENABLE_OPENEXR
+    // one part per layer, in a single file
+    DVec<sptr<image>> sImgs;
+    DVec<DStr> partNames;
+    for (size_t l=0; l < layerNames.size(); ++l)
+    {
+        if NOT( oComps[l] )
+            continue;
+
+        sImgs.push_back( std::move( oComps[l] ) );
+        partNames.push_back( makeLayerTag( layerNames[l] ) );
+    }
+
+    if ( sImgs.empty() )
+        return;
+
+    c_auto pathFName = FU_JPath( path, "xComp_out_layers.exr" );
+    c_auto isHalf = par.lsp_isHalf;
+
+    moExportQueue->AddJob( pathFName, [sImgs, partNames, pathFName, isHalf]( c_auto &onProgressFn )
+    {
+        STAGE_TIMER( "exr_save" );
+
+        DVec<const image *> pImgs;
+        for (c_auto &sImg : sImgs)
+            pImgs.push_back( sImg.get() );
+
+        ImageEXR_SaveMultiPartImage( pathFName, pImgs, partNames, isHalf, onProgressFn );
+    });
+
+#else
+    LogOut( LOG_ERR, "EXR saving is not available" );
+#endif
+}
+
+//==================================================================
+static std::unordered_set<DStr> findDirImages( const DStr &path )
+{
+    STAGE_TIMER( "scan_dir" );
+
+    std::unordered_set<DStr>  newNames;
+
+    for (auto it  = fs::recursive_directory_iterator( path );
+              it != fs::recursive_directory_iterator(); ++it)
+    {
+        if ( it.depth() > 0 )
+            continue;
+
+        c_auto &p = *it;
+
+        if NOT( fs::is_regular_file( p ) )
+            continue;
+
+        // skip if it's our own generated file
+        if ( StrStartsWithI( p.path().filename().string().c_str(), "mt_compar" ) ||
+             StrStartsWithI( p.path().filename().string().c_str(), "xComp" ) )
+            continue;
+
+        c_auto pathFName = p.path().string();
+
+        if NOT( StrEndsWithI( pathFName, ".png" ) ||
+                StrEndsWithI( pathFName, ".exr" )
+              )
+        //if NOT( StrEndsWithI( pathFName, ".png" ) ||
+        //        StrEndsWithI( pathFName, ".jpg" ) ||
+        //        StrEndsWithI( pathFName, ".jpeg" ) )
+            continue;
+
+        newNames.insert( pathFName );
+    }
+
+    return newNames;
+}
+
+//==================================================================
+DVec<DStr> ImageSystem::FindDirImages( const DStr &path )
+{
+    c_auto names = findDirImages( path );
+
+    DVec<DStr> out( names.begin(), names.end() );
+    std::sort( out.begin(), out.end() );
+    return out;
+}
+
+//==================================================================
+void ImageSystem::SetImages( const DVec<DStr> &pathFNames )
+{
+    // the background jobs point into the entries
+    cancelJob();
+
+    auto names = pathFNames;
+    std::sort( names.begin(), names.end() );
+
+    prefetchFiles( names );
+
+    // decoding is the bulk of it, one image per worker
+    DVec<ImageEntry> entries( names.size() );
+    DT_ParallelFor( names.size(), 1, [&]( size_t i1, size_t i2 )
+    {
+        for (size_t i=i1; i < i2; ++i)
+            entries[i] = ImageEntry( names[i], moPrefetcher.get(), moDecodeCache.get() );
+    });
+
+    mEntries = std::move( entries );
+    for (auto &e : mEntries)
+        e.mEntryID = ++mLastEntryID;
+
+    mCurSelPathFName = mEntries.empty() ? DStr() : mEntries.back().mImagePathFName;
+
+    ++mEntriesGen;
+    ReqRebuildComposite();
+}
+
+//==================================================================
+bool ImageSystem::OnNewScanDir( const DStr &path, const DStr &selPathFName )
+{
+    // fail silently
+    if NOT( FU_DirectoryExists( path ) )
+        return false;
+
+    c_auto newNames = findDirImages( path );
+
+    // remove what's not longer here
+    c_auto isGone = [&](c_auto &e) {
+        return newNames.find( e.mImagePathFName ) == newNames.end(); };
+
+    c_auto hasGone = std::any_of( mEntries.begin(), mEntries.end(), isGone );
+
+    updateEntryIndex();
+
+    DVec<DStr> addNames;
+    for (c_auto &nn : newNames)
+        if ( FindEntryIdx( nn ) == DNPOS )
+            addNames.push_back( nn );
+
+    // the reads start while the job winds down, and go on while decoding
+    prefetchFiles( addNames );
+
+    if ( hasGone || !addNames.empty() )
+    {
+        // the background jobs point into the entries
+        cancelJob();
+
+        std::erase_if( mEntries, isGone );
+
+        for (c_auto &nn : addNames)
+        {
+            mEntries.emplace_back( nn, moPrefetcher.get(), moDecodeCache.get() );
+            mEntries.back().mEntryID = ++mLastEntryID;
+        }
+
+        std::sort( mEntries.begin(), mEntries.end(), []( c_auto &l, c_auto &r )
+        {
+            return l.mImagePathFName < r.mImagePathFName;
+        });
+
+        ++mEntriesGen;
+        ReqRebuildComposite();
+    }
+
+    //
+    if NOT( addNames.empty() )
+    {
+        // has a specific file name to select ?
+        if NOT( selPathFName.empty() )
+        {
+            // select this
+            mCurSelPathFName = selPathFName;
+
+            // enable only what's selected
+            for (auto &e : mEntries)
+                e.mIsImageEnabled = (e.mImagePathFName == selPathFName);
+        }
+        else
+        if ( !mEntries.empty() )
+        {
+            // select the new last image
+            mCurSelPathFName = mEntries.back().mImagePathFName;
+        }
+
+        return true;
+    }
+    else
+    if ( !selPathFName.empty() && mCurSelPathFName != selPathFName )
+    {
+        // select this
+        mCurSelPathFName = selPathFName;
+
+        // enable only what's selected
+        for (auto &e : mEntries)
+            e.mIsImageEnabled = (e.mImagePathFName == selPathFName);
+
+        ++mEntriesGen;
+        ReqRebuildComposite();
+        return true;
+    }
+
+#if 0
+    LogOut( LOG_DBG, "----" );
+    for (c_auto &e : mEntries)
+        LogOut( LOG_DBG, "F: %s", e.mImagePathFName.c_str() );
+#endif
+
+    return false;
+}
+
+//==================================================================
+// rebuild the lookups, if the entries or their enabled state changed
+void ImageSystem::updateEntryIndex()
+{
+    if ( mEntryIndexGen == mEntriesGen )
+        return;
+
+    mEntryIndexGen = mEntriesGen;
+
+    c_auto n = mEntries.size();
+
+    mEntryIdxByPath.clear();
+    mEntryIdxByPath.reserve( n );
+    mEntryIdxByID.clear();
+    mEntryIdxByID.reserve( n );
+    for (size_t i=0; i < n; ++i)
+    {
+        mEntryIdxByPath[ mEntries[i].mImagePathFName ] = i;
+        mEntryIdxByID[ mEntries[i].mEntryID ] = i;
+    }
+
+    mNextEnabledIdx.resize( n );
+    mPrevEnabledIdx.resize( n );
+
+    size_t lastIdx = DNPOS;
+    for (size_t i=0; i < n; ++i)
+    {
+        mPrevEnabledIdx[i] = lastIdx;
+        if ( mEntries[i].mIsImageEnabled )
+            lastIdx = i;
+    }
+    mLastEnabledIdx = lastIdx;
+
+    size_t nextIdx = DNPOS;
+    for (size_t i=n; i > 0; --i)
+    {
+        mNextEnabledIdx[i-1] = nextIdx;
+        if ( mEntries[i-1].mIsImageEnabled )
+            nextIdx = i-1;
+    }
+    mFirstEnabledIdx = nextIdx;
+}
+
+//==================================================================
+size_t ImageSystem::FindEntryIdx( const DStr &pathFName )
+{
+    updateEntryIndex();
+
+    c_auto it = mEntryIdxByPath.find( pathFName );
+    return it == mEntryIdxByPath.end() ? DNPOS : it->second;
+}
+
+//==================================================================
+void ImageSystem::SetEntryEnabled( u_int entryID, bool onOff )
+{
+    updateEntryIndex();
+
+    c_auto it = mEntryIdxByID.find( entryID );
+    if ( it == mEntryIdxByID.end() )
+        return;
+
+    auto &e = mEntries[ it->second ];
+    if ( e.mIsImageEnabled == onOff )
+        return;
+
+    e.mIsImageEnabled = onOff;
+
+    ++mEntriesGen;
+    ReqRebuildComposite();
+}
+
+//==================================================================
+void ImageSystem::SetAllEntriesEnabled( bool onOff )
+{
+    bool hasChanged = false;
+    for (auto &e : mEntries)
+    {
+        hasChanged |= (e.mIsImageEnabled != onOff);
+        e.mIsImageEnabled = onOff;
+    }
+
+    if NOT( hasChanged )
+        return;
+
+    ++mEntriesGen;
+    ReqRebuildComposite();
+}
+
+//==================================================================
+void ImageSystem::SetupDecodeCache( const DecodeCacheParams &par )
+{
+    if ( moDecodeCache )
+        moDecodeCache->SetMaxBytes( par.dcp_maxBytes );
+    else
+        moDecodeCache = std::make_unique<DecodeCache>( par );
+}
+
+//==================================================================
+// EXR files are opened by their reader, which is also used later for
+//  the layers, so they only go in the page cache. What's in the decode
+//  cache isn't read. For EXR that's up to the layers, see loadEntryLayers()
+void ImageSystem::prefetchFiles( const DVec<DStr> &pathFNames )
+{
+    DVec<DStr> readNames;
+    DVec<DStr> warmNames;
+    for (c_auto &pathFName : pathFNames)
+    {
+        if ( StrEndsWithI( pathFName, ".exr" ) )
+        {
+            if NOT( moDecodeCache )
+                warmNames.push_back( pathFName );
+        }
+        else
+        if ( !moDecodeCache || !moDecodeCache->Has( DecodeCache::MakeKey( pathFName, "" ) ) )
+        {
+            readNames.push_back( pathFName );
+        }
+    }
+
+    moPrefetcher->Prefetch( readNames );
+    moPrefetcher->Warm( warmNames );
+}
+
+//==================================================================
+void ImageSystem::selectEntryIdx( size_t idx )
+{
+    mCurSelPathFName = mEntries[idx].mImagePathFName;
+    ReqRebuildComposite();
+}
+
+//==================================================================
+bool ImageSystem::IncCurSel( int step )
+{
+    if ( mEntries.empty() || !step )
+    {
+        mCurSelPathFName = {};
+        return false;
+    }
+
+    auto idx = FindEntryIdx( mCurSelPathFName );
+    if ( idx == DNPOS )
+        return false;
+
+    // hop over the disabled entries
+    for (; step < 0 && idx != DNPOS; ++step)
+        idx = mPrevEnabledIdx[idx];
+
+    for (; step > 0 && idx != DNPOS; --step)
+        idx = mNextEnabledIdx[idx];
+
+    if ( idx == DNPOS )
+        return false;
+
+    selectEntryIdx( idx );
+    return true;
+}
+
+//==================================================================
+void ImageSystem::SetFirstCurSel()
+{
+    // the first enabled one, if it's before the selection
+    if (c_auto idx = FindEntryIdx( mCurSelPathFName );
+            idx != DNPOS && mFirstEnabledIdx < idx )
+        selectEntryIdx( mFirstEnabledIdx );
+}
+
+//==================================================================
+void ImageSystem::SetLastCurSel()
+{
+    // the last enabled one, if it's after the selection
+    if (c_auto idx = FindEntryIdx( mCurSelPathFName );
+            idx != DNPOS && mLastEnabledIdx != DNPOS && mLastEnabledIdx > idx )
+        selectEntryIdx( mLastEnabledIdx );
+}
+
+//==================================================================
+inline auto copyRow = []( auto *pDes, c_auto *pSrc, size_t w, size_t chN )
+{
+    if ( chN >= 4 )
+    {
+        for (size_t x=0; x < w; ++x)
+        {
+            c_auto a = DClamp( pSrc[3], 0.f, 1.f );
+            pDes[0] = DLerp( pDes[0], pSrc[0], a );
+            pDes[1] = DLerp( pDes[1], pSrc[1], a );
+            pDes[2] = DLerp( pDes[2], pSrc[2], a );
+            pDes += 3;
+            pSrc += chN;
+        }
+    }
+    else
+    if ( chN == 3 )
+    {
+        for (size_t x=0; x < w; ++x)
+        {
+            pDes[0] = pSrc[0];
+            pDes[1] = pSrc[1];
+            pDes[2] = pSrc[2];
+            pDes += 3;
+            pSrc += chN;
+        }
+    }
+    else
+    if ( chN == 2 )
+    {
+        for (size_t x=0; x < w; ++x)
+        {
+            pDes[0] = pSrc[0];
+            pDes[1] = pSrc[1];
+            pDes[2] = 0;
+            pDes += 3;
+            pSrc += 2;
+        }
+    }
+    else
+    {
+        for (size_t x=0; x < w; ++x)
+        {
+            pDes[0] = pSrc[0];
+            pDes[1] = pSrc[0];
+            pDes[2] = pSrc[0];
+            pDes += 3;
+            pSrc += 1;
+        }
+    }
+};
+
+inline auto copyRowA = []( auto *pDes, c_auto *pSrc, c_auto *pASrc, size_t w, size_t chN )
+{
+    if ( chN >= 3 )
+    {
+        for (size_t x=0; x < w; ++x)
+        {
+            c_auto a = DClamp( pASrc[0], 0.f, 1.f );
+            pASrc += 1;
+            pDes[0] = DLerp( pDes[0], pSrc[0], a );
+            pDes[1] = DLerp( pDes[1], pSrc[1], a );
+            pDes[2] = DLerp( pDes[2], pSrc[2], a );
+            pDes += 3;
+            pSrc += chN;
+        }
+    }
+    else
+    if ( chN >= 2 )
+    {
+        for (size_t x=0; x < w; ++x)
+        {
+            c_auto a = DClamp( pASrc[0], 0.f, 1.f );
+            pASrc += 1;
+            pDes[0] = DLerp( pDes[0], pSrc[0], a );
+            pDes[1] = DLerp( pDes[1], pSrc[1], a );
+            pDes[2] = 0;
+            pDes += 3;
+            pSrc += 2;
+        }
+    }
+    else
+    {
+        for (size_t x=0; x < w; ++x)
+        {
+            c_auto a = DClamp( pASrc[0], 0.f, 1.f );
+            pASrc += 1;
+            pDes[0] =
+            pDes[1] =
+            pDes[2] = DLerp( pDes[0], pSrc[0], a );
+            pDes += 3;
+            pSrc += 1;
+        }
+    }
+};
+
+//==================================================================
+static auto applyFilmic = []( const image &img, u_int y1, u_int y2 )
+{
+    // from http://filmicworlds.com/blog/filmic-tonemapping-operators/
+    auto uncharted2_tonemap_partial = []( const Float3 &x )
+    {
+        float A = 0.15f;
+        float B = 0.50f;
+        float C = 0.10f;
+        float D = 0.20f;
+        float E = 0.02f;
+        float F = 0.30f;
+        return ((x*(A*x+C*B)+D*E)/(x*(A*x+B)+D*F))-E/F;
+    };
+
+    auto uncharted2_filmic = [&]( const Float3 &v )
+    {
+        float exposure_bias = 2.0f;
+        Float3 curr = uncharted2_tonemap_partial(v * exposure_bias);
+
+        Float3 W = Float3(11.2f);
+        Float3 white_scale = Float3(1.0f) / uncharted2_tonemap_partial(W);
+        return curr * white_scale;
+    };
+
+    for (u_int y=y1; y < y2; ++y)
+    {
+        auto *pData = (Float3 *)img.GetPixelPtr( 0, y );
+
+        for (u_int x=0; x < img.mW; ++x)
+        {
+            pData[x] = uncharted2_filmic( pData[x] );
+        }
+    }
+};
+
+//==================================================================
+static auto applySRGB = []( const image &img, u_int y1, u_int y2 )
+{
+    auto s2lin = []( auto x )
+    {
+        c_auto a = 0.055f;
+        //return x <= 0.04045f
+        //            ? x * (1.0f / 12.92f)
+        //            : pow((x + a) * (1.0f / (1 + a)), 2.4f);
+        return DPow((x + a) * (1.0f / (1 + a)), 2.2f);
+    };
+
+    auto lin2s = []( auto x )
+    {
+        c_auto a = 0.055f;
+        //return x <= 0.0031308f
+        //            ? x * 12.92f,
+        //            : (1 + a) * pow(x, 1 / 2.4f) - a;
+        return (1 + a) * DPow(x, 1 / 2.2f) - a;
+    };
+
+    for (u_int y=y1; y < y2; ++y)
+    {
+        auto *pData = (Float3 *)img.GetPixelPtr( 0, y );
+
+        for (u_int x=0; x < img.mW; ++x)
+            pData[x] = lin2s( pData[x] );
+    }
+};
+
+//==================================================================
+// filmic and sRGB, on a band of rows. OCIO goes on the whole image
+static void applyColorCorrRows( const image &img, const IMSConfig &cfg, u_int y1, u_int y2 )
+{
+    STAGE_TIMER( "filmic_srgb" );
+
+    if ( cfg.imsc_ccorXform == "filmic" )
+        applyFilmic( img, y1, y2 );
+
+    // we ignore this sRGB conversion in case of OCIO
+    if ( cfg.imsc_ccorSRGB && cfg.imsc_ccorXform != "ocio" )
+        applySRGB( img, y1, y2 );
+}
+
+//==================================================================
+void ImageSystem::applyColorCorrOCIO( image &img, const IMSConfig &cfg )
+{
+#ifdef ENABLE_OCIO
+    STAGE_TIMER( "ocio" );
+
+    if ( cfg.imsc_ccorXform == "ocio" )
+        moIS_OCIO->ApplyOCIO(
+                        img,
+                        cfg.imsc_ccorOCIOCfgFName,
+                        cfg.imsc_ccorOCIODisp,
+                        cfg.imsc_ccorOCIOView,
+                        cfg.imsc_ccorOCIOLook );
+#endif
+}
+
+//==================================================================
+void ImageSystem::makeDummyComposite()
+{
+    image::Params par;
+    par.width   = 320;
+    par.height  = 240;
+    par.chans   = 3;
+    par.flags   = 0;
+    par.depth = 8 * 3;
+
+    BuiltComposite bc;
+    bc.bc_oImage = takeSpareComposite();
+    setupCompositeImage( bc, par );
+
+    bc.bc_gen        = mJobGenLatest;
+    bc.bc_level      = 0;
+    bc.bc_fullW      = par.width;
+    bc.bc_fullH      = par.height;
+    bc.bc_isComplete = true;
+
+    installComposite( std::move( bc ) );
+}
+
+//==================================================================
+// reuse the recycled buffer in bc_oImage, unless the layout changed
+void ImageSystem::setupCompositeImage( BuiltComposite &bc, const image::Params &par )
+{
+    if (c_auto *pImg = bc.bc_oImage.get();
+            pImg &&
+            pImg->mW     == par.width &&
+            pImg->mH     == par.height &&
+            pImg->mChans == par.chans &&
+            pImg->mDepth == par.depth &&
+            pImg->mFlags == par.flags )
+    {
+        bc.bc_oImage->Clear();
+        return;
+    }
+
+    // keep the old one around for its texture
+    bc.bc_oRetired = std::move( bc.bc_oImage );
+    bc.bc_oImage = std::make_unique<image>( par );
+}
+
+//==================================================================
+// a reallocated buffer takes over the texture of the one it replaced
+void ImageSystem::adoptRetiredTexture( BuiltComposite &bc )
+{
+    if ( moDisplay && bc.bc_oImage && bc.bc_oRetired && bc.bc_oRetired->IsTextureIDValid() )
+        moDisplay->OnReplaceComposite( *bc.bc_oImage, *bc.bc_oRetired );
+
+    bc.bc_oRetired = {};
+}
+
+//==================================================================
+// buffers kept for reuse, besides the one on display
+static constexpr size_t SPARE_COMPOSITES_MAX_N = 2;
+// frames built ahead of the playhead
+static constexpr size_t PLAY_RING_N = 8;
+
+//==================================================================
+// a buffer to build into, if there is one left over. Any thread
+uptr<image> ImageSystem::takeSpareComposite()
+{
+    std::lock_guard lock( mJobMutex );
+
+    if ( moSpareComposites.empty() )
+        return {};
+
+    auto oImg = std::move( moSpareComposites.back() );
+    moSpareComposites.pop_back();
+    return oImg;
+}
+
+//==================================================================
+// back to the spares, or freed with its texture. Main thread only
+void ImageSystem::recycleComposite( BuiltComposite &&bc )
+{
+    adoptRetiredTexture( bc );
+
+    auto oImg = std::move( bc.bc_oImage );
+    if NOT( oImg )
+        return;
+
+    // playback needs enough to fill its ring
+    c_auto maxN = SPARE_COMPOSITES_MAX_N + (mPlayFuture.valid() ? PLAY_RING_N : 0);
+    {
+        std::lock_guard lock( mJobMutex );
+        if ( moSpareComposites.size() < maxN )
+        {
+            moSpareComposites.push_back( std::move( oImg ) );
+            DTR_Counter( "spare_composites", (double)moSpareComposites.size() );
+            return;
+        }
+    }
+
+    freeCompositeImage( *oImg );
+}
+
+//==================================================================
+void ImageSystem::freeCompositeImage( image &img )
+{
+    if ( moDisplay )
+        moDisplay->OnFreeComposite( img );
+}
+
+//==================================================================
+// rows per band of work. A cancelled job stops at the next band
+static constexpr u_int COMP_BAND_H = 64;
+
+//==================================================================
+bool ImageSystem::makeComposite(
+            BuiltComposite &out,
+            const DVec<ImageEntry *> &pEntries,
+            size_t n,
+            u_int level,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr,
+            const DFun<bool ()> &isCancelled,
+            size_t startI )
+{
+    DTR_SCOPE( "make_composite" );
+
+    out.bc_fullW = pEntries[n-1]->moBaseImage->mW;
+    out.bc_fullH = pEntries[n-1]->moBaseImage->mH;
+
+    // keep the reduced levels at a reasonable minimum size
+    while ( level && ((out.bc_fullW >> level) < 16 || (out.bc_fullH >> level) < 16) )
+        --level;
+
+    out.bc_level = level;
+
+    c_auto mainW = pEntries[n-1]->getBaseMip( level )->mW;
+    c_auto mainH = pEntries[n-1]->getBaseMip( level )->mH;
+
+    // can only blend over what's there if the size didn't change
+    if ( startI && !(out.bc_oImage &&
+                     out.bc_oImage->mW == mainW &&
+                     out.bc_oImage->mH == mainH) )
+    {
+        startI = 0;
+    }
+
+    if ( startI == 0 )
+    {
+        image::Params par;
+        par.width   = mainW;
+        par.height  = mainH;
+        par.chans   = 3;
+        par.depth   = 3 * sizeof(float) * 8;
+        par.flags   = image::FLG_IS_FLOAT32 |
+                        (cfg.imsc_useBilinear ? image::FLG_USE_BILINEAR : 0);
+
+        setupCompositeImage( out, par );
+    }
+
+    auto &comp = *out.bc_oImage;
+
+    // sources at the size of the composite
+    DVec<const image *> pBSrcImgs( n );
+    DVec<const image *> pASrcImgs( n );
+    // to skip the rows where there's nothing to blend
+    DVec<const ImageAlphaStats *> pBSrcStats( n );
+
+    for (size_t i=startI; i < n; ++i)
+    {
+        if ( isCancelled() )
+            return false;
+
+        auto &e = *pEntries[i];
+
+        c_auto *pBaseMip  = e.getBaseMip( level );
+        c_auto *pAlphaMip = e.getAlphaMip( level );
+
+        if ( pBaseMip->mW == mainW && pBaseMip->mH == mainH )
+        {
+            pBSrcImgs[i] = pBaseMip;
+            pASrcImgs[i] = pAlphaMip;
+
+            // the stats are of the full image, they hold for its levels
+            if ( e.moBaseAlphaStats && !pAlphaMip &&
+                 (e.moBaseImage->mH >> level) == pBaseMip->mH )
+            {
+                pBSrcStats[i] = e.moBaseAlphaStats.get();
+            }
+            continue;
+        }
+
+        if ( !e.moBaseImageScaled ||
+             e.moBaseImageScaled->mW != mainW ||
+             e.moBaseImageScaled->mH != mainH )
+        {
+            STAGE_TIMER( "resample" );
+
+            c_auto *simg = pBaseMip;
+
+            image::Params par;
+            par.width   = mainW;
+            par.height  = mainH;
+            par.depth   = simg->mDepth;
+            par.chans   = simg->mChans;
+            par.flags   = simg->mFlags; // for "float"
+
+            e.moBaseImageScaled = std::make_unique<image>( par );
+
+            ImageConv::BlitResample(
+                *simg, *e.moBaseImageScaled, ImageConv::RESAMPLE_BOX );
+
+            if (c_auto *aimg = pAlphaMip)
+            {
+                par.depth   = aimg->mDepth;
+                par.chans   = aimg->mChans;
+                par.flags   = aimg->mFlags; // for "float"
+
+                e.moAlphaImageScaled = std::make_unique<image>( par );
+
+                ImageConv::BlitResample(
+                    *aimg, *e.moAlphaImageScaled, ImageConv::RESAMPLE_BOX );
+            }
+        }
+
+        pBSrcImgs[i] = e.moBaseImageScaled.get();
+        pASrcImgs[i] = e.moAlphaImageScaled.get();
+    }
+
+    std::atomic<bool> wasCancelled {};
+
+    c_auto bandsN = (size_t)((mainH + COMP_BAND_H - 1) / COMP_BAND_H);
+
+    DT_ParallelFor( bandsN, 1, [&]( size_t b1, size_t b2 )
+    {
+        for (size_t b=b1; b < b2; ++b)
+        {
+            if ( wasCancelled || isCancelled() )
+            {
+                wasCancelled = true;
+                return;
+            }
+
+            c_auto y1 = (u_int)b * COMP_BAND_H;
+            c_auto y2 = std::min( y1 + COMP_BAND_H, (u_int)mainH );
+
+            {
+                STAGE_TIMER( "blend" );
+
+                for (size_t i=startI; i < n; ++i)
+                {
+                    c_auto *pBSrcImg = pBSrcImgs[i];
+                    c_auto *pASrcImg = pASrcImgs[i];
+                    c_auto srcChansN = (size_t)pBSrcImg->mChans;
+
+                    // fully transparent, blending leaves it as it is
+                    if (c_auto *pSt = pBSrcStats[i])
+                    {
+                        c_auto fullH = pEntries[i]->moBaseImage->mH;
+                        if ( pSt->AreRowsEmpty( y1 << level, std::min( y2 << level, fullH ) ) )
+                            continue;
+                    }
+
+                    for (u_int y=y1; y < y2; ++y)
+                    {
+                        c_auto *pSrc = (const float *)pBSrcImg->GetPixelPtr( 0, y );
+                          auto *pDes = (      float *)comp.GetPixelPtr( 0, y );
+
+                        if ( pASrcImg )
+                        {
+                            c_auto *pASrc = (const float *)pASrcImg->GetPixelPtr( 0, y );
+                            copyRowA( pDes, pSrc, pASrc, mainW, srcChansN );
+                        }
+                        else
+                        {
+                            copyRow( pDes, pSrc, mainW, srcChansN );
+                        }
+                    }
+                }
+            }
+
+            // the color correction goes along with the bands
+            if ( doApplyColorCorr )
+                applyColorCorrRows( comp, cfg, y1, y2 );
+        }
+    });
+
+    if ( wasCancelled || isCancelled() )
+        return false;
+
+    if ( doApplyColorCorr )
+        applyColorCorrOCIO( comp, cfg );
+
+    return true;
+}
+
+//==================================================================
+void ImageSystem::installComposite( BuiltComposite &&bc )
+{
+    DTR_SCOPE( "install_composite" );
+
+    if ( bc.bc_flowID )
+        DTR_FlowEnd( "composite", bc.bc_flowID );
+
+    adoptRetiredTexture( bc );
+
+    // what was shown goes to the spares for the next builds
+    if ( moComposite )
+    {
+        BuiltComposite prev;
+        prev.bc_oImage = std::move( moComposite );
+        recycleComposite( std::move( prev ) );
+    }
+
+    moComposite     = std::move( bc.bc_oImage );
+    mCompositeLevel = bc.bc_level;
+    mCompositeFullW = bc.bc_fullW;
+    mCompositeFullH = bc.bc_fullH;
+
+    ++mCompositeGen;
+
+    mCompositeIsTiled = moDisplay && moDisplay->OnInstallComposite( *moComposite, mIMSCfg );
+}
+
+//==================================================================
+// called by the job, for each pass that it's done with
+void ImageSystem::postJobResult( BuiltComposite &&bc )
+{
+    c_auto isComplete = bc.bc_isComplete;
+    {
+        std::lock_guard lock( mJobMutex );
+        mJobResults.push_back( std::move( bc ) );
+    }
+
+    if ( isComplete && mOnWorkDoneFn )
+        mOnWorkDoneFn();
+}
+
+//==================================================================
+// show the finest result of the latest job, recycle anything else
+void ImageSystem::installJobResults()
+{
+    DVec<BuiltComposite> results;
+    {
+        std::lock_guard lock( mJobMutex );
+        results = std::move( mJobResults );
+        mJobResults.clear();
+    }
+
+    // posted in order, so the last good one is the finest
+    BuiltComposite *pBest {};
+    for (auto &bc : results)
+        if ( bc.bc_isComplete && bc.bc_gen == mJobGenLatest )
+            pBest = &bc;
+
+    if ( pBest )
+        installComposite( std::move( *pBest ) );
+
+    for (auto &bc : results)
+        if ( &bc != pBest )
+            recycleComposite( std::move( bc ) );
+}
+
+//==================================================================
+static void waitJobFuture( std::future<void> &fut )
+{
+    if NOT( fut.valid() )
+        return;
+
+    try {
+        fut.get();
+    }
+    catch ( const std::exception &ex )
+    {
+        LogOut( LOG_ERR, "Failed to build the composite: %s", ex.what() );
+    }
+
+    fut = {};
+}
+
+void ImageSystem::waitJob()
+{
+    waitJobFuture( mJobFuture );
+}
+
+//==================================================================
+// make the current job obsolete and wait for it to stop at its
+//  next band. Its results are recycled by installJobResults()
+void ImageSystem::cancelJob()
+{
+    ++mJobGenLatest;
+
+    // wake up the playback, if it's waiting for room in the ring
+    {
+        std::lock_guard lock( mJobMutex );
+    }
+    mPlayRingCV.notify_all();
+
+    waitJob();
+    // the thumbnails stop at the next one
+    waitJobFuture( mThumbFuture );
+    // the saves being built stop at the next band, as the composite
+    waitJobFuture( mSaveFuture );
+
+    if ( mPlayFuture.valid() )
+        stopPlayback();
+}
+
+//==================================================================
+// largest composite that is built first, before refining
+static constexpr size_t QUICK_MAX_PIXELS = 1024 * 1024;
+
+//==================================================================
+#ifdef ENABLE_OPENEXR
+// empty without a decode cache, or if the file is gone
+DStr ImageSystem::makeLayerImageKey( const ImageEntry &ie, const DStr &layerName, bool isAlpha ) const
+{
+    if NOT( moDecodeCache )
+        return {};
+
+    return DecodeCache::MakeKey( ie.mImagePathFName, layerName + (isAlpha ? "#alpha" : "") );
+}
+
+//==================================================================
+// the image of a layer from the decode cache, otherwise made from the
+//  layer, loaded if needed, and stored there. Different layers of the
+//  same entry can be made at the same time
+uptr<image> ImageSystem::makeLayerImage(
+            ImageEntry &ie,
+            ImageEXRLayer &layer,
+            bool isAlpha,
+            uptr<DFileData> &out_oFile )
+{
+    c_auto key = makeLayerImageKey( ie, layer.iel_name, isAlpha );
+
+    if ( moDecodeCache )
+        if (auto oImg = moDecodeCache->Load( key, out_oFile ))
+            return oImg;
+
+    out_oFile = {};
+
+    if NOT( layer.IsLayerDataLoaded() )
+    {
+        STAGE_TIMER( "exr_layer_load" );
+        ImageEXR_LoadLayer( *ie.moEXRImage, layer.iel_name );
+    }
+
+    uptr<image> oImg;
+    {
+        STAGE_TIMER( "layer_to_image" );
+        oImg = isAlpha
+                ? ImageEXR_MakeAlphaImageFromLayer( layer, *ie.moEXRImage )
+                : ImageEXR_MakeImageFromLayer( layer, *ie.moEXRImage );
+    }
+
+    if ( moDecodeCache )
+        moDecodeCache->Store( key, *oImg );
+
+    return oImg;
+}
+#endif
+
+//==================================================================
+// make the images of the current layers, returns whether the color
+//  correction applies to them
+bool ImageSystem::loadEntryLayers()
+{
+    auto doApplyColorCorr = false;
+
+#ifdef ENABLE_OPENEXR
+    // the layers load one file at a time, the next ones are read meanwhile
+    {
+        c_auto needsLoad = [&]( const ImageEntry &ie, const DStr &name, const DStr &imgName, bool isAlpha )
+        {
+            c_auto *pLayer = name.empty() ? nullptr : ie.moEXRImage->FindLayerByName( name );
+            return pLayer &&
+                   !pLayer->IsLayerDataLoaded() &&
+                   imgName != name &&
+                   !(moDecodeCache && moDecodeCache->Has( makeLayerImageKey( ie, name, isAlpha ) ));
+        };
+
+        DVec<DStr> warmNames;
+        for (c_auto &ie : mEntries)
+        {
+            if ( ie.moEXRImage && ie.mIsImageEnabled &&
+                    (needsLoad( ie, mCurLayerName, ie.mBaseImageCurLayer, false ) ||
+                     needsLoad( ie, mCurLayerAlphaName, ie.mAlphaImageCurlayer, true )) )
+                warmNames.push_back( ie.mImagePathFName );
+        }
+        moPrefetcher->Warm( warmNames );
+    }
+
+    if NOT( mCurLayerName.empty() )
+    {
+        bool hasNonRGBAChans = false;
+        bool hasEXRImage = false;
+        bool hasNewBaseImages = false;
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+        {
+            auto &ie = *it;
+
+            if ( !ie.moEXRImage || !ie.mIsImageEnabled )
+                continue;
+
+            hasEXRImage = true;
+
+            auto *pLayer = ie.moEXRImage->FindLayerByName( mCurLayerName );
+            if NOT( pLayer )
+                continue;
+
+            // if color correction is for layers with RGBA channels only...
+            if ( mIMSCfg.imsc_ccorRGBOnly && !isRGBALayer( *pLayer ) )
+                hasNonRGBAChans = true;
+
+            //
+            if ( ie.mBaseImageCurLayer != mCurLayerName || !ie.moBaseImage )
+            {
+                uptr<DFileData> oFile;
+                auto oImg = makeLayerImage( ie, *pLayer, false, oFile );
+
+                ie.mBaseImageCurLayer = mCurLayerName;
+                ie.moBaseImage = std::move( oImg );
+                ie.moBaseImageFile = std::move( oFile );
+                ie.resetDerivedImages();
+                hasNewBaseImages = true;
+            }
+        }
+
+        // the thumbnails that were missing may be made now
+        if ( hasNewBaseImages )
+            ++mLayerImagesGen;
+
+        //
+        doApplyColorCorr = hasEXRImage && !hasNonRGBAChans;
+    }
+
+    if NOT( mCurLayerAlphaName.empty() )
+    {
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+        {
+            auto &ie = *it;
+
+            if ( !ie.moEXRImage || !ie.mIsImageEnabled )
+                continue;
+
+            auto *pLayer = ie.moEXRImage->FindLayerByName( mCurLayerAlphaName );
+            if NOT( pLayer )
+                continue;
+
+            //
+            if ( ie.mAlphaImageCurlayer != mCurLayerAlphaName || !ie.moAlphaImage )
+            {
+                uptr<DFileData> oFile;
+                auto oImg = makeLayerImage( ie, *pLayer, true, oFile );
+
+                ie.mAlphaImageCurlayer = mCurLayerAlphaName;
+                ie.moAlphaImage = std::move( oImg );
+                ie.moAlphaImageFile = std::move( oFile );
+                ie.resetDerivedImages();
+            }
+        }
+    }
+#endif
+
+    return doApplyColorCorr;
+}
+
+//==================================================================
+// enabled entries with the current layer, returns the index of the
+//  selected one in there, or DNPOS
+size_t ImageSystem::collectEntries( DVec<ImageEntry *> &out_pEntries )
+{
+    auto &pEntries = out_pEntries;
+    pEntries.clear();
+
+    size_t curSelIdx = DNPOS;
+
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+    {
+        auto &e = *it;
+        if ( e.moBaseImage && e.mIsImageEnabled )
+        {
+#ifdef ENABLE_OPENEXR
+            if ( (e.moEXRImage && e.moEXRImage->FindLayerByName( mCurLayerName )) ||
+                (!e.moEXRImage && mCurLayerName == DUMMY_LAYER_NAME) )
+#else
+            if ( mCurLayerName == DUMMY_LAYER_NAME )
+#endif
+            {
+                pEntries.push_back( &e );
+            }
+        }
+
+        if ( mCurSelPathFName == e.mImagePathFName && pEntries.size() )
+            curSelIdx = pEntries.size() - 1;
+    }
+
+    return curSelIdx;
+}
+
+//==================================================================
+uptr<image> ImageSystem::MakeCompositeNow( u_int level )
+{
+    // the entries are about to change
+    cancelJob();
+
+    c_auto doApplyColorCorr = loadEntryLayers();
+
+    DVec<ImageEntry *> pEntries;
+    c_auto curSelIdx = collectEntries( pEntries );
+
+    if ( pEntries.empty() || curSelIdx == DNPOS )
+        return {};
+
+    BuiltComposite bc;
+    if NOT( makeComposite(
+                bc, pEntries, curSelIdx + 1, level, mIMSCfg, doApplyColorCorr,
+                [](){ return false; } ) )
+        return {};
+
+    return std::move( bc.bc_oImage );
+}
+
+//==================================================================
+void ImageSystem::ApplyColorCorr( image &img )
+{
+    c_auto bandsN = (size_t)((img.mH + COMP_BAND_H - 1) / COMP_BAND_H);
+
+    DT_ParallelFor( bandsN, 1, [&]( size_t b1, size_t b2 )
+    {
+        for (size_t b=b1; b < b2; ++b)
+        {
+            c_auto y1 = (u_int)b * COMP_BAND_H;
+            c_auto y2 = std::min( y1 + COMP_BAND_H, img.mH );
+
+            applyColorCorrRows( img, mIMSCfg, y1, y2 );
+        }
+    });
+
+    applyColorCorrOCIO( img, mIMSCfg );
+}
+
+//==================================================================
+void ImageSystem::rebuildComposite( u_int level, bool allowProgressive )
+{
+    DTR_SCOPE( "rebuild_composite" );
+
+    // the entries are about to change
+    cancelJob();
+
+    c_auto gen = mJobGenLatest.load();
+
+    c_auto doApplyColorCorr = loadEntryLayers();
+
+    DVec<ImageEntry *> pEntries;
+    c_auto curSelIdx = collectEntries( pEntries );
+
+    if ( pEntries.empty() || curSelIdx == DNPOS )
+    {
+        makeDummyComposite();
+        return;
+    }
+
+    c_auto n = curSelIdx + 1;
+
+    // quick pass at a level that is cheap enough to show right away
+    auto quickLevel = level;
+    if ( allowProgressive )
+    {
+        c_auto &mainImg = *pEntries[n-1]->moBaseImage;
+        while ( (size_t)(mainImg.mW >> quickLevel) *
+                (size_t)(mainImg.mH >> quickLevel) > QUICK_MAX_PIXELS )
+            ++quickLevel;
+    }
+
+    // build on a worker, while the last composite stays on display.
+    //  Entries stay put until cancelJob() is called
+    mJobLevel = level;
+
+    c_auto flowID = DTR_NewFlowID();
+    DTR_FlowStart( "composite", flowID );
+
+    mJobFuture = std::async( std::launch::async,
+        [this, pEntries, n, quickLevel, level, cfg=mIMSCfg, doApplyColorCorr, gen, flowID]()
+        {
+            LogThreadNameScope nameScope( "compose" );
+            DTR_SCOPE( "compose_job" );
+            DTR_FlowStep( "composite", flowID );
+
+            c_auto isCancelled = [this, gen]() { return mJobGenLatest != gen; };
+
+            u_int builtLevel {};
+            c_auto runPass = [&]( u_int passLevel )
+            {
+                DTR_SCOPE( "compose_pass" );
+
+                BuiltComposite bc;
+                bc.bc_gen    = gen;
+                bc.bc_flowID = flowID;
+                bc.bc_oImage = takeSpareComposite();
+                bc.bc_isComplete = makeComposite(
+                        bc, pEntries, n, passLevel, cfg, doApplyColorCorr, isCancelled );
+
+                builtLevel = bc.bc_level;
+                c_auto isComplete = bc.bc_isComplete;
+
+                postJobResult( std::move( bc ) );
+                return isComplete;
+            };
+
+            // then the requested level, if the quick one wasn't it
+            if ( runPass( quickLevel ) && builtLevel > level )
+                runPass( level );
+        });
+}
+
+//==================================================================
+// the color corrected copy of what's been blended so far
+bool ImageSystem::makePlayFrame(
+            BuiltComposite &out,
+            const BuiltComposite &acc,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr,
+            const DFun<bool ()> &isCancelled )
+{
+    c_auto &src = *acc.bc_oImage;
+
+    image::Params par;
+    par.FormatFromImage( src );
+    par.width   = src.mW;
+    par.height  = src.mH;
+    setupCompositeImage( out, par );
+
+    out.bc_level = acc.bc_level;
+    out.bc_fullW = acc.bc_fullW;
+    out.bc_fullH = acc.bc_fullH;
+
+    auto &des = *out.bc_oImage;
+
+    c_auto rowBytes = (size_t)src.mW * src.mBytesPerPixel;
+
+    std::atomic<bool> wasCancelled {};
+
+    c_auto bandsN = (size_t)((src.mH + COMP_BAND_H - 1) / COMP_BAND_H);
+
+    DT_ParallelFor( bandsN, 1, [&]( size_t b1, size_t b2 )
+    {
+        for (size_t b=b1; b < b2; ++b)
+        {
+            if ( wasCancelled || isCancelled() )
+            {
+                wasCancelled = true;
+                return;
+            }
+
+            c_auto y1 = (u_int)b * COMP_BAND_H;
+            c_auto y2 = std::min( y1 + COMP_BAND_H, src.mH );
+
+            for (u_int y=y1; y < y2; ++y)
+                memcpy( des.GetPixelPtr( 0, y ), src.GetPixelPtr( 0, y ), rowBytes );
+
+            if ( doApplyColorCorr )
+                applyColorCorrRows( des, cfg, y1, y2 );
+        }
+    });
+
+    if ( wasCancelled || isCancelled() )
+        return false;
+
+    if ( doApplyColorCorr )
+        applyColorCorrOCIO( des, cfg );
+
+    out.bc_isComplete = true;
+    return true;
+}
+
+//==================================================================
+// builds the frames of the flipbook in order, until cancelled.
+//  Frame N+1 is frame N with one more image blended in
+void ImageSystem::playbackJob(
+            const DVec<ImageEntry *> &pEntries,
+            u_int level,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr,
+            uint64_t gen )
+{
+    c_auto isCancelled = [this, gen]() { return mJobGenLatest != gen; };
+
+    // what's been blended so far, before the color correction
+    BuiltComposite acc;
+    acc.bc_gen    = gen;
+    acc.bc_oImage = takeSpareComposite();
+    size_t accN = 0;
+
+    for (size_t fi=0; !isCancelled(); ++fi)
+    {
+        c_auto ei = fi % pEntries.size();
+
+        // back to the first image, start over
+        if ( ei == 0 )
+            accN = 0;
+
+        if NOT( makeComposite(
+                    acc, pEntries, ei+1, level, cfg, false, isCancelled, accN ) )
+            break;
+
+        accN = ei + 1;
+
+        // already late for this one, only keep blending
+        if ( fi < mPlayDueFrameIdx )
+            continue;
+
+        DTR_SCOPE( "play_frame" );
+
+        PlayFrame pf;
+        pf.pf_frameIdx      = fi;
+        pf.pf_pathFName     = pEntries[ei]->mImagePathFName;
+        pf.pf_bc.bc_gen     = gen;
+        pf.pf_bc.bc_oImage  = takeSpareComposite();
+
+        c_auto isDone = makePlayFrame( pf.pf_bc, acc, cfg, doApplyColorCorr, isCancelled );
+
+        {
+            std::unique_lock lock( mJobMutex );
+
+            if ( isDone )
+                mPlayRingCV.wait( lock, [&]()
+                {
+                    return mPlayRing.size() < PLAY_RING_N || isCancelled();
+                });
+
+            // the buffers go back to the main thread, that owns their textures
+            if ( !isDone || isCancelled() )
+            {
+                mJobResults.push_back( std::move( pf.pf_bc ) );
+                break;
+            }
+
+            mPlayRing.push_back( std::move( pf ) );
+            DTR_Counter( "play_ring", (double)mPlayRing.size() );
+        }
+
+        if ( mOnWorkDoneFn )
+            mOnWorkDoneFn();
+    }
+
+    std::lock_guard lock( mJobMutex );
+    mJobResults.push_back( std::move( acc ) );
+}
+
+//==================================================================
+void ImageSystem::StartPlayback( double fps )
+{
+    // the entries are about to change
+    cancelJob();
+
+    c_auto doApplyColorCorr = loadEntryLayers();
+
+    DVec<ImageEntry *> pEntries;
+    collectEntries( pEntries );
+
+    if ( pEntries.size() < 2 )
+    {
+        LogOut( LOG_WRN, "Playback needs at least two enabled images" );
+        return;
+    }
+
+    mPlayFPS            = std::max( fps, 1.0 );
+    mPlayStartS         = GetSteadyTimeS();
+    mPlayLastShownS     = 0;
+    mPlayNextFrameIdx   = 0;
+    mPlayDueFrameIdx    = 0;
+    mPlayStats          = {};
+
+    c_auto gen = mJobGenLatest.load();
+
+    // at the level that is displayed now, without refining
+    mPlayFuture = std::async( std::launch::async,
+        [this, pEntries, level=mDispLevel, cfg=mIMSCfg, doApplyColorCorr, gen]()
+        {
+            LogThreadNameScope nameScope( "playback" );
+            playbackJob( pEntries, level, cfg, doApplyColorCorr, gen );
+        });
+}
+
+//==================================================================
+void ImageSystem::StopPlayback()
+{
+    if NOT( mPlayFuture.valid() )
+        return;
+
+    cancelJob();
+
+    // the frame where it stopped, refined as usual
+    ReqRebuildComposite();
+}
+
+//==================================================================
+// the generation must have been bumped already, see cancelJob()
+void ImageSystem::stopPlayback()
+{
+    waitJobFuture( mPlayFuture );
+
+    std::deque<PlayFrame> ring;
+    {
+        std::lock_guard lock( mJobMutex );
+        ring = std::move( mPlayRing );
+        mPlayRing.clear();
+    }
+
+    for (auto &pf : ring)
+        recycleComposite( std::move( pf.pf_bc ) );
+
+    // drop the extra buffers that the ring needed
+    DVec<uptr<image>> oExtras;
+    {
+        std::lock_guard lock( mJobMutex );
+        while ( moSpareComposites.size() > SPARE_COMPOSITES_MAX_N )
+        {
+            oExtras.push_back( std::move( moSpareComposites.back() ) );
+            moSpareComposites.pop_back();
+        }
+    }
+
+    for (auto &oImg : oExtras)
+        freeCompositeImage( *oImg );
+}
+
+//==================================================================
+// show the latest frame that is due, count the ones that didn't make it
+void ImageSystem::animatePlayback()
+{
+    c_auto curS = GetSteadyTimeS();
+
+    c_auto dueIdx = (size_t)((curS - mPlayStartS) * mPlayFPS);
+    mPlayDueFrameIdx = dueIdx;
+
+    DVec<PlayFrame> dueFrames;
+    {
+        std::lock_guard lock( mJobMutex );
+        while ( !mPlayRing.empty() && mPlayRing.front().pf_frameIdx <= dueIdx )
+        {
+            dueFrames.push_back( std::move( mPlayRing.front() ) );
+            mPlayRing.pop_front();
+        }
+
+        mPlayStats.ps_ringN = mPlayRing.size();
+    }
+
+    if ( dueFrames.empty() )
+        return;
+
+    // there's room for more
+    mPlayRingCV.notify_all();
+
+    for (size_t i=0; i+1 < dueFrames.size(); ++i)
+        recycleComposite( std::move( dueFrames[i].pf_bc ) );
+
+    auto &pf = dueFrames.back();
+
+    // skipped here, or never built because the worker was behind
+    mPlayStats.ps_droppedN += pf.pf_frameIdx - mPlayNextFrameIdx;
+    mPlayStats.ps_shownN += 1;
+    mPlayNextFrameIdx = pf.pf_frameIdx + 1;
+
+    if ( mPlayLastShownS )
+    {
+        c_auto fps = 1.0 / std::max( curS - mPlayLastShownS, 1e-6 );
+        auto &avg = mPlayStats.ps_actualFPS;
+        avg = avg ? avg + (fps - avg) * 0.1 : fps;
+    }
+    mPlayLastShownS = curS;
+
+    mCurSelPathFName = pf.pf_pathFName;
+    installComposite( std::move( pf.pf_bc ) );
+}
+
+//==================================================================
+void ImageSystem::ReqRebuildComposite()
+{
+    mHasRebuildReq = true;
+}
+
+void ImageSystem::ReqRebuildComposite( const IMSConfig &cfg )
+{
+    mIMSCfg = cfg;
+    ReqRebuildComposite();
+}
+
+//==================================================================
+void ImageSystem::SetupThumbs( const ThumbsParams &par )
+{
+    if ( moThumbCache )
+    {
+        moThumbCache->SetMaxBytes( par.thp_maxBytes );
+        return;
+    }
+
+    mThumbsPar = par;
+
+    DecodeCacheParams dpar;
+    dpar.dcp_dir        = par.thp_dir;
+    dpar.dcp_maxBytes   = par.thp_maxBytes;
+    moThumbCache = std::make_unique<DecodeCache>( dpar );
+}
+
+//==================================================================
+void ImageSystem::RequestThumbs( const DVec<u_int> &entryIDs )
+{
+    mThumbReqIDs = entryIDs;
+}
+
+//==================================================================
+const image *ImageSystem::GetThumb( u_int entryID, uint64_t *pOut_gen ) const
+{
+    c_auto it = mThumbs.find( entryID );
+    if ( it == mThumbs.end() )
+        return nullptr;
+
+    if ( pOut_gen )
+        *pOut_gen = it->second.th_gen;
+
+    return it->second.th_oImage.get();
+}
+
+//==================================================================
+// what the thumbnail of the entry is made of, empty if the entry
+//  doesn't have the current layer
+DStr ImageSystem::makeThumbVariant( const ImageEntry &e, bool *pOut_doColorCorr ) const
+{
+    c_auto &cfg = mIMSCfg;
+
+    auto layerName = DUMMY_LAYER_NAME;
+    auto doColorCorr = true;
+#ifdef ENABLE_OPENEXR
+    if ( e.moEXRImage )
+    {
+        c_auto *pLayer = e.moEXRImage->FindLayerByName( mCurLayerName );
+        if NOT( pLayer )
+            return {};
+
+        layerName = mCurLayerName;
+        doColorCorr = !cfg.imsc_ccorRGBOnly || isRGBALayer( *pLayer );
+    }
+#endif
+
+    if ( pOut_doColorCorr )
+        *pOut_doColorCorr = doColorCorr;
+
+    DStr ccor = "none";
+    if ( doColorCorr )
+    {
+        ccor = cfg.imsc_ccorXform + (cfg.imsc_ccorSRGB ? "+srgb" : "");
+
+        if ( cfg.imsc_ccorXform == "ocio" )
+            ccor += "|" + cfg.imsc_ccorOCIOCfgFName +
+                    "|" + cfg.imsc_ccorOCIODisp +
+                    "|" + cfg.imsc_ccorOCIOView +
+                    "|" + cfg.imsc_ccorOCIOLook;
+    }
+
+    return SSPrintFS( "%s|%s|%u|%u",
+                layerName.c_str(),
+                ccor.c_str(),
+                mThumbsPar.thp_size,
+                mThumbsPar.thp_quality );
+}
+
+//==================================================================
+// from the smallest mip level that is still as large, color corrected
+//  as a composite would be, and in 8 bit
+uptr<image> ImageSystem::makeThumbImage(
+            ImageEntry &e,
+            u_int size,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr )
+{
+    c_auto &base = *e.moBaseImage;
+    c_auto longSide = std::max( base.mW, base.mH );
+
+    u_int level = 0;
+    while ( (longSide >> (level + 1)) >= size )
+        ++level;
+
+    // the mips and the color correction are timed as their own stages,
+    //  "thumb_make" is only the rest, as the stages shouldn't nest
+    c_auto &mip = *e.getBaseMip( level );
+
+    c_auto sca = std::min( 1.0, (double)size / longSide );
+
+    image::Params par;
+    par.FormatFromImage( mip );
+    par.width   = std::max( 1u, (u_int)(base.mW * sca + 0.5) );
+    par.height  = std::max( 1u, (u_int)(base.mH * sca + 0.5) );
+
+    // float RGB, as the composites, for the color correction
+    image::Params rgbPar;
+    rgbPar.width    = par.width;
+    rgbPar.height   = par.height;
+    rgbPar.chans    = 3;
+    rgbPar.depth    = 3 * 32;
+    rgbPar.flags    = image::FLG_IS_FLOAT32;
+
+    image rgb( rgbPar );
+    {
+        STAGE_TIMER( "thumb_make" );
+
+        image small( par );
+        ImageConv::BlitResample( mip, small, ImageConv::RESAMPLE_BOX );
+
+        ImageConv::ConvertFormat( small, rgb );
+    }
+
+    if ( doApplyColorCorr )
+    {
+        applyColorCorrRows( rgb, cfg, 0, rgb.mH );
+        applyColorCorrOCIO( rgb, cfg );
+    }
+
+    // the DLS codec is for integer formats
+    image::Params outPar = rgbPar;
+    outPar.depth    = 3 * 8;
+    outPar.flags    = 0;
+
+    auto oOut = std::make_unique<image>( outPar );
+    {
+        STAGE_TIMER( "thumb_make" );
+
+        ImageConv::ConvertParams cpar;
+        cpar.doClamp = true;
+        ImageConv::ConvertFormat( rgb, *oOut, cpar );
+    }
+
+    return oOut;
+}
+
+//==================================================================
+// the requested thumbnails that are missing or out of date, from the
+//  disk cache or made from the entries, on a low priority thread.
+//  Entries stay put until cancelJob() is called
+void ImageSystem::startThumbJob()
+{
+    if ( !moThumbCache || mThumbReqIDs.empty() )
+        return;
+
+    updateEntryIndex();
+
+    DVec<ThumbJobItem> items;
+    for (c_auto id : mThumbReqIDs)
+    {
+        c_auto itIdx = mEntryIdxByID.find( id );
+        if ( itIdx == mEntryIdxByID.end() )
+            continue;
+
+        auto &e = mEntries[ itIdx->second ];
+
+        bool doColorCorr {};
+        c_auto variant = makeThumbVariant( e, &doColorCorr );
+
+        // up to date, or found missing and nothing changed since
+        if (c_auto it = mThumbs.find( id ); it != mThumbs.end())
+        {
+            c_auto &th = it->second;
+            if ( th.th_variant == variant &&
+                    (th.th_oImage || th.th_layerImagesGen == mLayerImagesGen) )
+                continue;
+        }
+
+        // there's nothing to show for it
+        if ( variant.empty() )
+        {
+            auto &th = mThumbs[ id ];
+            th.th_oImage        = {};
+            th.th_variant       = {};
+            th.th_layerImagesGen = mLayerImagesGen;
+            th.th_gen           = ++mLastThumbGen;
+            continue;
+        }
+
+        ThumbJobItem item;
+        item.tji_pEntry         = &e;
+        item.tji_variant        = variant;
+        item.tji_doColorCorr    = doColorCorr;
+#ifdef ENABLE_OPENEXR
+        if ( e.moEXRImage )
+            item.tji_canMake = e.moBaseImage && e.mBaseImageCurLayer == mCurLayerName;
+        else
+#endif
+            item.tji_canMake = !!e.moBaseImage;
+
+        items.push_back( std::move( item ) );
+    }
+
+    if ( items.empty() )
+        return;
+
+    c_auto gen = mJobGenLatest.load();
+
+    mThumbFuture = DT_AsyncLowPriority(
+        [this, items=std::move( items ), cfg=mIMSCfg, par=mThumbsPar, gen, layerImagesGen=mLayerImagesGen]()
+        {
+            LogThreadNameScope nameScope( "thumbs" );
+            DTR_SCOPE( "thumbs_job" );
+
+            c_auto makeThumb = [&]( const ThumbJobItem &item ) -> uptr<image>
+            {
+                auto &e = *item.tji_pEntry;
+
+                c_auto key = DecodeCache::MakeKey( e.mImagePathFName, "thumb|" + item.tji_variant );
+
+                DVec<U8> data;
+                if ( moThumbCache->LoadBytes( key, data ) )
+                {
+                    DUT::MemReader mr( data.data(), data.size() );
+
+                    auto oImg = std::make_unique<image>();
+                    ImgDLS::LoadDLS( *oImg, 0, 0, 0, mr, nullptr );
+                    return oImg;
+                }
+
+                // only from the disk, if the layer isn't loaded
+                if NOT( item.tji_canMake )
+                    return {};
+
+                auto oImg = makeThumbImage( e, par.thp_size, cfg, item.tji_doColorCorr );
+
+                DUT::MemWriterDynamic mw;
+                ImgDLS::SaveDLS( *oImg, mw, par.thp_quality );
+                moThumbCache->StoreBytes( key, mw.GetDataBegin(), mw.GetCurSize() );
+
+                return oImg;
+            };
+
+            for (c_auto &item : items)
+            {
+                // the entries are about to change
+                if ( mJobGenLatest != gen )
+                    return;
+
+                ThumbResult res;
+                res.tr_entryID      = item.tji_pEntry->mEntryID;
+                res.tr_variant      = item.tji_variant;
+                res.tr_layerImagesGen = layerImagesGen;
+
+                try {
+                    res.tr_oImage = makeThumb( item );
+                } catch (...)
+                {
+                    LogOut( LOG_ERR, "Failed to make the thumbnail of %s",
+                                item.tji_pEntry->mImagePathFName.c_str() );
+                }
+
+                // one at a time, they show as they come
+                {
+                    std::lock_guard lock( mJobMutex );
+                    mThumbResults.push_back( std::move( res ) );
+                }
+
+                if ( mOnWorkDoneFn )
+                    mOnWorkDoneFn();
+            }
+        });
+}
+
+//==================================================================
+void ImageSystem::installThumbResults()
+{
+    DVec<ThumbResult> results;
+    {
+        std::lock_guard lock( mJobMutex );
+        results = std::move( mThumbResults );
+        mThumbResults.clear();
+    }
+
+    updateEntryIndex();
+
+    for (auto &r : results)
+    {
+        if NOT( mEntryIdxByID.count( r.tr_entryID ) )
+            continue;
+
+        auto &th = mThumbs[ r.tr_entryID ];
+        th.th_oImage        = std::move( r.tr_oImage );
+        th.th_variant       = std::move( r.tr_variant );
+        th.th_layerImagesGen = r.tr_layerImagesGen;
+        th.th_gen           = ++mLastThumbGen;
+    }
+
+    // the entries that are gone
+    if ( mThumbsEntriesGen != mEntriesGen )
+    {
+        mThumbsEntriesGen = mEntriesGen;
+
+        std::erase_if( mThumbs, [&]( c_auto &kv ) {
+            return mEntryIdxByID.count( kv.first ) == 0; });
+    }
+}
+
+//==================================================================
+void ImageSystem::AnimateIMS()
+{
+    DTR_SCOPE( "animate_ims" );
+
+    if ( mPlayFuture.valid() )
+    {
+        // it only ends by itself on failure
+        if ( DT_IsFutureReady( mPlayFuture ) )
+            StopPlayback();
+        else
+            animatePlayback();
+
+        // rebuilds wait for the playback to stop
+        installJobResults();
+        return;
+    }
+
+    // the background job is done ?
+    if ( mJobFuture.valid() && DT_IsFutureReady( mJobFuture ) )
+        waitJob();
+
+    installJobResults();
+
+    if ( mThumbFuture.valid() && DT_IsFutureReady( mThumbFuture ) )
+        waitJobFuture( mThumbFuture );
+
+    installThumbResults();
+
+    if ( mSaveFuture.valid() && DT_IsFutureReady( mSaveFuture ) )
+        waitJobFuture( mSaveFuture );
+
+    if ( mHasRebuildReq )
+    {
+        mHasRebuildReq = false;
+        rebuildComposite( mDispLevel, true );
+    }
+    else
+    // thumbnails only when there's nothing else going on
+    if ( !mJobFuture.valid() && !mThumbFuture.valid() && !mSaveFuture.valid() )
+    {
+        startThumbJob();
+    }
+}
+
+//==================================================================
+bool ImageSystem::IsRebuildingComposite() const
+{
+    // results are posted before the job ends, so they're covered here
+    return mHasRebuildReq || mJobFuture.valid();
+}
+
+//==================================================================
+void ImageSystem::SetDisplayScale( float scale )
+{
+    mDispLevel = ImageTiler::CalcLevelForScale( scale, 8 );
+
+    // refine when zooming in, otherwise keep what we have until
+    //  the next rebuild
+    c_auto curLevel = mJobFuture.valid() ? mJobLevel : mCompositeLevel;
+    if ( mDispLevel < curLevel )
+        ReqRebuildComposite();
+}
+
@@ -0,0 +1,452 @@
+//==================================================================
+/// ImageSystem.h
+///
+/// Created by Davide Pasca - 2022/01/18
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef IMAGESYSTEM_H
+#define IMAGESYSTEM_H
+
+#include <map>
+#include <unordered_map>
+#include <deque>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "Image.h"
+#include "Image_EXR.h"
+#include "ImageAlphaStats.h"
+#include "FilePrefetcher.h"
+#include "ExportQueue.h"
+#include "DecodeCache.h"
+
+#ifdef ENABLE_OCIO
+class ImageSystemOCIO;
+#endif
+
+class SerialJS;
+class DeserialJS;
+
+//==================================================================
+struct ImageEntry
+{
+    friend class ImageSystem;
+
+    DStr            mImagePathFName;
+    u_int           mEntryID {};        // unique for the lifetime of the entry
+    bool            mIsImageEnabled { true };
+
+    DStr            mBaseImageCurLayer;
+    uptr<image>     moBaseImage;
+    // empty tiles of moBaseImage, for the images loaded as they are
+    uptr<ImageAlphaStats>   moBaseAlphaStats;
+
+    DStr            mAlphaImageCurlayer;
+    uptr<image>     moAlphaImage;
+#ifdef ENABLE_OPENEXR
+    uptr<ImageEXR>  moEXRImage;
+#endif
+private:
+    // mapped from the decode cache, for moBaseImage and moAlphaImage
+    uptr<DFileData> moBaseImageFile;
+    uptr<DFileData> moAlphaImageFile;
+
+    uptr<image>     moBaseImageScaled;
+    uptr<image>     moAlphaImageScaled;
+    // reduced levels, [0] is half resolution, built on demand
+    DVec<uptr<image>>   moBaseMips;
+    DVec<uptr<image>>   moAlphaMips;
+public:
+    ImageEntry() {}
+    // the file data is taken from the prefetcher, if it has it. The
+    //  image comes from the decode cache, if it's there
+    ImageEntry(
+        const DStr &pathFName,
+        FilePrefetcher *pPrefetcher=nullptr,
+        DecodeCache *pDecodeCache=nullptr );
+
+private:
+    void loadStdImage( FilePrefetcher *pPrefetcher, DecodeCache *pDecodeCache );
+    void loadEXRImage();
+
+    const image *getBaseMip( u_int level );
+    const image *getAlphaMip( u_int level );
+    // call when moBaseImage or moAlphaImage change
+    void resetDerivedImages();
+};
+
+//==================================================================
+class IMSConfig
+{
+public:
+    bool        imsc_useBilinear            { true };
+    bool        imsc_ccorRGBOnly            { true };
+    bool        imsc_ccorSRGB               { true };
+    DStr        imsc_ccorXform              { "none" };
+    DStr        imsc_ccorOCIOCfgFName       {};
+    DVec<DStr>  imsc_ccorOCIOCfgFNameHist   {};
+    DStr        imsc_ccorOCIODisp           {};
+    DStr        imsc_ccorOCIOView           {};
+    DStr        imsc_ccorOCIOLook           {};
+    DStr        imsc_texUploadFmt           { "half" };
+
+    friend bool operator==(const IMSConfig &l, const IMSConfig &r)
+    {
+        return
+            l.imsc_useBilinear          == r.imsc_useBilinear           &&
+            l.imsc_ccorRGBOnly          == r.imsc_ccorRGBOnly           &&
+            l.imsc_ccorSRGB             == r.imsc_ccorSRGB              &&
+            l.imsc_ccorXform            == r.imsc_ccorXform             &&
+            l.imsc_ccorOCIOCfgFName     == r.imsc_ccorOCIOCfgFName      &&
+            l.imsc_ccorOCIOCfgFNameHist == r.imsc_ccorOCIOCfgFNameHist  &&
+            l.imsc_ccorOCIODisp         == r.imsc_ccorOCIODisp          &&
+            l.imsc_ccorOCIOView         == r.imsc_ccorOCIOView          &&
+            l.imsc_ccorOCIOLook         == r.imsc_ccorOCIOLook          &&
+            l.imsc_texUploadFmt         == r.imsc_texUploadFmt          &&
+            true;
+    }
+
+    friend bool operator!=(const IMSConfig &l, const IMSConfig &r) { return !(l == r); }
+
+    void SetOCIOFName( const DStr &fname );
+    void SetOCIOXForm() { imsc_ccorXform = "ocio"; }
+private:
+    bool addOCIOFNameToHistory();
+public:
+    void Serialize( SerialJS &v_ ) const;
+    void Deserialize( DeserialJS &v_ );
+
+    friend void Serialize( SerialJS &v_, const IMSConfig &o_ ){ o_.Serialize(v_);   }
+    friend void Deserialize( DeserialJS &v_,   IMSConfig &o_ ){ o_.Deserialize(v_); }
+};
+
+//==================================================================
+// What the display does with the composites, on the main thread.
+//  Textures are kept in the images, see image::GetTextureID()
+//==================================================================
+class IMSDisplay
+{
+public:
+    virtual ~IMSDisplay() = default;
+
+    // a new composite to show, returns whether it's drawn in tiles
+    virtual bool OnInstallComposite( image &img, const IMSConfig &cfg ) = 0;
+    // a buffer that replaces another takes over its texture
+    virtual void OnReplaceComposite( image &newImg, image &oldImg ) = 0;
+    // the buffer is going away
+    virtual void OnFreeComposite( image &img ) = 0;
+};
+
+//==================================================================
+// for ImageSystem::SaveAllLayers()
+struct LayersSaveParams
+{
+    bool            lsp_isMultiPartEXR {};  // one file, otherwise a PNG per layer
+    bool            lsp_isHalf { true };    // for the EXR
+    PNGSaveParams   lsp_pngPar;
+};
+
+//==================================================================
+// for ImageSystem::SetupThumbs()
+struct ThumbsParams
+{
+    DStr    thp_dir;                                    // created if needed
+    size_t  thp_maxBytes    { (size_t)256 * 1024 * 1024 };
+    u_int   thp_size        { 96 };                     // of the longest side
+    u_int   thp_quality     { 80 };                     // of the lossy DLS
+};
+
+//==================================================================
+class ImageSystem
+{
+public:
+    inline static DStr          DUMMY_LAYER_NAME { "__default__" };
+    DVec<ImageEntry>            mEntries;           // sorted by path
+    uint64_t                    mEntriesGen {};     // bumped when mEntries or their
+                                                    //  enabled state change
+    uptr<image>                 moComposite;
+    u_int                       mCompositeLevel {}; // mip level of moComposite
+    u_int                       mCompositeFullW {}; // size at level 0
+    u_int                       mCompositeFullH {};
+    uint64_t                    mCompositeGen {};   // bumped when moComposite changes
+    bool                        mCompositeIsTiled {};// too big for one texture
+    DStr                        mCurSelPathFName;
+    IMSConfig                   mIMSCfg;
+#ifdef ENABLE_OCIO
+    uptr<ImageSystemOCIO>       moIS_OCIO;
+#endif
+
+    DStr                        mCurLayerName;
+    DStr                        mCurLayerAlphaName;
+
+    bool                        mHasRebuildReq = false;
+    u_int                       mDispLevel {};  // coarsest level that the display needs
+
+    // called from the worker threads when their results are ready
+    DFun<void ()>               mOnWorkDoneFn;
+
+    // none in the tools that run without a display
+    uptr<IMSDisplay>            moDisplay;
+
+    // saves of the composite, in the background
+    uptr<ExportQueue>           moExportQueue;
+
+    struct PlaybackStats
+    {
+        size_t  ps_shownN {};
+        size_t  ps_droppedN {};     // due, but not ready in time
+        size_t  ps_ringN {};        // ready ahead of the playhead
+        double  ps_actualFPS {};
+    };
+
+private:
+    struct BuiltComposite
+    {
+        uptr<image> bc_oImage;
+        uptr<image> bc_oRetired;    // replaced buffer, still owning its texture
+        uint64_t    bc_gen {};      // of the job that built it
+        uint64_t    bc_flowID {};   // links its trace events across threads
+        u_int       bc_level {};
+        u_int       bc_fullW {};
+        u_int       bc_fullH {};
+        bool        bc_isComplete {};
+    };
+
+    // thumbnails of the entries, 8 bit RGB
+    struct Thumb
+    {
+        uptr<image> th_oImage;              // null if there's none to be had
+        DStr        th_variant;             // layer and color correction, see makeThumbVariant()
+        uint64_t    th_layerImagesGen {};   // of when it was found missing
+        uint64_t    th_gen {};
+    };
+    struct ThumbJobItem
+    {
+        ImageEntry  *tji_pEntry {};
+        DStr        tji_variant;
+        bool        tji_canMake {};     // its image is of the layer
+        bool        tji_doColorCorr {};
+    };
+    struct ThumbResult
+    {
+        u_int       tr_entryID {};
+        DStr        tr_variant;
+        uint64_t    tr_layerImagesGen {};   // of when the job started
+        uptr<image> tr_oImage;
+    };
+
+    // lookups into mEntries, see updateEntryIndex()
+    u_int                           mLastEntryID {};
+    std::unordered_map<DStr,size_t> mEntryIdxByPath;
+    std::unordered_map<u_int,size_t> mEntryIdxByID;
+    DVec<size_t>                    mNextEnabledIdx;    // nearest enabled after i, or DNPOS
+    DVec<size_t>                    mPrevEnabledIdx;    // nearest enabled before i, or DNPOS
+    size_t                          mFirstEnabledIdx = DNPOS;
+    size_t                          mLastEnabledIdx = DNPOS;
+    uint64_t                        mEntryIndexGen = (uint64_t)-1;
+    // bumped when loadEntryLayers() changes the images of the entries
+    uint64_t                        mLayerImagesGen {};
+
+    // reads the files of the entries to come, ahead of their decoding
+    uptr<FilePrefetcher>            moPrefetcher;
+    // decoded images from the previous runs, if set up
+    uptr<DecodeCache>               moDecodeCache;
+
+    // thumbnails are made in the background when nothing else runs, and
+    //  kept on disk as lossy DLS
+    ThumbsParams                    mThumbsPar;
+    uptr<DecodeCache>               moThumbCache;
+    std::unordered_map<u_int,Thumb> mThumbs;            // by entry ID
+    DVec<u_int>                     mThumbReqIDs;
+    uint64_t                        mLastThumbGen {};
+    uint64_t                        mThumbsEntriesGen = (uint64_t)-1;
+    std::future<void>               mThumbFuture;
+    DVec<ThumbResult>               mThumbResults;      // under mJobMutex
+
+    // what SaveComposite() and SaveAllLayers() save is built by a job that
+    //  holds the entries. It's cancelled with the composite, see mJobGenLatest
+    std::future<void>               mSaveFuture;
+    bool                            mIsSavingLayers {};
+    std::atomic<size_t>             mSaveLayersDoneN {};
+    size_t                          mSaveLayersTotN {};
+
+    // composites are built by a background job. Each rebuild starts a new
+    //  generation, and a job stops at its next band once it's not the latest
+    std::atomic<uint64_t>       mJobGenLatest {};
+    std::future<void>           mJobFuture;
+    u_int                       mJobLevel {};
+
+    std::mutex                  mJobMutex;
+    DVec<BuiltComposite>        mJobResults;        // posted by the job
+    DVec<uptr<image>>           moSpareComposites;  // buffers to build into
+
+    // flipbook playback, frames are built ahead of the playhead
+    struct PlayFrame
+    {
+        BuiltComposite  pf_bc;
+        size_t          pf_frameIdx {};     // counting from the start, loops included
+        DStr            pf_pathFName;       // last image in the frame
+    };
+    std::future<void>           mPlayFuture;
+    std::deque<PlayFrame>       mPlayRing;          // under mJobMutex
+    std::condition_variable     mPlayRingCV;
+    std::atomic<size_t>         mPlayDueFrameIdx {};
+    double                      mPlayFPS {};
+    double                      mPlayStartS {};
+    double                      mPlayLastShownS {};
+    size_t                      mPlayNextFrameIdx {};
+    PlaybackStats               mPlayStats;
+
+public:
+    ImageSystem( const IMSConfig &initCfg={} );
+    ~ImageSystem();
+
+    bool OnNewScanDir( const DStr &path, const DStr &selPathFName );
+
+    // images of a folder that can go in a composite, sorted by name
+    static DVec<DStr> FindDirImages( const DStr &path );
+    // replaces the entries, loaded in parallel, and selects the last
+    void SetImages( const DVec<DStr> &pathFNames );
+
+    // queues the save of a snapshot of the full resolution composite. If
+    //  the display isn't showing it, it's built by a background job first.
+    //  Returns false if there's nothing to save or the previous save is
+    //  still building
+    bool SaveComposite( const DStr &path, const PNGSaveParams &par={} );
+    // true while SaveComposite() is building the composite
+    bool IsBuildingSaveComposite() const { return mSaveFuture.valid() && !mIsSavingLayers; }
+    // the composites of each layer of the stack up to the selection,
+    //  built in parallel by a background job, then saved by moExportQueue.
+    //  A rebuild of the composite cancels it. Returns the number of layers
+    //  to build, or 0 if there's nothing to save or the previous save is
+    //  still building
+    size_t SaveAllLayers( const DStr &path, const LayersSaveParams &par={} );
+    // true while SaveAllLayers() is building the layers
+    bool GetSaveLayersProgress( size_t &out_doneN, size_t &out_totN ) const;
+
+    // keep the decoded images on disk, for the next runs. Call before
+    //  loading anything. Later calls only change the size limit
+    void SetupDecodeCache( const DecodeCacheParams &par );
+
+    // small images of the entries for the current layer, made at low
+    //  priority and kept on disk. Later calls only change the size limit
+    void SetupThumbs( const ThumbsParams &par );
+    // the entries that want a thumbnail, i.e. the ones in view. Replaces
+    //  the previous request
+    void RequestThumbs( const DVec<u_int> &entryIDs );
+    // null until it's ready. The generation changes with the image
+    const image *GetThumb( u_int entryID, uint64_t *pOut_gen=nullptr ) const;
+
+    // index in mEntries, or DNPOS
+    size_t FindEntryIdx( const DStr &pathFName );
+
+    // in or out of the composite, which is rebuilt
+    void SetEntryEnabled( u_int entryID, bool onOff );
+    void SetAllEntriesEnabled( bool onOff );
+
+    bool IncCurSel( int step );
+    void SetFirstCurSel();
+    void SetLastCurSel();
+
+    void ReqRebuildComposite();
+    void ReqRebuildComposite( const IMSConfig &cfg );
+
+    void AnimateIMS();
+
+    bool IsRebuildingComposite() const;
+
+    // screen pixels per full resolution pixel of the composite
+    void SetDisplayScale( float scale );
+
+    // step through the enabled images, one more blended in at each frame
+    void StartPlayback( double fps );
+    void StopPlayback();
+    bool IsPlaying() const { return mPlayFuture.valid(); }
+    const PlaybackStats &GetPlaybackStats() const { return mPlayStats; }
+
+    // the composite up to the current selection, built on the calling
+    //  thread and not displayed. For tools and benchmarks
+    uptr<image> MakeCompositeNow( u_int level=0 );
+    // the color correction of the config, on a float RGB image
+    void ApplyColorCorr( image &img );
+
+private:
+    void updateEntryIndex();
+    void selectEntryIdx( size_t idx );
+    void prefetchFiles( const DVec<DStr> &pathFNames );
+
+    void makeDummyComposite();
+#ifdef ENABLE_OPENEXR
+    DStr makeLayerImageKey( const ImageEntry &ie, const DStr &layerName, bool isAlpha ) const;
+    uptr<image> makeLayerImage(
+            ImageEntry &ie,
+            ImageEXRLayer &layer,
+            bool isAlpha,
+            uptr<DFileData> &out_oFile );
+#endif
+    bool loadEntryLayers();
+    size_t collectEntries( DVec<ImageEntry *> &out_pEntries );
+    void rebuildComposite( u_int level, bool allowProgressive );
+    bool makeComposite(
+            BuiltComposite &out,
+            const DVec<ImageEntry *> &pEntries,
+            size_t n,
+            u_int level,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr,
+            const DFun<bool ()> &isCancelled,
+            size_t startI=0 );
+    void applyColorCorrOCIO( image &img, const IMSConfig &cfg );
+    static void setupCompositeImage( BuiltComposite &bc, const image::Params &par );
+    void adoptRetiredTexture( BuiltComposite &bc );
+    uptr<image> takeSpareComposite();
+    void recycleComposite( BuiltComposite &&bc );
+    void freeCompositeImage( image &img );
+    void installComposite( BuiltComposite &&bc );
+    void postJobResult( BuiltComposite &&bc );
+    void installJobResults();
+    void waitJob();
+    void cancelJob();
+
+    DStr makeThumbVariant( const ImageEntry &e, bool *pOut_doColorCorr=nullptr ) const;
+    uptr<image> makeThumbImage(
+            ImageEntry &e,
+            u_int size,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr );
+    void startThumbJob();
+    void installThumbResults();
+
+    bool startSaveCompositeJob( const DStr &pathFName, const PNGSaveParams &par );
+
+    void saveLayersJob(
+            const DVec<ImageEntry *> &pRange,
+            const DVec<DStr> &layerNames,
+            const DVec<U8> &doLayersCCor,
+            const DStr &path,
+            const LayersSaveParams &par,
+            const IMSConfig &cfg,
+            const DFun<bool ()> &isCancelled );
+
+    bool makePlayFrame(
+            BuiltComposite &out,
+            const BuiltComposite &acc,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr,
+            const DFun<bool ()> &isCancelled );
+    void playbackJob(
+            const DVec<ImageEntry *> &pEntries,
+            u_int level,
+            const IMSConfig &cfg,
+            bool doApplyColorCorr,
+            uint64_t gen );
+    void stopPlayback();
+    void animatePlayback();
+};
+
+
+#endif
+
@@ -192,6 +192,8 @@ create_package_linux(){
 
 	strip -s _bin/xcomp -o ${PACKAGELINUXDIR}/bin/xcomp
 	chrpath -d ${PACKAGELINUXDIR}/bin/xcomp
+	strip -s _bin/xcomp-batch -o ${PACKAGELINUXDIR}/bin/xcomp-batch
+	chrpath -d ${PACKAGELINUXDIR}/bin/xcomp-batch
 
     OCIO_SO_DIR=externals/local/ocio/_build/Release/src/OpenColorIO
     OCIO_SO_NAME=libOpenColorIO.so.2.2
@@ -327,7 +329,8 @@ create_package_win(){
     mkdir -p ${PACKAGEWIN32DIR}/share/fonts
     mkdir -p ${PACKAGEWIN32DIR}/other
 
-    cp _bin/Release/xcomp* ${PACKAGEWIN32DIR}/bin
+    cp _bin/Release/xcomp.* ${PACKAGEWIN32DIR}/bin
+    cp _bin/Release/xcomp-batch.exe ${PACKAGEWIN32DIR}/bin
 
     cp _bin/Release/OpenColorIO_2_2.dll ${PACKAGEWIN32DIR}/bin
 
@@ -10,6 +10,7 @@
 #include <memory.h>
 
 #include "DUT_Files.h"
+#include "DTrace.h"
 
 #include "Image_DLS.h"
 #include "Image_RGBE.h"
@@ -53,6 +54,10 @@ image &image::operator=( const image &from )
 image &image::operator=( image &&from ) noexcept
 {
     mImageTexID0    = std::move( from.mImageTexID0 );
+    mImageTexW0     = std::move( from.mImageTexW0 );
+    mImageTexH0     = std::move( from.mImageTexH0 );
+    mImageTexFmt0   = std::move( from.mImageTexFmt0 );
+    mImageTexType0  = std::move( from.mImageTexType0 );
     mTexWd          = std::move( from.mTexWd );
     mTexHe          = std::move( from.mTexHe );
     mTexS2          = std::move( from.mTexS2 );
@@ -361,6 +366,8 @@ void image::reload_loadFileData(
         size_t      &out_dataSize,
         DFileData   &out_fileData ) const
 {
+    DTR_SCOPE( "image_read_file" );
+
     if ( mLoadParams.mLP_DataSrc.size() )
     {
         out_pData    = &mLoadParams.mLP_DataSrc[0];
@@ -370,7 +377,8 @@ void image::reload_loadFileData(
     {
         const auto *pFName = mLoadParams.mLP_FName.c_str();
 
-        if NOT( DUT::GrabFile( pFName, out_fileData, fxSize ) )
+        // mapped, the decoders read straight from the page cache
+        if NOT( DUT::MapFile( pFName, out_fileData, fxSize ) )
             DEX_RUNTIME_ERROR( "Cloud not load '%s'", pFName );
 
         out_pData    = out_fileData.pData;
@@ -464,6 +472,8 @@ void image::reload_Other( const char *pExt )
 //==================================================================
 void image::reloadImage( ImgDLS::ImgDLS_Head1 *pOut_Head )
 {
+    DTR_SCOPE( "image_load" );
+
 	const char *pExt = DUT::GetFileNameExt( mLoadParams.mLP_FName.c_str() );
 
     // initialize the header all to 0, so that by looking at some
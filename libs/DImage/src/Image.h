@@ -27,6 +27,7 @@ class image
     friend class ImageUploader;
     friend class VolatileTextureCache;
     friend class Graphics;
+    friend class TexStreamer;
 
     static DFun<void (image *)> msOnImageDestructFn;
     static DFun<u_int (const image *)> msOnImageGetTempTexIDFn;
@@ -34,6 +35,11 @@ class image
 private:
     // OpenGL texture-related stuff
     mutable u_int mImageTexID0 = (u_int)-1;
+    // storage currently allocated for the texture, to update it in place
+    mutable u_int mImageTexW0 = 0;
+    mutable u_int mImageTexH0 = 0;
+    mutable u_int mImageTexFmt0 = 0;
+    mutable u_int mImageTexType0 = 0;
 public:
     u_int       mTexWd = 0;
     u_int       mTexHe = 0;
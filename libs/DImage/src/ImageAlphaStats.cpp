@@ -0,0 +1,155 @@
+//==================================================================
+/// ImageAlphaStats.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <algorithm>
+#include "Image.h"
+#include "ImageAlphaStats.h"
+
+// what a tile has seen, as bits
+static constexpr U8 IAS_SEEN_ZERO   = 1 << 0;
+static constexpr U8 IAS_SEEN_FULL   = 1 << 1;
+static constexpr U8 IAS_SEEN_PART   = 1 << 2;
+
+//==================================================================
+ImageAlphaStats::ImageAlphaStats( u_int tileDim )
+    : mTileDim(tileDim)
+{
+    DASSERT( mTileDim > 0 );
+}
+
+//==================================================================
+void ImageAlphaStats::Setup( u_int w, u_int h )
+{
+    mW      = w;
+    mH      = h;
+    mTilesW = (w + mTileDim - 1) / mTileDim;
+    mTilesH = (h + mTileDim - 1) / mTileDim;
+
+    mTiles.assign( (size_t)mTilesW * mTilesH, TILE_OPAQUE );
+    mRowSeen.assign( mTilesW, 0 );
+}
+
+//==================================================================
+template <typename T>
+static void iasSeeRow(
+            U8 *pSeen,
+            const T *pRow,
+            u_int w,
+            u_int chans,
+            int alphaChan,
+            T fullVal,
+            u_int tileDim )
+{
+    c_auto *pA = pRow + alphaChan;
+
+    for (u_int x=0, tx=0; x < w; x += tileDim, ++tx)
+    {
+        c_auto x2 = std::min( x + tileDim, w );
+
+        U8 seen = 0;
+        for (u_int xx=x; xx < x2; ++xx)
+        {
+            c_auto a = pA[ (size_t)xx * chans ];
+            seen |= a == T(0) ? IAS_SEEN_ZERO : (a >= fullVal ? IAS_SEEN_FULL : IAS_SEEN_PART);
+        }
+
+        pSeen[tx] |= seen;
+    }
+}
+
+//==================================================================
+void ImageAlphaStats::AddRow(
+            u_int y,
+            const void *pRow,
+            ImageConv::ChanType ct,
+            u_int chans,
+            int alphaChan )
+{
+    DASSERT( y < mH );
+
+    if ( alphaChan >= 0 )
+    {
+        switch ( ct )
+        {
+        case ImageConv::CHANTYPE_U8:
+            iasSeeRow( mRowSeen.data(), (const U8 *)pRow, mW, chans, alphaChan, (U8)255, mTileDim );
+            break;
+        case ImageConv::CHANTYPE_U16:
+            iasSeeRow( mRowSeen.data(), (const U16 *)pRow, mW, chans, alphaChan, (U16)65535, mTileDim );
+            break;
+        case ImageConv::CHANTYPE_F32:
+            iasSeeRow( mRowSeen.data(), (const float *)pRow, mW, chans, alphaChan, 1.f, mTileDim );
+            break;
+        default:
+            // can't tell, assume it's all there
+            for (auto &s : mRowSeen)
+                s |= IAS_SEEN_PART;
+            break;
+        }
+    }
+    else
+    {
+        for (auto &s : mRowSeen)
+            s |= IAS_SEEN_FULL;
+    }
+
+    if ( (y + 1) % mTileDim == 0 || (y + 1) == mH )
+        closeTileRow( y / mTileDim );
+}
+
+//==================================================================
+void ImageAlphaStats::closeTileRow( u_int ty )
+{
+    auto *pTiles = &mTiles[ (size_t)ty * mTilesW ];
+
+    for (u_int tx=0; tx < mTilesW; ++tx)
+    {
+        c_auto seen = mRowSeen[tx];
+
+        pTiles[tx] = seen == IAS_SEEN_ZERO ? TILE_EMPTY
+                   : seen == IAS_SEEN_FULL ? TILE_OPAQUE
+                                           : TILE_MIXED;
+        mRowSeen[tx] = 0;
+    }
+}
+
+//==================================================================
+void ImageAlphaStats::AddImage( const image &img )
+{
+    Setup( img.mW, img.mH );
+
+    c_auto ct = ImageConv::GetChanType( img );
+    c_auto alphaChan = (img.mChans == 4 || img.mChans == 2) ? (int)img.mChans - 1 : -1;
+
+    for (u_int y=0; y < img.mH; ++y)
+        AddRow( y, img.GetPixelPtr( 0, y ), ct, img.mChans, alphaChan );
+}
+
+//==================================================================
+bool ImageAlphaStats::AreRowsEmpty( u_int y1, u_int y2 ) const
+{
+    if ( y1 >= y2 || y2 > mH )
+        return false;
+
+    c_auto ty1 = y1 / mTileDim;
+    c_auto ty2 = (y2 - 1) / mTileDim;
+
+    for (u_int ty=ty1; ty <= ty2; ++ty)
+        for (u_int tx=0; tx < mTilesW; ++tx)
+            if ( GetTile( tx, ty ) != TILE_EMPTY )
+                return false;
+
+    return true;
+}
+
+//==================================================================
+size_t ImageAlphaStats::CountTiles( U8 type ) const
+{
+    return (size_t)std::count( mTiles.begin(), mTiles.end(), type );
+}
+
@@ -0,0 +1,73 @@
+//==================================================================
+/// ImageAlphaStats.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef IMAGEALPHASTATS_H
+#define IMAGEALPHASTATS_H
+
+#include "DBase.h"
+#include "DContainers.h"
+#include "ImageConv.h"
+
+//==================================================================
+// Which tiles of an image are fully transparent, fully opaque or in
+//  between. Built a row at a time, so that decoders can fill it as
+//  they go. Images with no alpha are all opaque.
+//==================================================================
+class ImageAlphaStats
+{
+public:
+    enum : U8
+    {
+        TILE_EMPTY,
+        TILE_MIXED,
+        TILE_OPAQUE,
+    };
+
+private:
+    u_int       mTileDim    {};
+    u_int       mW          {};
+    u_int       mH          {};
+    u_int       mTilesW     {};
+    u_int       mTilesH     {};
+    DVec<U8>    mTiles;
+    // what was seen in the tiles of the current tile row
+    DVec<U8>    mRowSeen;
+
+public:
+    ImageAlphaStats( u_int tileDim=64 );
+
+    void Setup( u_int w, u_int h );
+
+    // rows must come in order from the top. alphaChan is -1 if none
+    void AddRow(
+            u_int y,
+            const void *pRow,
+            ImageConv::ChanType ct,
+            u_int chans,
+            int alphaChan );
+
+    // all the rows, for images that weren't decoded a row at a time
+    void AddImage( const image &img );
+
+    u_int GetTileDim() const { return mTileDim; }
+    u_int GetTilesW() const { return mTilesW; }
+    u_int GetTilesH() const { return mTilesH; }
+
+    U8 GetTile( u_int tx, u_int ty ) const { return mTiles[ (size_t)ty * mTilesW + tx ]; }
+
+    // for an image of the same size, if all the rows in [y1, y2) are empty
+    bool AreRowsEmpty( u_int y1, u_int y2 ) const;
+
+    size_t CountTiles( U8 type ) const;
+
+private:
+    void closeTileRow( u_int ty );
+};
+
+#endif
+
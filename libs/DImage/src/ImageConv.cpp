@@ -168,6 +168,12 @@ void BlitConvertFormat(
         return;
     }
 
+    if ( fn == nullptr && CanConvertFormat( srcImg, desImg ) )
+    {
+        ConvertFormat( srcImg, sx, sy, desImg, dx, dy, dw, dh );
+        return;
+    }
+
     // making it really explicit that it's constant stuff..
     // hoping that the compiler will move conditionals outside
     // the loop
@@ -213,6 +219,16 @@ void BlitQuarter(
     DASSERT( checkBlitBounds( srcImg, sx, sy, desImg, dx, dy, dw, dh ) );
 	DASSERT( desImg.mDepth == srcImg.mDepth );
 
+    // half and float, 2x2 box through the resampler
+    if ( srcImg.IsFloat16() || srcImg.IsFloat32() )
+    {
+        BlitResample(
+            srcImg, sx, sy, dw * 2, dh * 2,
+            desImg, dx, dy, dw, dh,
+            RESAMPLE_BOX );
+        return;
+    }
+
 	DASSERT(
 			desImg.mDepth == 8 ||
 			desImg.mDepth == 16 ||
@@ -470,6 +486,16 @@ void BlitStretch(
         int dx, int dy,
         int dw, int dh )
 {
+    // use the separable resampler, when the formats allow it
+    if ( CanBlitResample( srcImg, desImg ) )
+    {
+        BlitResample(
+            srcImg, sx, sy, sw, sh,
+            desImg, dx, dy, dw, dh,
+            RESAMPLE_BOX );
+        return;
+    }
+
     // allow blitting between float formats (16 and 32)
     DASSERT(
         (srcImg.IsFloat16() || srcImg.IsFloat32()) ==
@@ -655,6 +681,15 @@ uptr<image> Create8BitImage( const image &srcImg )
         return oImg;
     }
 
+    // half, float and 16 bit go through the row converters
+    if ( CanConvertFormat( srcImg, *oImg ) )
+    {
+        ConvertParams cpar;
+        cpar.doClamp = true;
+        ConvertFormat( srcImg, *oImg, cpar );
+        return oImg;
+    }
+
     DASSERT( bitsPerChan == 16 || bitsPerChan == 32 );
 
     int chansN = (int)srcImg.mChans;
@@ -56,6 +56,36 @@ inline void BlitStretch( const image &srcImg, image &desImg )
                  desImg, 0, 0, (int)desImg.mW, (int)desImg.mH );
 }
 
+//==================================================================
+enum ResampleFilter
+{
+    RESAMPLE_BOX,       // area average
+    RESAMPLE_BILINEAR,  // tent, widened when minifying
+    RESAMPLE_LANCZOS3,  // sharper, may ring on hard edges
+};
+
+// Resampling works on any of the ChanType, with the same number of
+//  channels on source and destination. Source and destination can differ
+//  in channel type, integer types are normalized as in ChanRowToFloat().
+bool CanBlitResample( const image &srcImg, const image &desImg );
+
+// Separable resample of a source rect into a destination rect
+// Negative dw or dh flip the destination horizontally or vertically
+void BlitResample(
+        const image &srcImg,
+        int sx, int sy,
+        int sw, int sh,
+        image &desImg,
+        int dx, int dy,
+        int dw, int dh,
+        ResampleFilter filter );
+
+inline void BlitResample( const image &srcImg, image &desImg, ResampleFilter filter )
+{
+    BlitResample( srcImg, 0, 0, (int)srcImg.mW, (int)srcImg.mH,
+                  desImg, 0, 0, (int)desImg.mW, (int)desImg.mH, filter );
+}
+
 void BlitConvertToAlpha(
 		const image &srcImg,
 		int sx, int sy,
@@ -66,14 +96,81 @@ void BlitConvertToAlpha(
 void FlipY( image &img );
 
 //==================================================================
-template <typename _TS, typename _TD>
+// Channel types handled by the format conversion and the resampler
+enum ChanType
+{
+    CHANTYPE_UNKNOWN,   // packed or YUV formats
+    CHANTYPE_U8,
+    CHANTYPE_U16,
+    CHANTYPE_F16,
+    CHANTYPE_F32,
+};
+
+ChanType GetChanType( const image &img );
+size_t GetChanTypeSize( ChanType ct );
+
+// Row of n channel values to and from floats. Integer types map to [0..1],
+//  and are rounded and saturated on the way back.
+void ChanRowToFloat( float *pDes, const void *pSrc, ChanType srcCT, size_t n );
+void ChanRowFromFloat( void *pDes, ChanType desCT, const float *pSrc, size_t n );
+
+//==================================================================
+struct ConvertParams
+{
+    // source channel for each destination channel, -1 to fill.
+    // Single channel sources go into all the RGB channels
+    int     swizzle[image::MAX_CHANS] { 0, 1, 2, 3 };
+    // value for the destination channels with no source (i.e. alpha)
+    float   fillVal = 1.f;
+    // applied to the normalized values, before the clamp
+    float   scale   = 1.f;
+    // clamp to [0..1]
+    bool    doClamp = false;
+};
+
+bool CanConvertFormat( const image &srcImg, const image &desImg );
+
+// Convert between any of the ChanType, with 1 to 4 channels
+void ConvertFormat(
+        const image &srcImg,
+        int sx, int sy,
+        image &desImg,
+        int dx, int dy,
+        int dw, int dh,
+        const ConvertParams &par={} );
+
+inline void ConvertFormat(
+        const image &srcImg,
+        image &desImg,
+        const ConvertParams &par={} )
+{
+    ConvertFormat( srcImg, 0, 0, desImg, 0, 0, (int)desImg.mW, (int)desImg.mH, par );
+}
+
+// Single row version, for raw buffers
+void ConvertFormatRow(
+        void *pDes,
+        ChanType desCT,
+        u_int desChans,
+        const void *pSrc,
+        ChanType srcCT,
+        u_int srcChans,
+        size_t w,
+        const ConvertParams &par={} );
+
+//==================================================================
+// The processing functions below take any callable, so that the per-pixel
+//  body can be inlined. The "Rows" variants call fn once per row, with
+//  the width in pixels, and leave the inner loop to the caller.
+//==================================================================
+template <typename _TS, typename _TD, typename _FN>
 inline void BlitProcess(
         const image &srcImg,
         int sx, int sy,
         image &desImg,
         int dx, int dy,
         int dw, int dh,
-        std::function<void (const _TS *pSrc, _TD *pDes)> fn )
+        _FN &&fn ) // void (const _TS *pSrc, _TD *pDes)
 {
     const ptrdiff_t sRowInc = srcImg.mBytesPerRow;
           ptrdiff_t dRowInc = desImg.mBytesPerRow;
@@ -116,20 +213,67 @@ inline void BlitProcess(
 }
 
 //==================================================================
-template <typename _TS, typename _TD>
+template <typename _TS, typename _TD, typename _FN>
 DFORCEINLINE void BlitProcess(
         const image &srcImg,
         image &desImg,
-        std::function<void (const _TS *pSrc, _TD *pDes)> fn )
+        _FN &&fn )
+{
+    BlitProcess<_TS,_TD>(
+        srcImg, 0, 0, desImg, 0, 0, (int)desImg.mW, (int)desImg.mH,
+        std::forward<_FN>( fn ) );
+}
+
+//==================================================================
+template <typename _TS, typename _TD, typename _FN>
+inline void BlitProcessRows(
+        const image &srcImg,
+        int sx, int sy,
+        image &desImg,
+        int dx, int dy,
+        int dw, int dh,
+        _FN &&fn ) // void (const _TS *pSrcRow, _TD *pDesRow, u_int w)
+{
+    DASSERT( dw >= 0 ); // no horizontal flip on rows
+
+    const ptrdiff_t sRowInc = srcImg.mBytesPerRow;
+          ptrdiff_t dRowInc = desImg.mBytesPerRow;
+
+    const U8 *pSrcLine = srcImg.GetPixelPtr( sx, sy );
+          U8 *pDesLine = desImg.GetPixelPtr( dx, dy );
+
+    if ( dh < 0 )
+    {
+        dh = -dh;
+        pDesLine += (dh-1) * dRowInc; // to bottommost row
+        dRowInc = -dRowInc; // invert row increment
+    }
+
+	for (int yi=0; yi < dh; ++yi)
+	{
+        fn( (const _TS *)pSrcLine, (_TD *)pDesLine, (u_int)dw );
+        pSrcLine += sRowInc;
+        pDesLine += dRowInc;
+    }
+}
+
+//==================================================================
+template <typename _TS, typename _TD, typename _FN>
+DFORCEINLINE void BlitProcessRows(
+        const image &srcImg,
+        image &desImg,
+        _FN &&fn )
 {
-    BlitProcess( srcImg, 0, 0, desImg, 0, 0, (int)desImg.mW, (int)desImg.mH, fn );
+    BlitProcessRows<_TS,_TD>(
+        srcImg, 0, 0, desImg, 0, 0, (int)desImg.mW, (int)desImg.mH,
+        std::forward<_FN>( fn ) );
 }
 
 //==================================================================
-template <typename _T>
+template <typename _T, typename _FN>
 inline void RectProcess(
         const image &img,
-        std::function<void (const _T *pPix)> fn,
+        _FN &&fn, // void (const _T *pPix)
         u_int x=0,
         u_int y=0,
         u_int w=(u_int)-1,
@@ -159,10 +303,10 @@ inline void RectProcess(
 }
 
 //==================================================================
-template <typename _T>
+template <typename _T, typename _FN>
 inline void RectProcess(
         image &img,
-        std::function<void (_T *pPix)> fn,
+        _FN &&fn, // void (_T *pPix)
         u_int x=0,
         u_int y=0,
         u_int w=(u_int)-1,
@@ -192,10 +336,58 @@ inline void RectProcess(
 }
 
 //==================================================================
-template <typename _T>
+template <typename _T, typename _FN>
+inline void RectProcessRows(
+        const image &img,
+        _FN &&fn, // void (const _T *pRow, u_int w)
+        u_int x=0,
+        u_int y=0,
+        u_int w=(u_int)-1,
+        u_int h=(u_int)-1 )
+{
+    if ( w == (u_int)-1 ) w = img.mW;
+    if ( h == (u_int)-1 ) h = img.mH;
+
+    const size_t bprow = img.mBytesPerRow;
+
+    const U8 *pLine = img.GetPixelPtr( x, y );
+
+	for (u_int yi=0; yi < h; ++yi)
+	{
+        fn( (const _T *)pLine, w );
+        pLine += bprow;
+    }
+}
+
+//==================================================================
+template <typename _T, typename _FN>
+inline void RectProcessRows(
+        image &img,
+        _FN &&fn, // void (_T *pRow, u_int w)
+        u_int x=0,
+        u_int y=0,
+        u_int w=(u_int)-1,
+        u_int h=(u_int)-1 )
+{
+    if ( w == (u_int)-1 ) w = img.mW;
+    if ( h == (u_int)-1 ) h = img.mH;
+
+    const size_t bprow = img.mBytesPerRow;
+
+    U8 *pLine = img.GetPixelPtr( x, y );
+
+	for (u_int yi=0; yi < h; ++yi)
+	{
+        fn( (_T *)pLine, w );
+        pLine += bprow;
+    }
+}
+
+//==================================================================
+template <typename _T, typename _FN>
 inline void RectProcessUV(
         image &img,
-        std::function<void (_T *pPix, float u, float v)> fn,
+        _FN &&fn, // void (_T *pPix, float u, float v)
         u_int x=0,
         u_int y=0,
         u_int w=(u_int)-1,
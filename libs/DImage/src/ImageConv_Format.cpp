@@ -0,0 +1,426 @@
+//==================================================================
+/// ImageConv_Format.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include "stdafx.h"
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define IMF_USE_SSE2
+# include <emmintrin.h>
+#endif
+#if defined(IMF_USE_SSE2) && defined(__F16C__)
+# define IMF_USE_F16C
+# include <immintrin.h>
+#endif
+#include "DHalf.h"
+#include "DThreads.h"
+#include "ImageConv.h"
+
+//==================================================================
+namespace ImageConv
+{
+
+//==================================================================
+namespace
+{
+
+// pixels converted at a time, so that the float rows stay in the L1
+static constexpr size_t IMF_CHUNK_PIX = 256;
+
+// roughly how many samples a band of work should have, to be worth a thread
+static constexpr size_t IMF_MIN_BAND_SAMPLES = 128 * 1024;
+
+//==================================================================
+static void imfU8ToFloat( float *pDes, const U8 *pSrc, size_t n )
+{
+    size_t i = 0;
+#ifdef IMF_USE_SSE2
+    c_auto zero = _mm_setzero_si128();
+    c_auto sca  = _mm_set1_ps( 1.f/255 );
+    for (; (i+16) <= n; i += 16)
+    {
+        c_auto v8 = _mm_loadu_si128( (const __m128i *)(pSrc + i) );
+        c_auto lo = _mm_unpacklo_epi8( v8, zero );
+        c_auto hi = _mm_unpackhi_epi8( v8, zero );
+        _mm_storeu_ps( pDes+i+ 0, _mm_mul_ps( sca, _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ) ) );
+        _mm_storeu_ps( pDes+i+ 4, _mm_mul_ps( sca, _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ) ) );
+        _mm_storeu_ps( pDes+i+ 8, _mm_mul_ps( sca, _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ) ) );
+        _mm_storeu_ps( pDes+i+12, _mm_mul_ps( sca, _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ) ) );
+    }
+#endif
+    for (; i < n; ++i)
+        pDes[i] = (float)pSrc[i] * (1.f/255);
+}
+
+//==================================================================
+static void imfU16ToFloat( float *pDes, const U16 *pSrc, size_t n )
+{
+    size_t i = 0;
+#ifdef IMF_USE_SSE2
+    c_auto zero = _mm_setzero_si128();
+    c_auto sca  = _mm_set1_ps( 1.f/65535 );
+    for (; (i+8) <= n; i += 8)
+    {
+        c_auto v16 = _mm_loadu_si128( (const __m128i *)(pSrc + i) );
+        _mm_storeu_ps( pDes+i+0, _mm_mul_ps( sca, _mm_cvtepi32_ps( _mm_unpacklo_epi16( v16, zero ) ) ) );
+        _mm_storeu_ps( pDes+i+4, _mm_mul_ps( sca, _mm_cvtepi32_ps( _mm_unpackhi_epi16( v16, zero ) ) ) );
+    }
+#endif
+    for (; i < n; ++i)
+        pDes[i] = (float)pSrc[i] * (1.f/65535);
+}
+
+//==================================================================
+static void imfF16ToFloat( float *pDes, const U16 *pSrc, size_t n )
+{
+    size_t i = 0;
+#ifdef IMF_USE_F16C
+    for (; (i+8) <= n; i += 8)
+    {
+        c_auto v16 = _mm_loadu_si128( (const __m128i *)(pSrc + i) );
+        _mm_storeu_ps( pDes+i+0, _mm_cvtph_ps( v16 ) );
+        _mm_storeu_ps( pDes+i+4, _mm_cvtph_ps( _mm_unpackhi_epi64( v16, v16 ) ) );
+    }
+#endif
+    for (; i < n; ++i)
+        pDes[i] = HALF::HalfToFloat( pSrc[i] );
+}
+
+//==================================================================
+static void imfFloatToU8( U8 *pDes, const float *pSrc, size_t n )
+{
+    size_t i = 0;
+#ifdef IMF_USE_SSE2
+    // clamp in float (also gets rid of NaNs), round to nearest, pack
+    c_auto sca = _mm_set1_ps( 255.f );
+    c_auto zer = _mm_setzero_ps();
+    auto cvt = [&]( const float *p )
+    {
+        return _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( p ), sca ), zer ), sca ) );
+    };
+    for (; (i+16) <= n; i += 16)
+    {
+        c_auto i0 = cvt( pSrc+i+ 0 );
+        c_auto i1 = cvt( pSrc+i+ 4 );
+        c_auto i2 = cvt( pSrc+i+ 8 );
+        c_auto i3 = cvt( pSrc+i+12 );
+        _mm_storeu_si128( (__m128i *)(pDes + i),
+            _mm_packus_epi16( _mm_packs_epi32( i0, i1 ), _mm_packs_epi32( i2, i3 ) ) );
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        c_auto v = pSrc[i] * 255.f;
+        pDes[i] = (U8)(v > 0.f ? (v < 255.f ? lrintf( v ) : 255) : 0);
+    }
+}
+
+//==================================================================
+static void imfFloatToU16( U16 *pDes, const float *pSrc, size_t n )
+{
+    size_t i = 0;
+#ifdef IMF_USE_SSE2
+    // no unsigned 32 -> 16 pack in SSE2, so pack signed around 32768
+    c_auto sca = _mm_set1_ps( 65535.f );
+    c_auto zer = _mm_setzero_ps();
+    c_auto off = _mm_set1_epi32( 32768 );
+    c_auto flp = _mm_set1_epi16( (short)0x8000 );
+    auto cvt = [&]( const float *p )
+    {
+        c_auto v = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( p ), sca ), zer ), sca );
+        return _mm_sub_epi32( _mm_cvtps_epi32( v ), off );
+    };
+    for (; (i+8) <= n; i += 8)
+    {
+        c_auto i0 = cvt( pSrc+i+0 );
+        c_auto i1 = cvt( pSrc+i+4 );
+        _mm_storeu_si128( (__m128i *)(pDes + i),
+            _mm_xor_si128( _mm_packs_epi32( i0, i1 ), flp ) );
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        c_auto v = pSrc[i] * 65535.f;
+        pDes[i] = (U16)(v > 0.f ? (v < 65535.f ? lrintf( v ) : 65535) : 0);
+    }
+}
+
+//==================================================================
+static void imfFloatToF16( U16 *pDes, const float *pSrc, size_t n )
+{
+    size_t i = 0;
+#ifdef IMF_USE_F16C
+    for (; (i+8) <= n; i += 8)
+    {
+        c_auto h0 = _mm_cvtps_ph( _mm_loadu_ps( pSrc+i+0 ), 0 );
+        c_auto h1 = _mm_cvtps_ph( _mm_loadu_ps( pSrc+i+4 ), 0 );
+        _mm_storeu_si128( (__m128i *)(pDes + i), _mm_unpacklo_epi64( h0, h1 ) );
+    }
+#endif
+    for (; i < n; ++i)
+        pDes[i] = HALF::FloatToHalf( pSrc[i] );
+}
+
+//==================================================================
+static void imfScaleClamp( float *p, size_t n, float scale, bool doClamp )
+{
+    size_t i = 0;
+#ifdef IMF_USE_SSE2
+    c_auto sca = _mm_set1_ps( scale );
+    c_auto zer = _mm_setzero_ps();
+    c_auto one = _mm_set1_ps( 1.f );
+    if ( doClamp )
+    {
+        for (; (i+4) <= n; i += 4)
+            _mm_storeu_ps( p + i,
+                _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( p + i ), sca ), zer ), one ) );
+    }
+    else
+    {
+        for (; (i+4) <= n; i += 4)
+            _mm_storeu_ps( p + i, _mm_mul_ps( _mm_loadu_ps( p + i ), sca ) );
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        c_auto v = p[i] * scale;
+        p[i] = doClamp ? (v > 0.f ? (v < 1.f ? v : 1.f) : 0.f) : v;
+    }
+}
+
+//==================================================================
+// Reorder the channels, with the channel counts known at compile time
+template <u_int SCH, u_int DCH>
+static void imfSwizzleRow(
+            float *pDes,
+            const float *pSrc,
+            size_t w,
+            const int srcChIdx[image::MAX_CHANS],
+            float fillVal )
+{
+    for (size_t x=0; x < w; ++x, pSrc += SCH, pDes += DCH)
+    {
+        for (u_int c=0; c < DCH; ++c)
+        {
+            c_auto si = srcChIdx[c];
+            pDes[c] = si >= 0 ? pSrc[si] : fillVal;
+        }
+    }
+}
+
+using IMFSwizzleFn = void (*)( float *, const float *, size_t, const int *, float );
+
+#define IMF_SWZ_ROW(_SCH_) \
+    { imfSwizzleRow<_SCH_,1>, imfSwizzleRow<_SCH_,2>, imfSwizzleRow<_SCH_,3>, imfSwizzleRow<_SCH_,4> }
+
+static const IMFSwizzleFn _sSwizzleFns[image::MAX_CHANS][image::MAX_CHANS] =
+{
+    IMF_SWZ_ROW(1),
+    IMF_SWZ_ROW(2),
+    IMF_SWZ_ROW(3),
+    IMF_SWZ_ROW(4),
+};
+
+#undef IMF_SWZ_ROW
+
+//==================================================================
+// Resolve the source channel for each destination channel, -1 to fill
+static bool imfResolveSwizzle(
+            int out_srcChIdx[image::MAX_CHANS],
+            u_int srcChans,
+            u_int desChans,
+            const ConvertParams &par )
+{
+    bool isIdentity = (srcChans == desChans);
+
+    for (u_int c=0; c < image::MAX_CHANS; ++c)
+    {
+        auto si = c < desChans ? par.swizzle[c] : -1;
+
+        // single channel sources go into all the color channels
+        if ( si >= (int)srcChans )
+            si = (srcChans == 1 && c < 3) ? 0 : -1;
+
+        out_srcChIdx[c] = si;
+
+        if ( c < desChans && si != (int)c )
+            isIdentity = false;
+    }
+
+    return isIdentity;
+}
+
+//==================================================================
+}
+
+//==================================================================
+ChanType GetChanType( const image &img )
+{
+    if ( img.IsYUV411() || img.IsYUV444() || !img.mChans ||
+         img.mChans > image::MAX_CHANS )
+        return CHANTYPE_UNKNOWN;
+
+    c_auto chB = img.mBytesPerPixel / img.mChans;
+    if ( chB * img.mChans != img.mBytesPerPixel )
+        return CHANTYPE_UNKNOWN;
+
+    if ( img.IsFloat32() ) return chB == 4 ? CHANTYPE_F32 : CHANTYPE_UNKNOWN;
+    if ( img.IsFloat16() ) return chB == 2 ? CHANTYPE_F16 : CHANTYPE_UNKNOWN;
+
+    switch ( chB )
+    {
+    case 1: return CHANTYPE_U8;
+    case 2: return CHANTYPE_U16;
+    default: return CHANTYPE_UNKNOWN;
+    }
+}
+
+//==================================================================
+size_t GetChanTypeSize( ChanType ct )
+{
+    switch ( ct )
+    {
+    case CHANTYPE_U8:  return 1;
+    case CHANTYPE_U16: return 2;
+    case CHANTYPE_F16: return 2;
+    case CHANTYPE_F32: return 4;
+    default: return 0;
+    }
+}
+
+//==================================================================
+void ChanRowToFloat( float *pDes, const void *pSrc, ChanType srcCT, size_t n )
+{
+    switch ( srcCT )
+    {
+    case CHANTYPE_U8:  imfU8ToFloat(  pDes, (const U8 *)pSrc, n );  break;
+    case CHANTYPE_U16: imfU16ToFloat( pDes, (const U16 *)pSrc, n ); break;
+    case CHANTYPE_F16: imfF16ToFloat( pDes, (const U16 *)pSrc, n ); break;
+    case CHANTYPE_F32: memcpy( pDes, pSrc, n * sizeof(float) );     break;
+    default: DASSERT( 0 ); break;
+    }
+}
+
+//==================================================================
+void ChanRowFromFloat( void *pDes, ChanType desCT, const float *pSrc, size_t n )
+{
+    switch ( desCT )
+    {
+    case CHANTYPE_U8:  imfFloatToU8(  (U8 *)pDes, pSrc, n );  break;
+    case CHANTYPE_U16: imfFloatToU16( (U16 *)pDes, pSrc, n ); break;
+    case CHANTYPE_F16: imfFloatToF16( (U16 *)pDes, pSrc, n ); break;
+    case CHANTYPE_F32: memcpy( pDes, pSrc, n * sizeof(float) ); break;
+    default: DASSERT( 0 ); break;
+    }
+}
+
+//==================================================================
+void ConvertFormatRow(
+        void *pDes,
+        ChanType desCT,
+        u_int desChans,
+        const void *pSrc,
+        ChanType srcCT,
+        u_int srcChans,
+        size_t w,
+        const ConvertParams &par )
+{
+    DASSERT( srcChans >= 1 && srcChans <= image::MAX_CHANS );
+    DASSERT( desChans >= 1 && desChans <= image::MAX_CHANS );
+
+    int srcChIdx[image::MAX_CHANS];
+    c_auto isIdentity = imfResolveSwizzle( srcChIdx, srcChans, desChans, par );
+    c_auto doScale = par.scale != 1.f || par.doClamp;
+
+    // straight copy
+    if ( isIdentity && !doScale && srcCT == desCT )
+    {
+        memcpy( pDes, pSrc, w * srcChans * GetChanTypeSize( srcCT ) );
+        return;
+    }
+
+    c_auto swizzleFn = _sSwizzleFns[srcChans-1][desChans-1];
+
+    c_auto srcPixBytes = (size_t)srcChans * GetChanTypeSize( srcCT );
+    c_auto desPixBytes = (size_t)desChans * GetChanTypeSize( desCT );
+
+    float srcBuff[ IMF_CHUNK_PIX * image::MAX_CHANS ];
+    float desBuff[ IMF_CHUNK_PIX * image::MAX_CHANS ];
+
+    for (size_t x=0; x < w; x += IMF_CHUNK_PIX)
+    {
+        c_auto n = std::min( IMF_CHUNK_PIX, w - x );
+
+        ChanRowToFloat( srcBuff, (const U8 *)pSrc + x * srcPixBytes, srcCT, n * srcChans );
+
+        auto *pRes = srcBuff;
+        if NOT( isIdentity )
+        {
+            swizzleFn( desBuff, srcBuff, n, srcChIdx, par.fillVal );
+            pRes = desBuff;
+        }
+
+        if ( doScale )
+            imfScaleClamp( pRes, n * desChans, par.scale, par.doClamp );
+
+        ChanRowFromFloat( (U8 *)pDes + x * desPixBytes, desCT, pRes, n * desChans );
+    }
+}
+
+//==================================================================
+bool CanConvertFormat( const image &srcImg, const image &desImg )
+{
+    return
+        GetChanType( srcImg ) != CHANTYPE_UNKNOWN &&
+        GetChanType( desImg ) != CHANTYPE_UNKNOWN;
+}
+
+//==================================================================
+void ConvertFormat(
+        const image &srcImg,
+        int sx, int sy,
+        image &desImg,
+        int dx, int dy,
+        int dw, int dh,
+        const ConvertParams &par )
+{
+    c_auto srcCT = GetChanType( srcImg );
+    c_auto desCT = GetChanType( desImg );
+
+    if ( srcCT == CHANTYPE_UNKNOWN || desCT == CHANTYPE_UNKNOWN )
+        DEX_RUNTIME_ERROR( "Unsupported formats for conversion" );
+
+    if ( dw <= 0 || dh <= 0 )
+        return;
+
+    DASSERT( (u_int)(sx + dw) <= srcImg.mW && (u_int)(sy + dh) <= srcImg.mH );
+    DASSERT( (u_int)(dx + dw) <= desImg.mW && (u_int)(dy + dh) <= desImg.mH );
+
+    c_auto srcChans = srcImg.mChans;
+    c_auto desChans = desImg.mChans;
+
+    c_auto rowSamples = (size_t)dw * std::max( srcChans, desChans );
+
+    DT_ParallelFor(
+        (size_t)dh,
+        std::max( IMF_MIN_BAND_SAMPLES / rowSamples, (size_t)1 ),
+        [&]( size_t begin, size_t end )
+        {
+            for (size_t yi=begin; yi < end; ++yi)
+            {
+                ConvertFormatRow(
+                    desImg.GetPixelPtr( (u_int)dx, (u_int)(dy + (int)yi) ), desCT, desChans,
+                    srcImg.GetPixelPtr( (u_int)sx, (u_int)(sy + (int)yi) ), srcCT, srcChans,
+                    (size_t)dw,
+                    par );
+            }
+        } );
+}
+
+//==================================================================
+}
+
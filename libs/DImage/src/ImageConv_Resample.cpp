@@ -0,0 +1,379 @@
+//==================================================================
+/// ImageConv_Resample.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include "stdafx.h"
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define IMR_USE_SSE2
+# include <emmintrin.h>
+#endif
+#include "DThreads.h"
+#include "ImageConv.h"
+
+//==================================================================
+namespace ImageConv
+{
+
+//==================================================================
+namespace
+{
+
+// roughly how many samples a band of work should have, to be worth a thread
+static constexpr size_t IMR_MIN_BAND_SAMPLES = 64 * 1024;
+
+// floats of padding at the end of a row, so that 4-wide loads and stores
+//  of the last pixel can spill over
+static constexpr size_t IMR_ROW_PAD = 4;
+
+//==================================================================
+// Weights of the source samples for each destination sample, on one axis
+struct IMRTaps
+{
+    DVec<int>   mStart;     // first source sample, per destination sample
+    DVec<int>   mCount;     // used taps, per destination sample
+    DVec<float> mWeights;   // mMaxTaps weights per destination sample
+    int         mMaxTaps {};
+
+    const float *GetWeights( size_t di ) const
+    {
+        return mWeights.data() + di * (size_t)mMaxTaps;
+    }
+};
+
+//==================================================================
+static float imrSinc( float x )
+{
+    if ( x == 0.f )
+        return 1.f;
+
+    c_auto px = (float)M_PI * x;
+    return sinf( px ) / px;
+}
+
+//==================================================================
+static float imrFilterRadius( ResampleFilter filter )
+{
+    switch ( filter )
+    {
+    case RESAMPLE_BOX:      return 0.5f;
+    case RESAMPLE_BILINEAR: return 1.f;
+    case RESAMPLE_LANCZOS3: return 3.f;
+    }
+    return 1.f;
+}
+
+//==================================================================
+// weight of source sample si, for a filter centered at c, of scale fscale
+static float imrFilterWeight(
+            ResampleFilter filter,
+            int si,
+            double c,
+            double fscale )
+{
+    if ( filter == RESAMPLE_BOX )
+    {
+        // area coverage of the source sample, by the footprint
+        //  of the destination sample
+        c_auto x0 = std::max( (double)si,     c - fscale * 0.5 );
+        c_auto x1 = std::min( (double)si + 1, c + fscale * 0.5 );
+        return (float)std::max( x1 - x0, 0.0 );
+    }
+
+    c_auto x = (float)(((double)si + 0.5 - c) / fscale);
+
+    if ( filter == RESAMPLE_BILINEAR )
+        return std::max( 1.f - fabsf( x ), 0.f );
+
+    // RESAMPLE_LANCZOS3
+    if ( fabsf( x ) >= 3.f )
+        return 0.f;
+
+    return imrSinc( x ) * imrSinc( x * (1.f/3) );
+}
+
+//==================================================================
+// Build the taps to resample srcN samples into desN samples.
+// Source indices are relative to the start of the source range and are
+//  clamped to it, so no tap ever reads outside of it.
+static void imrMakeTaps(
+            IMRTaps &taps,
+            ResampleFilter filter,
+            int srcN,
+            int desN,
+            bool flip )
+{
+    c_auto scale = (double)srcN / desN;
+
+    // the box filter covers exactly one destination sample, others widen
+    //  their support only when minifying, to avoid aliasing
+    c_auto fscale = (filter == RESAMPLE_BOX) ? scale : std::max( scale, 1.0 );
+    c_auto support = imrFilterRadius( filter ) * fscale;
+
+    taps.mMaxTaps = std::min( (int)ceil( support * 2 ) + 3, srcN );
+    taps.mStart.resize( (size_t)desN );
+    taps.mCount.resize( (size_t)desN );
+    taps.mWeights.assign( (size_t)desN * (size_t)taps.mMaxTaps, 0.f );
+
+    DVec<float> accW( (size_t)srcN );
+
+    for (int di=0; di < desN; ++di)
+    {
+        c_auto c = ((double)(flip ? desN-1-di : di) + 0.5) * scale;
+
+        c_auto siBeg = (int)floor( c - support );
+        c_auto siEnd = (int)ceil(  c + support );
+
+        // accumulate the weights, clamping at the edges of the source
+        auto useBeg = DClamp( siBeg, 0, srcN-1 );
+        auto useEnd = DClamp( siEnd, 0, srcN-1 );
+
+        for (int si=useBeg; si <= useEnd; ++si)
+            accW[si] = 0;
+
+        for (int si=siBeg; si <= siEnd; ++si)
+            accW[ DClamp( si, 0, srcN-1 ) ] += imrFilterWeight( filter, si, c, fscale );
+
+        // skip the zero weights at the ends
+        while ( useBeg < useEnd && accW[useBeg] == 0.f ) ++useBeg;
+        while ( useEnd > useBeg && accW[useEnd] == 0.f ) --useEnd;
+
+        float sumW = 0;
+        for (int si=useBeg; si <= useEnd; ++si)
+            sumW += accW[si];
+
+        auto *pW = taps.mWeights.data() + (size_t)di * (size_t)taps.mMaxTaps;
+
+        if ( sumW == 0.f )
+        {
+            // degenerate, pick the nearest sample
+            taps.mStart[di] = DClamp( (int)c, 0, srcN-1 );
+            taps.mCount[di] = 1;
+            pW[0] = 1.f;
+            continue;
+        }
+
+        c_auto ooSumW = 1.f / sumW;
+        for (int si=useBeg; si <= useEnd; ++si)
+            pW[si - useBeg] = accW[si] * ooSumW;
+
+        taps.mStart[di] = useBeg;
+        taps.mCount[di] = useEnd - useBeg + 1;
+    }
+}
+
+//==================================================================
+// Horizontal pass for one row. pSrc is padded, pDes is padded
+template <int CHN>
+static void imrResampleRowX(
+            float *pDes,
+            const float *pSrc,
+            const IMRTaps &taps,
+            size_t desN,
+            size_t chN )
+{
+#ifdef IMR_USE_SSE2
+    if constexpr ( CHN == 3 || CHN == 4 )
+    {
+        // 4-wide, 3 channels spill one float into the next pixel,
+        //  which gets overwritten right after, or into the row padding
+        for (size_t di=0; di < desN; ++di)
+        {
+            c_auto *pW = taps.GetWeights( di );
+            c_auto *pS = pSrc + (size_t)taps.mStart[di] * CHN;
+            c_auto cnt = taps.mCount[di];
+
+            auto acc = _mm_setzero_ps();
+            for (int k=0; k < cnt; ++k)
+                acc = _mm_add_ps( acc,
+                        _mm_mul_ps( _mm_set1_ps( pW[k] ), _mm_loadu_ps( pS + k * CHN ) ) );
+
+            _mm_storeu_ps( pDes + di * CHN, acc );
+        }
+        return;
+    }
+#endif
+    c_auto useChN = CHN ? (size_t)CHN : chN;
+
+    for (size_t di=0; di < desN; ++di)
+    {
+        c_auto *pW = taps.GetWeights( di );
+        c_auto *pS = pSrc + (size_t)taps.mStart[di] * useChN;
+        c_auto cnt = taps.mCount[di];
+
+        float acc[image::MAX_CHANS] {};
+        for (int k=0; k < cnt; ++k)
+            for (size_t c=0; c < useChN; ++c)
+                acc[c] += pW[k] * pS[k * useChN + c];
+
+        for (size_t c=0; c < useChN; ++c)
+            pDes[di * useChN + c] = acc[c];
+    }
+}
+
+//==================================================================
+// Vertical pass for one row, from rows of contiguous floats
+static void imrResampleRowY(
+            float *pDes,
+            const float *pSrcBase,
+            size_t srcStride,
+            const float *pW,
+            int startRow,
+            int cnt,
+            size_t n )
+{
+    size_t i = 0;
+#ifdef IMR_USE_SSE2
+    for (; (i+8) <= n; i += 8)
+    {
+        auto acc0 = _mm_setzero_ps();
+        auto acc1 = _mm_setzero_ps();
+        for (int k=0; k < cnt; ++k)
+        {
+            c_auto *pS = pSrcBase + (size_t)(startRow + k) * srcStride + i;
+            c_auto w = _mm_set1_ps( pW[k] );
+            acc0 = _mm_add_ps( acc0, _mm_mul_ps( w, _mm_loadu_ps( pS + 0 ) ) );
+            acc1 = _mm_add_ps( acc1, _mm_mul_ps( w, _mm_loadu_ps( pS + 4 ) ) );
+        }
+        _mm_storeu_ps( pDes + i + 0, acc0 );
+        _mm_storeu_ps( pDes + i + 4, acc1 );
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        float acc = 0;
+        for (int k=0; k < cnt; ++k)
+            acc += pW[k] * pSrcBase[ (size_t)(startRow + k) * srcStride + i ];
+
+        pDes[i] = acc;
+    }
+}
+
+//==================================================================
+using IMRRowXFn = void (*)( float *, const float *, const IMRTaps &, size_t, size_t );
+
+static IMRRowXFn imrGetRowXFn( size_t chN )
+{
+    switch ( chN )
+    {
+    case 1: return imrResampleRowX<1>;
+    case 3: return imrResampleRowX<3>;
+    case 4: return imrResampleRowX<4>;
+    default: return imrResampleRowX<0>;
+    }
+}
+
+//==================================================================
+}
+
+//==================================================================
+bool CanBlitResample( const image &srcImg, const image &desImg )
+{
+    return
+        srcImg.mChans == desImg.mChans &&
+        GetChanType( srcImg ) != CHANTYPE_UNKNOWN &&
+        GetChanType( desImg ) != CHANTYPE_UNKNOWN;
+}
+
+//==================================================================
+void BlitResample(
+        const image &srcImg,
+        int sx, int sy,
+        int sw, int sh,
+        image &desImg,
+        int dx, int dy,
+        int dw, int dh,
+        ResampleFilter filter )
+{
+    if NOT( CanBlitResample( srcImg, desImg ) )
+        DEX_RUNTIME_ERROR( "Unsupported formats for resampling" );
+
+    c_auto flipX = dw < 0;
+    c_auto flipY = dh < 0;
+    dw = std::abs( dw );
+    dh = std::abs( dh );
+
+    if ( !sw || !sh || !dw || !dh )
+        return;
+
+    DASSERT( sx >= 0 && sy >= 0 && dx >= 0 && dy >= 0 );
+    DASSERT( (u_int)(sx + sw) <= srcImg.mW && (u_int)(sy + sh) <= srcImg.mH );
+    DASSERT( (u_int)(dx + dw) <= desImg.mW && (u_int)(dy + dh) <= desImg.mH );
+
+    c_auto chN     = (size_t)srcImg.mChans;
+    c_auto srcCT   = GetChanType( srcImg );
+    c_auto desCT   = GetChanType( desImg );
+
+    IMRTaps tapsX;
+    IMRTaps tapsY;
+    imrMakeTaps( tapsX, filter, sw, dw, flipX );
+    imrMakeTaps( tapsY, filter, sh, dh, flipY );
+
+    // only the source rows that are touched by the vertical taps
+    int syMin = sh;
+    int syMax = 0;
+    for (int i=0; i < dh; ++i)
+    {
+        syMin = std::min( syMin, tapsY.mStart[i] );
+        syMax = std::max( syMax, tapsY.mStart[i] + tapsY.mCount[i] );
+    }
+
+    c_auto midRowsN  = (size_t)(syMax - syMin);
+    c_auto midStride = (size_t)dw * chN + IMR_ROW_PAD;
+
+    // horizontal pass, into the intermediate float buffer
+    uptr<float[]> moMid( new float[ midRowsN * midStride ] );
+
+    c_auto rowXFn = imrGetRowXFn( chN );
+    c_auto srcRowN = (size_t)sw * chN;
+
+    DT_ParallelFor(
+        midRowsN,
+        std::max( IMR_MIN_BAND_SAMPLES / ((size_t)sw + (size_t)dw), (size_t)1 ),
+        [&]( size_t begin, size_t end )
+        {
+            DVec<float> srcRow( srcRowN + IMR_ROW_PAD );
+
+            for (size_t ri=begin; ri < end; ++ri)
+            {
+                c_auto *pSrc = srcImg.GetPixelPtr( (u_int)sx, (u_int)(sy + syMin + (int)ri) );
+                ChanRowToFloat( srcRow.data(), pSrc, srcCT, srcRowN );
+
+                rowXFn( moMid.get() + ri * midStride, srcRow.data(), tapsX, (size_t)dw, chN );
+            }
+        } );
+
+    // vertical pass, into the destination
+    c_auto desRowN = (size_t)dw * chN;
+
+    DT_ParallelFor(
+        (size_t)dh,
+        std::max( IMR_MIN_BAND_SAMPLES / (size_t)dw, (size_t)1 ),
+        [&]( size_t begin, size_t end )
+        {
+            DVec<float> desRow( desRowN );
+
+            for (size_t di=begin; di < end; ++di)
+            {
+                imrResampleRowY(
+                        desRow.data(),
+                        moMid.get(),
+                        midStride,
+                        tapsY.GetWeights( di ),
+                        tapsY.mStart[di] - syMin,
+                        tapsY.mCount[di],
+                        desRowN );
+
+                auto *pDes = desImg.GetPixelPtr( (u_int)dx, (u_int)(dy + (int)di) );
+                ChanRowFromFloat( pDes, desCT, desRow.data(), desRowN );
+            }
+        } );
+}
+
+//==================================================================
+}
+
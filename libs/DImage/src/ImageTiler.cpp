@@ -0,0 +1,103 @@
+//==================================================================
+/// ImageTiler.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <cmath>
+#include "ImageTiler.h"
+
+//==================================================================
+ImageTiler::ImageTiler( u_int tileDim )
+    : mTileDim(tileDim)
+{
+    DASSERT( mTileDim > 0 );
+}
+
+//==================================================================
+void ImageTiler::Setup( u_int fullW, u_int fullH, u_int level, u_int levW, u_int levH )
+{
+    mFullW  = fullW;
+    mFullH  = fullH;
+    mLevel  = level;
+    mLevW   = levW;
+    mLevH   = levH;
+    mTilesW = (levW + mTileDim - 1) / mTileDim;
+    mTilesH = (levH + mTileDim - 1) / mTileDim;
+}
+
+//==================================================================
+ImageTiler::Tile ImageTiler::MakeTile( u_int tx, u_int ty ) const
+{
+    DASSERT( tx < mTilesW && ty < mTilesH );
+
+    Tile t;
+    t.tl_level  = mLevel;
+    t.tl_tx     = tx;
+    t.tl_ty     = ty;
+    t.tl_x      = tx * mTileDim;
+    t.tl_y      = ty * mTileDim;
+    t.tl_w      = std::min( mTileDim, mLevW - t.tl_x );
+    t.tl_h      = std::min( mTileDim, mLevH - t.tl_y );
+
+    // levels may have been rounded down, so scale by the actual ratio
+    c_auto sx = (double)mFullW / mLevW;
+    c_auto sy = (double)mFullH / mLevH;
+    t.tl_fullRC = {
+        t.tl_x * sx,
+        t.tl_y * sy,
+        t.tl_w * sx,
+        t.tl_h * sy };
+
+    return t;
+}
+
+//==================================================================
+void ImageTiler::CalcVisibleTiles( DVec<Tile> &out_tiles, const Double4 &visFullRC ) const
+{
+    out_tiles.clear();
+
+    if ( !mTilesW || !mTilesH )
+        return;
+
+    // only the part on the image. The last tiles of the grid may be
+    //  partial, and a view past the edge would otherwise reach them
+    c_auto x1 = std::max( visFullRC[0], 0.0 );
+    c_auto y1 = std::max( visFullRC[1], 0.0 );
+    c_auto x2 = std::min( visFullRC[0] + visFullRC[2], (double)mFullW );
+    c_auto y2 = std::min( visFullRC[1] + visFullRC[3], (double)mFullH );
+
+    if ( x2 <= x1 || y2 <= y1 )
+        return;
+
+    // to tile units
+    c_auto toTX = (double)mLevW / ((double)mFullW * mTileDim);
+    c_auto toTY = (double)mLevH / ((double)mFullH * mTileDim);
+
+    auto clampT = []( double v, u_int n )
+    {
+        return (u_int)std::clamp( v, 0.0, (double)n );
+    };
+
+    c_auto tx1 = clampT( std::floor( x1 * toTX ), mTilesW );
+    c_auto ty1 = clampT( std::floor( y1 * toTY ), mTilesH );
+    c_auto tx2 = clampT( std::ceil( x2 * toTX ), mTilesW );
+    c_auto ty2 = clampT( std::ceil( y2 * toTY ), mTilesH );
+
+    for (u_int ty=ty1; ty < ty2; ++ty)
+        for (u_int tx=tx1; tx < tx2; ++tx)
+            out_tiles.push_back( MakeTile( tx, ty ) );
+}
+
+//==================================================================
+u_int ImageTiler::CalcLevelForScale( double dispScale, u_int maxLevel )
+{
+    u_int level = 0;
+    while ( level < maxLevel && dispScale * (double)(1 << (level+1)) <= 1.0 )
+        ++level;
+
+    return level;
+}
+
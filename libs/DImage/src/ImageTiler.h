@@ -0,0 +1,75 @@
+//==================================================================
+/// ImageTiler.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef IMAGETILER_H
+#define IMAGETILER_H
+
+#include "DBase.h"
+#include "DContainers.h"
+#include "DVector.h"
+
+//==================================================================
+// CPU side of a tiled display. Splits one level of an image into a
+//  grid of tiles and finds the ones that fall in a view.
+// Rects are x,y,w,h. "Full" coordinates are the pixels of level 0.
+//==================================================================
+class ImageTiler
+{
+public:
+    struct Tile
+    {
+        u_int   tl_level {};
+        u_int   tl_tx {};       // position in the grid
+        u_int   tl_ty {};
+        u_int   tl_x {};        // rect in the level's pixels
+        u_int   tl_y {};
+        u_int   tl_w {};
+        u_int   tl_h {};
+        Double4 tl_fullRC {};   // rect in full coordinates
+
+        uint64_t GetKey() const { return MakeKey( tl_level, tl_tx, tl_ty ); }
+    };
+
+private:
+    u_int   mTileDim    {};
+    u_int   mFullW      {};
+    u_int   mFullH      {};
+    u_int   mLevel      {};
+    u_int   mLevW       {};
+    u_int   mLevH       {};
+    u_int   mTilesW     {};
+    u_int   mTilesH     {};
+
+public:
+    ImageTiler( u_int tileDim=1024 );
+
+    // the level image is levW x levH, standing for fullW x fullH
+    void Setup( u_int fullW, u_int fullH, u_int level, u_int levW, u_int levH );
+
+    u_int GetTileDim() const { return mTileDim; }
+    u_int GetLevel() const { return mLevel; }
+    u_int GetTilesW() const { return mTilesW; }
+    u_int GetTilesH() const { return mTilesH; }
+
+    Tile MakeTile( u_int tx, u_int ty ) const;
+
+    // tiles that overlap a rect in full coordinates, row by row
+    void CalcVisibleTiles( DVec<Tile> &out_tiles, const Double4 &visFullRC ) const;
+
+    static uint64_t MakeKey( u_int level, u_int tx, u_int ty )
+    {
+        return (uint64_t)level << 48 | (uint64_t)ty << 24 | (uint64_t)tx;
+    }
+
+    // coarsest level that still has at least one pixel per screen pixel,
+    //  for a scale of screen pixels per full pixel
+    static u_int CalcLevelForScale( double dispScale, u_int maxLevel );
+};
+
+#endif
+
@@ -7,6 +7,7 @@
 
 #include "stdafx.h"
 #include "DUT_Str.h"
+#include "DTrace.h"
 #include "Image_DLS.h"
 #include "Image_DLS_LSS.h"
 #include "Image_DLS_LOS.h"
@@ -21,10 +22,11 @@ template <typename _T>
 void fillRect( image &img, const U32 col[MAX_CHANS] )
 {
     int chansN = img.mChans;
-    ImageConv::RectProcess<_T>( img,
-            [=](_T *pPix) {
-                for (int i=0; i < chansN; ++i)
-                    pPix[i] = (_T)col[i];
+    ImageConv::RectProcessRows<_T>( img,
+            [=](_T *pRow, u_int w) {
+                for (u_int x=0; x < w; ++x, pRow += chansN)
+                    for (int i=0; i < chansN; ++i)
+                        pRow[i] = (_T)col[i];
             });
 }
 
@@ -46,10 +48,11 @@ void avgRect( const image &img, U32 col[MAX_CHANS] )
     if ( pixN == 0 )
         return;
 
-    ImageConv::RectProcess<_T>( img,
-            [&](const _T *pPix) {
-                for (int i=0; i < chansN; ++i)
-                    sums[i] += (double)pPix[i];
+    ImageConv::RectProcessRows<_T>( img,
+            [&](const _T *pRow, u_int w) {
+                for (u_int x=0; x < w; ++x, pRow += chansN)
+                    for (int i=0; i < chansN; ++i)
+                        sums[i] += (double)pRow[i];
             });
 
     for (int i=0; i < chansN; ++i)
@@ -154,6 +157,8 @@ void LoadDLS(
         DUT::MemReader &mr,
         ImgDLS_Head1 *pOut_Head )
 {
+    DTR_SCOPE( "dls_decode" );
+
 	char fmtID[5];
 	fmtID[4] = 0;
 	mr.ReadArray( fmtID, 4 );
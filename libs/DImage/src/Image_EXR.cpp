@@ -18,6 +18,10 @@
 
 //#include <ImfRgbaFile.h>
 #include <ImfInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfPartType.h>
 #include <ImfHeader.h>
 #include <ImfStringAttribute.h>
 #include <ImfMatrixAttribute.h>
@@ -28,6 +32,8 @@
 #include <ImfFrameBuffer.h>
 
 #include "DLogOut.h"
+#include "DTrace.h"
+#include "DExceptions.h"
 
 #include "Image_EXR.h"
 
@@ -101,6 +107,8 @@ static auto makeIMFPixType = []( auto iexrDType )
 //==================================================================
 uptr<ImageEXR> ImageEXR_Load( const DStr &pathFName, const DStr &dummyLayerName )
 {
+    DTR_SCOPE( "exr_open" );
+
     // it's a bit hacky here, but it works
     static bool sHasSetIMFThreads;
     if NOT( sHasSetIMFThreads )
@@ -196,6 +204,8 @@ uptr<ImageEXR> ImageEXR_Load( const DStr &pathFName, const DStr &dummyLayerName
 //==================================================================
 void ImageEXR_LoadLayer( ImageEXR &ie, const DStr &loadLayerName )
 {
+    DTR_SCOPE( "exr_decode_layer" );
+
     auto *pLayer = ie.FindLayerByName( loadLayerName );
     if NOT( pLayer )
     {
@@ -398,5 +408,94 @@ uptr<image> ImageEXR_MakeAlphaImageFromLayer( ImageEXRLayer &layer, const ImageE
     return oImage;
 }
 
+//==================================================================
+void ImageEXR_SaveImage( const DStr &pathFName, const image &img, bool isHalf )
+{
+    if ( !img.IsFloat32() || img.mChans < 3 )
+        DEX_RUNTIME_ERROR( "Only float RGB or RGBA images can be saved as EXR" );
+
+    static const char *const sChanNames[] = { "R", "G", "B", "A" };
+
+    c_auto chansN = std::min( (size_t)img.mChans, (size_t)4 );
+
+    IMF::Header header( (int)img.mW, (int)img.mH );
+    for (size_t ci=0; ci < chansN; ++ci)
+        header.channels().insert( sChanNames[ci], IMF::Channel( isHalf ? IMF::HALF : IMF::FLOAT ) );
+
+    // straight from the interleaved pixels, the library converts to half
+    IMF::FrameBuffer fb;
+    for (size_t ci=0; ci < chansN; ++ci)
+    {
+        fb.insert( sChanNames[ci],
+                   IMF::Slice( IMF::FLOAT,
+                               (char *)(img.GetPixelPtr( 0, 0 ) + ci * sizeof(float)),
+                               img.mBytesPerPixel,
+                               img.mBytesPerRow ) );
+    }
+
+    IMF::OutputFile file( pathFName.c_str(), header );
+    file.setFrameBuffer( fb );
+    file.writePixels( (int)img.mH );
+}
+
+//==================================================================
+void ImageEXR_SaveMultiPartImage(
+            const DStr &pathFName,
+            const DVec<const image *> &pImgs,
+            const DVec<DStr> &partNames,
+            bool isHalf,
+            const DFun<void (size_t doneN, size_t totN)> &onProgressFn )
+{
+    if ( pImgs.empty() || pImgs.size() != partNames.size() )
+        DEX_RUNTIME_ERROR( "Need one name for each part" );
+
+    static const char *const sChanNames[] = { "R", "G", "B", "A" };
+
+    DVec<IMF::Header> headers;
+    for (size_t i=0; i < pImgs.size(); ++i)
+    {
+        c_auto &img = *pImgs[i];
+
+        if ( !img.IsFloat32() || img.mChans < 3 )
+            DEX_RUNTIME_ERROR( "Only float RGB or RGBA images can be saved as EXR" );
+
+        c_auto chansN = std::min( (size_t)img.mChans, (size_t)4 );
+
+        IMF::Header header( (int)img.mW, (int)img.mH );
+        header.setName( partNames[i] );
+        header.setType( IMF::SCANLINEIMAGE );
+        for (size_t ci=0; ci < chansN; ++ci)
+            header.channels().insert( sChanNames[ci], IMF::Channel( isHalf ? IMF::HALF : IMF::FLOAT ) );
+
+        headers.push_back( header );
+    }
+
+    IMF::MultiPartOutputFile file( pathFName.c_str(), headers.data(), (int)headers.size() );
+
+    for (size_t i=0; i < pImgs.size(); ++i)
+    {
+        c_auto &img = *pImgs[i];
+
+        c_auto chansN = std::min( (size_t)img.mChans, (size_t)4 );
+
+        IMF::FrameBuffer fb;
+        for (size_t ci=0; ci < chansN; ++ci)
+        {
+            fb.insert( sChanNames[ci],
+                       IMF::Slice( IMF::FLOAT,
+                                   (char *)(img.GetPixelPtr( 0, 0 ) + ci * sizeof(float)),
+                                   img.mBytesPerPixel,
+                                   img.mBytesPerRow ) );
+        }
+
+        IMF::OutputPart part( file, (int)i );
+        part.setFrameBuffer( fb );
+        part.writePixels( (int)img.mH );
+
+        if ( onProgressFn )
+            onProgressFn( i + 1, pImgs.size() );
+    }
+}
+
 #endif
 
@@ -114,6 +114,15 @@ uptr<ImageEXR> ImageEXR_Load( const DStr &pathFName, const DStr &dummyLayerName
 void ImageEXR_LoadLayer( ImageEXR &ie, const DStr &loadLayerName );
 uptr<image> ImageEXR_MakeImageFromLayer( ImageEXRLayer &layer, const ImageEXR &ie );
 uptr<image> ImageEXR_MakeAlphaImageFromLayer( ImageEXRLayer &layer, const ImageEXR &ie );
+// RGB(A) of a float image, stored as half or float
+void ImageEXR_SaveImage( const DStr &pathFName, const image &img, bool isHalf );
+// one part for each image, named as given, in a single file
+void ImageEXR_SaveMultiPartImage(
+            const DStr &pathFName,
+            const DVec<const image *> &pImgs,
+            const DVec<DStr> &partNames,
+            bool isHalf,
+            const DFun<void (size_t doneN, size_t totN)> &onProgressFn={} );
 
 #endif
 
@@ -25,6 +25,7 @@ extern "C"
 
 #include "dlog.h"
 #include "DUT_MemFile.h"
+#include "DTrace.h"
 #include "Image_JPEG.h"
 
 // for the time being, for windows only
@@ -377,6 +378,8 @@ jpeg_memory_dest(j_compress_ptr cinfo, JOCTET *buffer,int bufsize)
 //==================================================================
 void Image_JPEGLoad( image &img, u_int imgBaseFlags, const U8 *pData, size_t dataSize )
 {
+    DTR_SCOPE( "jpeg_decode" );
+
     struct jpeg_decompress_struct cinfo;
     struct my_error_mgr jerr;
 
@@ -14,6 +14,34 @@
 #include "Image.h"
 
 //==================================================================
+// The image data is split in bands of rows, that are filtered and
+//  deflated in parallel, then joined in a single zlib stream, pigz
+//  style. Float images are saved as 8 bit, clamped.
+//==================================================================
+enum PNGSaveFilter : int
+{
+    PNGSAVE_FILTER_NONE,
+    PNGSAVE_FILTER_SUB,
+    PNGSAVE_FILTER_UP,
+    PNGSAVE_FILTER_AVERAGE,
+    PNGSAVE_FILTER_PAETH,
+    PNGSAVE_FILTER_ADAPTIVE,    // the best of the above, row by row
+};
+
+PNGSaveFilter Image_PNGSaveFilterFromName( const DStr &name );
+const char *Image_PNGSaveFilterName( PNGSaveFilter filter );
+
+struct PNGSaveParams
+{
+    int             pss_level   { 6 };      // zlib, 0 to 9
+    PNGSaveFilter   pss_filter  { PNGSAVE_FILTER_ADAPTIVE };
+    bool            pss_flipY   {};
+    // bands done of the total, called from the worker threads
+    DFun<void (size_t doneN, size_t totN)>  pss_onProgressFn;
+};
+
+void Image_PNGSave( const image &img, const char *pFName, const PNGSaveParams &par );
+
 void Image_PNGSave( const image &img, const char *pFName, bool flipY );
 
 void Image_PNGLoad( image &img, u_int imgBaseFlags, const char *pFName );
@@ -27,6 +55,29 @@ void Image_PNGLoad(
 
 bool Image_PNG_DetectSRGBFromFileName( const DStr &fname );
 
+//==================================================================
+// Decodes a row at a time straight into the target format, so that
+//  there's no full image in between. 16 bit sources keep their
+//  precision when the target is float.
+//==================================================================
+class ImageAlphaStats;
+
+struct PNGStreamParams
+{
+    u_int           psp_imgBaseFlags    {};
+    u_int           psp_targetFlags     {};     // FLG_IS_FLOAT32, FLG_IS_FLOAT16 or 0 for 8 bit
+    bool            psp_forceAsSRGB     {};     // set from the name, for the file version
+    ImageAlphaStats *psp_pAlphaStats    {};     // filled along the way, if set
+};
+
+void Image_PNGLoadStream(
+        image &img,
+        const U8 *pData,
+        size_t dataSize,
+        const PNGStreamParams &par );
+
+void Image_PNGLoadStream( image &img, const char *pFName, const PNGStreamParams &par );
+
 #endif
 
 #endif
@@ -12,8 +12,11 @@
 #include "png.h"
 #include "pngstruct.h"
 #include "DUT_Files.h"
+#include "DTrace.h"
 #include "ImageConv.h"
+#include "ImageAlphaStats.h"
 #include "Image.h"
+#include "Image_PNG.h"
 
 //==================================================================
 bool Image_PNG_DetectSRGBFromFileName( const DStr &fname )
@@ -102,19 +105,160 @@ static void convert_RGB24_to_RGBA( image &img )
 //==================================================================
 static void swap16BitEndianess( image &img )
 {
-    const int chans = (int)img.mChans;
-    ImageConv::RectProcess<U16>(
+    const size_t chans = img.mChans;
+    ImageConv::RectProcessRows<U16>(
         img,
-        [chans]( U16 *pPix )
+        [chans]( U16 *pRow, u_int w )
         {
-            for (int i=0; i != chans; ++i)
-            {
-                U8 *pPix8 = (U8 *)pPix;
-                std::swap( pPix8[i*2+0], pPix8[i*2+1] );
-            }
+            c_auto n = (size_t)w * chans;
+            for (size_t i=0; i != n; ++i)
+                pRow[i] = (U16)((pRow[i] >> 8) | (pRow[i] << 8));
         });
 }
 
+//==================================================================
+// what's known after the header, once the expansions are set up
+struct PNGReadHead
+{
+    png_uint_32 wd {};
+    png_uint_32 he {};
+    int         bitDepth {};
+    int         colorType {};
+    int         interlaceType {};
+    int         passesN {};
+    png_size_t  chans {};
+    png_size_t  rowBytes {};
+    bool        hasGamma22 {};
+};
+
+//==================================================================
+static void pngReadHead(
+        png_structp pPNG,
+        png_infop pPNGInfo,
+        bool forceAsSRGB,
+        bool swap16,
+        PNGReadHead &out )
+{
+    auto &iBitDepth  = out.bitDepth;
+    auto &iColorType = out.colorType;
+    auto &hasGamma22 = out.hasGamma22;
+
+    // read all PNG info up to image data
+
+    png_read_info(pPNG, pPNGInfo);
+
+    // get width, height, bit-depth and color-type
+
+    png_uint_32	wd = 0;
+    png_uint_32	he = 0;
+
+    png_get_IHDR(
+            pPNG,
+            pPNGInfo,
+            &wd,
+            &he,
+            &iBitDepth,
+            &iColorType,
+            NULL,
+            NULL,
+            NULL );
+
+    // expand images of all color-type and bit-depth to 3x8 bit RGB images
+    // let the library process things like alpha, transparency, background
+
+    //if (iBitDepth == 16)
+    //    png_set_strip_16(pPNG);
+
+    if (iColorType == PNG_COLOR_TYPE_PALETTE)
+        png_set_expand(pPNG);
+
+    if (iBitDepth < 8)
+        png_set_expand(pPNG);
+
+    if (png_get_valid(pPNG, pPNGInfo, PNG_INFO_tRNS))
+        png_set_expand(pPNG);
+
+    //if (iColorType == PNG_COLOR_TYPE_GRAY ||
+    //    iColorType == PNG_COLOR_TYPE_GRAY_ALPHA)
+    //    png_set_gray_to_rgb(pPNG);
+
+    // set the background color to draw transparent and alpha images over.
+/*
+    png_color_16			*pBackground;
+
+    if (png_get_bKGD(pPNG, info_ptr, &pBackground))
+    {
+        png_set_background(pPNG, pBackground, PNG_BACKGROUND_GAMMA_FILE, 1, 1.0);
+        if ( pBkgColor )
+        {
+            pBkgColor->red   = (U8) pBackground->red;
+            pBkgColor->green = (U8) pBackground->green;
+            pBkgColor->blue  = (U8) pBackground->blue;
+        }
+    }
+    else
+    {
+        pBkgColor = NULL;
+    }
+*/
+
+    // gamma: http://onemanmmo.com/index.php?cmd=newsitem&comment=news.1.109.0
+
+    // if required set gamma conversion
+    int sRGBintent;
+    if ( png_get_sRGB( pPNG, pPNGInfo, &sRGBintent ) != 0 )
+    {
+        hasGamma22 = true;
+    }
+    else
+    {
+        double gamma;
+        if (png_get_gAMA(pPNG, pPNGInfo, &gamma))
+        {
+            png_set_gamma(pPNG, 2.2, gamma);
+            hasGamma22 = true;
+        }
+    }
+
+    // 16 bit samples in the byte order of the machine
+    if ( swap16 && iBitDepth == 16 )
+    {
+        const U16 one = 1;
+        if ( *(const U8 *)&one )
+            png_set_swap(pPNG);
+    }
+
+    // interlaced images come in passes over the whole image
+    out.passesN = png_set_interlace_handling(pPNG);
+
+    // after the transformations have been registered update info_ptr data
+
+    png_read_update_info(pPNG, pPNGInfo);
+
+    // get again width, height and the new bit-depth and color-type
+
+    png_get_IHDR(
+            pPNG,
+            pPNGInfo,
+            &wd,
+            &he,
+            &iBitDepth,
+            &iColorType,
+            &out.interlaceType,
+            NULL,
+            NULL);
+
+    // row_bytes is the width x number of channels
+
+    out.wd       = wd;
+    out.he       = he;
+    out.rowBytes = png_get_rowbytes(pPNG, pPNGInfo);
+    out.chans    = png_get_channels(pPNG, pPNGInfo);
+
+    if ( forceAsSRGB && (out.chans == 3 || out.chans == 4) )
+        hasGamma22 = true;
+}
+
 //==================================================================
 void Image_PNGLoad(
         image &img,
@@ -123,8 +267,9 @@ void Image_PNGLoad(
         size_t dataSize,
         bool forceAsSRGB )
 {
+    DTR_SCOPE( "png_decode" );
+
 	int						iBitDepth;
-	int						iColorType;
     png_size_t              ulChannels;
     png_size_t              ulRowBytes;
 
@@ -172,104 +317,15 @@ void Image_PNGLoad(
 
         png_set_sig_bytes(pPNG, 8);
 
-        // read all PNG info up to image data
-
-        png_read_info(pPNG, pPNGInfo);
-
-        // get width, height, bit-depth and color-type
-
-		png_uint_32	wd = 0;
-		png_uint_32	he = 0;
+        PNGReadHead head;
+        pngReadHead( pPNG, pPNGInfo, forceAsSRGB, false, head );
 
-        png_get_IHDR(
-				pPNG,
-				pPNGInfo,
-				&wd,
-				&he,
-				&iBitDepth,
-				&iColorType,
-				NULL,
-				NULL,
-				NULL );
-
-        // expand images of all color-type and bit-depth to 3x8 bit RGB images
-        // let the library process things like alpha, transparency, background
-
-        //if (iBitDepth == 16)
-        //    png_set_strip_16(pPNG);
-
-        if (iColorType == PNG_COLOR_TYPE_PALETTE)
-            png_set_expand(pPNG);
-
-		if (iBitDepth < 8)
-            png_set_expand(pPNG);
-
-		if (png_get_valid(pPNG, pPNGInfo, PNG_INFO_tRNS))
-            png_set_expand(pPNG);
-
-		//if (iColorType == PNG_COLOR_TYPE_GRAY ||
-        //    iColorType == PNG_COLOR_TYPE_GRAY_ALPHA)
-        //    png_set_gray_to_rgb(pPNG);
-
-        // set the background color to draw transparent and alpha images over.
-/*
-		png_color_16			*pBackground;
-
-		if (png_get_bKGD(pPNG, info_ptr, &pBackground))
-        {
-            png_set_background(pPNG, pBackground, PNG_BACKGROUND_GAMMA_FILE, 1, 1.0);
-			if ( pBkgColor )
-			{
-				pBkgColor->red   = (U8) pBackground->red;
-				pBkgColor->green = (U8) pBackground->green;
-				pBkgColor->blue  = (U8) pBackground->blue;
-			}
-        }
-        else
-        {
-            pBkgColor = NULL;
-        }
-*/
-
-        // gamma: http://onemanmmo.com/index.php?cmd=newsitem&comment=news.1.109.0
-
-        // if required set gamma conversion
-        int sRGBintent;
-        if ( png_get_sRGB( pPNG, pPNGInfo, &sRGBintent ) != 0 )
-        {
-            hasGamma22 = true;
-        }
-        else
-        {
-            double gamma;
-            if (png_get_gAMA(pPNG, pPNGInfo, &gamma))
-            {
-                png_set_gamma(pPNG, 2.2, gamma);
-                hasGamma22 = true;
-            }
-        }
-
-        // after the transformations have been registered update info_ptr data
-
-        png_read_update_info(pPNG, pPNGInfo);
-
-        // get again width, height and the new bit-depth and color-type
-
-        png_get_IHDR(
-				pPNG,
-				pPNGInfo,
-				&wd,
-				&he,
-				&iBitDepth,
-				&iColorType,
-				NULL,
-				NULL,
-				NULL);
-
-        // row_bytes is the width x number of channels
-
-        ulRowBytes = png_get_rowbytes(pPNG, pPNGInfo);
-        ulChannels = png_get_channels(pPNG, pPNGInfo);
+        c_auto wd  = head.wd;
+        c_auto he  = head.he;
+        iBitDepth  = head.bitDepth;
+        ulRowBytes = head.rowBytes;
+        ulChannels = head.chans;
+        hasGamma22 = head.hasGamma22;
 
         // now we can allocate memory to store the image
 
@@ -281,10 +337,6 @@ void Image_PNGLoad(
 		par.rowPitch= (u_int)ulRowBytes;
         par.flags   = imgBaseFlags; // copy the flags
 
-        //
-        if ( forceAsSRGB && (par.chans == 3 || par.chans == 4) )
-            hasGamma22 = true;
-
         // see if it has gamma
         if ( hasGamma22 )
             par.flags |= image::FLG_HAS_GAMMA22;
@@ -329,17 +381,8 @@ void Image_PNGLoad(
                 img8Par.depth  = img8Par.chans * 8; // only change "depth"
                 img8Par.flags  = img.mFlags;
 
-                const int chans = (int)img.mChans;
                 image img8( img8Par );
-                ImageConv::BlitProcess<U16,U8>(
-                        img, img8,
-                        [chans](const U16 *pSrc, U8 *pDes)
-                        {
-                            for (int i=0; i != chans; ++i)
-                            {
-                                pDes[i] = (U8)(pSrc[i] >> 8);
-                            }
-                        });
+                ImageConv::ConvertFormat( img, img8 );
 
                 // copy the 8 bit image into the 16 one
                 img = std::move( img8 ); // replace the image
@@ -359,7 +402,8 @@ void Image_PNGLoad(
 void Image_PNGLoad( image &img, u_int imgBaseFlags, const char *pFName )
 {
 	DFileData fileData;
-	DUT::GrabFile( pFName, fileData );
+	if NOT( DUT::MapFile( pFName, fileData ) )
+		DEX_RUNTIME_ERROR( "Could not load '%s'", pFName );
 
 	bool isBad = false;
 
@@ -377,5 +421,144 @@ void Image_PNGLoad( image &img, u_int imgBaseFlags, const char *pFName )
         DEX_RUNTIME_ERROR( "File %s is not a valid PNG file", pFName) ;
 }
 
+//==================================================================
+void Image_PNGLoadStream(
+        image &img,
+        const U8 *pData,
+        size_t dataSize,
+        const PNGStreamParams &par )
+{
+    DTR_SCOPE( "png_decode_stream" );
+
+    const int SIG_SIZE = 8;
+
+    if ( dataSize < SIG_SIZE || !png_check_sig(pData, SIG_SIZE) )
+        DEX_RUNTIME_ERROR( "Bad PNG" );
+
+    MyPNGData pngData;
+    pngData.pCurDataPtr = pData + SIG_SIZE;
+    pngData.sizeLeft = (int)dataSize - SIG_SIZE;
+
+    png_structp pPNG =
+        png_create_read_struct(
+                    PNG_LIBPNG_VER_STRING,
+                    NULL,
+                    (png_error_ptr)png_cexcept_error,
+                    (png_error_ptr)NULL );
+
+    if NOT( pPNG )
+        DEX_RUNTIME_ERROR( "Failed to create the structure") ;
+
+    png_infop pPNGInfo = png_create_info_struct(pPNG);
+
+    if NOT( pPNGInfo )
+    {
+        png_destroy_read_struct(&pPNG, NULL, NULL);
+        DEX_RUNTIME_ERROR( "Failed to the info structure") ;
+    }
+
+    try
+    {
+        png_set_read_fn(pPNG, &pngData, _png_read_fn);
+        png_set_sig_bytes(pPNG, SIG_SIZE);
+
+        PNGReadHead head;
+        pngReadHead( pPNG, pPNGInfo, par.psp_forceAsSRGB, true, head );
+
+        c_auto w        = (u_int)head.wd;
+        c_auto h        = (u_int)head.he;
+        c_auto chans    = (u_int)head.chans;
+        c_auto srcCT    = head.bitDepth == 16 ? ImageConv::CHANTYPE_U16 : ImageConv::CHANTYPE_U8;
+
+        c_auto desCT = (par.psp_targetFlags & image::FLG_IS_FLOAT32) ? ImageConv::CHANTYPE_F32
+                     : (par.psp_targetFlags & image::FLG_IS_FLOAT16) ? ImageConv::CHANTYPE_F16
+                                                                      : ImageConv::CHANTYPE_U8;
+
+        image::Params ipar;
+        ipar.width  = w;
+        ipar.height = h;
+        ipar.chans  = chans;
+        ipar.depth  = chans * (u_int)ImageConv::GetChanTypeSize( desCT ) * 8;
+        ipar.flags  = par.psp_imgBaseFlags |
+                        (par.psp_targetFlags & (image::FLG_IS_FLOAT32 | image::FLG_IS_FLOAT16));
+
+        if ( head.hasGamma22 )
+            ipar.flags |= image::FLG_HAS_GAMMA22;
+        else
+            ipar.flags &= ~image::FLG_HAS_GAMMA22;
+
+        img.Setup( ipar );
+
+        auto *pStats = par.psp_pAlphaStats;
+        if ( pStats )
+            pStats->Setup( w, h );
+
+        c_auto alphaChan = (chans == 2 || chans == 4) ? (int)chans - 1 : -1;
+
+        // a source row, into the stats and then to the target format
+        c_auto storeRow = [&]( u_int y, const U8 *pSrcRow )
+        {
+            if ( pStats )
+                pStats->AddRow( y, pSrcRow, srcCT, chans, alphaChan );
+
+            ImageConv::ConvertFormatRow(
+                    img.GetPixelPtr( 0, y ), desCT, chans,
+                    pSrcRow, srcCT, chans,
+                    w );
+        };
+
+        if ( head.passesN <= 1 )
+        {
+            // only one row of the source is ever around
+            DVec<U8> rowBuff( head.rowBytes );
+            for (u_int y=0; y < h; ++y)
+            {
+                png_read_row( pPNG, rowBuff.data(), NULL );
+                storeRow( y, rowBuff.data() );
+            }
+        }
+        else
+        {
+            // the passes need all of it, this is the rare case
+            DVec<U8> srcBuff( head.rowBytes * h );
+            DVec<U8*> pRowPointers( h );
+            for (u_int y=0; y < h; ++y)
+                pRowPointers[y] = &srcBuff[ head.rowBytes * y ];
+
+            png_read_image( pPNG, pRowPointers.data() );
+
+            for (u_int y=0; y < h; ++y)
+                storeRow( y, pRowPointers[y] );
+        }
+
+        png_read_end( pPNG, NULL );
+    }
+    catch ( ... )
+    {
+        png_destroy_read_struct(&pPNG, &pPNGInfo, NULL);
+        throw;
+    }
+
+    png_destroy_read_struct(&pPNG, &pPNGInfo, NULL);
+}
+
+//==================================================================
+void Image_PNGLoadStream( image &img, const char *pFName, const PNGStreamParams &par )
+{
+    DFileData fileData;
+    if NOT( DUT::MapFile( pFName, fileData ) )
+        DEX_RUNTIME_ERROR( "Could not load '%s'", pFName );
+
+    auto filePar = par;
+    filePar.psp_forceAsSRGB = Image_PNG_DetectSRGBFromFileName( pFName );
+
+    try {
+        Image_PNGLoadStream( img, fileData.GetData(), fileData.size(), filePar );
+    }
+    catch ( ... ) {
+        DEX_RUNTIME_ERROR( "File %s is not a valid PNG file", pFName );
+    }
+}
+
 #endif
 
@@ -9,120 +9,418 @@
 #if !defined(D_NOPNG)
 
 #include "stdafx.h"
-#include "png.h"
+#include <atomic>
+#include "zlib.h"
+#include "DThreads.h"
+#include "DTrace.h"
+#include "ImageConv.h"
 #include "Image_PNG.h"
 
 //==================================================================
-static void convert_16_to_BigEndian( image &img )
+// raw image data per band, big enough for deflate to not lose much
+//  by starting over at each band
+static constexpr size_t PNGSAVE_BAND_BYTES  = 512 * 1024;
+static constexpr size_t PNGSAVE_IDAT_BYTES  = 1024 * 1024;
+
+//==================================================================
+static const char *const _sFilterNames[] =
+{
+    "none", "sub", "up", "average", "paeth", "adaptive",
+};
+
+//==================================================================
+PNGSaveFilter Image_PNGSaveFilterFromName( const DStr &name )
+{
+    for (size_t i=0; i < std::size(_sFilterNames); ++i)
+        if ( name == _sFilterNames[i] )
+            return (PNGSaveFilter)i;
+
+    return PNGSAVE_FILTER_ADAPTIVE;
+}
+
+const char *Image_PNGSaveFilterName( PNGSaveFilter filter )
+{
+    return _sFilterNames[ (size_t)filter < std::size(_sFilterNames) ? filter : PNGSAVE_FILTER_ADAPTIVE ];
+}
+
+//==================================================================
+inline U8 pngsPaeth( int a, int b, int c )
+{
+    c_auto p  = a + b - c;
+    c_auto pa = std::abs( p - a );
+    c_auto pb = std::abs( p - b );
+    c_auto pc = std::abs( p - c );
+
+    if ( pa <= pb && pa <= pc ) return (U8)a;
+    if ( pb <= pc )             return (U8)b;
+    return (U8)c;
+}
+
+//==================================================================
+template <int FILTER>
+inline int pngsPredict( int left, int up, int upLeft )
+{
+    if constexpr ( FILTER == PNGSAVE_FILTER_SUB )     return left;
+    if constexpr ( FILTER == PNGSAVE_FILTER_UP )      return up;
+    if constexpr ( FILTER == PNGSAVE_FILTER_AVERAGE ) return (left + up) >> 1;
+    if constexpr ( FILTER == PNGSAVE_FILTER_PAETH )   return pngsPaeth( left, up, upLeft );
+    return 0;
+}
+
+// one row with one filter, returns the sum of the residuals as signed,
+//  which is what the adaptive choice goes by
+template <int FILTER>
+static size_t pngsFilterRowT(
+            U8 *pDes,
+            const U8 *pCur,
+            const U8 *pPrev,    // all zeros for the first row
+            size_t rowBytes,
+            size_t pixBytes )
+{
+    size_t sum = 0;
+
+    // the first pixel has nothing on its left
+    for (size_t i=0; i < pixBytes; ++i)
+    {
+        c_auto res = (U8)(pCur[i] - pngsPredict<FILTER>( 0, pPrev[i], 0 ));
+        pDes[i] = res;
+        sum += (size_t)std::abs( (int)(int8_t)res );
+    }
+
+    for (size_t i=pixBytes; i < rowBytes; ++i)
+    {
+        c_auto pred = pngsPredict<FILTER>( pCur[i - pixBytes], pPrev[i], pPrev[i - pixBytes] );
+        c_auto res = (U8)(pCur[i] - pred);
+        pDes[i] = res;
+        sum += (size_t)std::abs( (int)(int8_t)res );
+    }
+
+    return sum;
+}
+
+static size_t pngsFilterRow(
+            U8 *pDes,
+            const U8 *pCur,
+            const U8 *pPrev,
+            size_t rowBytes,
+            size_t pixBytes,
+            PNGSaveFilter filter )
+{
+    switch ( filter )
+    {
+    case PNGSAVE_FILTER_SUB:     return pngsFilterRowT<PNGSAVE_FILTER_SUB>( pDes, pCur, pPrev, rowBytes, pixBytes );
+    case PNGSAVE_FILTER_UP:      return pngsFilterRowT<PNGSAVE_FILTER_UP>( pDes, pCur, pPrev, rowBytes, pixBytes );
+    case PNGSAVE_FILTER_AVERAGE: return pngsFilterRowT<PNGSAVE_FILTER_AVERAGE>( pDes, pCur, pPrev, rowBytes, pixBytes );
+    case PNGSAVE_FILTER_PAETH:   return pngsFilterRowT<PNGSAVE_FILTER_PAETH>( pDes, pCur, pPrev, rowBytes, pixBytes );
+    default:                     return pngsFilterRowT<PNGSAVE_FILTER_NONE>( pDes, pCur, pPrev, rowBytes, pixBytes );
+    }
+}
+
+//==================================================================
+struct PNGSaveBand
+{
+    DVec<U8>    psb_deflated;
+    uLong       psb_adler {};
+    size_t      psb_rawSize {};
+};
+
+//==================================================================
+namespace
+{
+struct PNGSaveFormat
+{
+    ImageConv::ChanType srcCT {};
+    ImageConv::ChanType desCT {};
+    u_int               chans {};
+    int                 bitDepth {};
+    int                 colorType {};
+    size_t              pixBytes {};
+    size_t              rowBytes {};
+};
+}
+
+//==================================================================
+// the row y of the output, converted to the PNG format
+static void pngsMakeRow(
+            U8 *pDes,
+            const image &img,
+            const PNGSaveFormat &fmt,
+            u_int y,
+            bool flipY )
+{
+    c_auto srcY = flipY ? img.mH-1 - y : y;
+
+    ImageConv::ConvertParams cpar;
+    cpar.doClamp = (fmt.srcCT == ImageConv::CHANTYPE_F16 || fmt.srcCT == ImageConv::CHANTYPE_F32);
+
+    ImageConv::ConvertFormatRow(
+            pDes, fmt.desCT, fmt.chans,
+            img.GetPixelPtr( 0, srcY ), fmt.srcCT, fmt.chans,
+            img.mW,
+            cpar );
+
+    // PNG is big-endian
+    if ( fmt.bitDepth == 16 )
+    {
+        for (size_t i=0; i < fmt.rowBytes; i += 2)
+            std::swap( pDes[i], pDes[i+1] );
+    }
+}
+
+//==================================================================
+// filters and deflates the rows [y1, y2) on their own. The stream ends
+//  on a byte boundary, so that the bands can be joined
+static void pngsEncodeBand(
+            PNGSaveBand &band,
+            const image &img,
+            const PNGSaveFormat &fmt,
+            const PNGSaveParams &par,
+            u_int y1,
+            u_int y2,
+            bool isLast )
+{
+    c_auto rowBytes = fmt.rowBytes;
+
+    DVec<U8> prevRow( rowBytes );     // zeros above the first row
+    DVec<U8> curRow( rowBytes );
+    DVec<U8> tryRow( rowBytes );
+
+    // the filters look at the row above, also across bands
+    if ( y1 > 0 )
+        pngsMakeRow( prevRow.data(), img, fmt, y1 - 1, par.pss_flipY );
+
+    DVec<U8> filtered( (size_t)(y2 - y1) * (rowBytes + 1) );
+    auto *pOut = filtered.data();
+
+    for (u_int y=y1; y < y2; ++y)
+    {
+        pngsMakeRow( curRow.data(), img, fmt, y, par.pss_flipY );
+
+        c_auto *pPrev = prevRow.data();
+
+        if ( par.pss_filter == PNGSAVE_FILTER_ADAPTIVE )
+        {
+            // the filter with the smallest residuals
+            size_t bestSum = (size_t)-1;
+            for (int f=PNGSAVE_FILTER_NONE; f <= PNGSAVE_FILTER_PAETH; ++f)
+            {
+                c_auto sum = pngsFilterRow(
+                        tryRow.data(), curRow.data(), pPrev, rowBytes, fmt.pixBytes, (PNGSaveFilter)f );
+
+                if ( sum < bestSum )
+                {
+                    bestSum = sum;
+                    pOut[0] = (U8)f;
+                    memcpy( pOut + 1, tryRow.data(), rowBytes );
+                }
+            }
+        }
+        else
+        {
+            pOut[0] = (U8)par.pss_filter;
+            pngsFilterRow( pOut + 1, curRow.data(), pPrev, rowBytes, fmt.pixBytes, par.pss_filter );
+        }
+
+        pOut += rowBytes + 1;
+        std::swap( prevRow, curRow );
+    }
+
+    band.psb_rawSize = filtered.size();
+    band.psb_adler = adler32( adler32( 0, nullptr, 0 ), filtered.data(), (uInt)filtered.size() );
+
+    // raw deflate, the zlib wrapper is added around the joined bands
+    z_stream zs {};
+    c_auto strategy = par.pss_filter == PNGSAVE_FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    c_auto level = DClamp( par.pss_level, -1, 9 );
+    if ( deflateInit2( &zs, level, Z_DEFLATED, -15, 8, strategy ) != Z_OK )
+        DEX_RUNTIME_ERROR( "Failed to init deflate" );
+
+    // room for the worst case and the sync marker
+    band.psb_deflated.resize( deflateBound( &zs, (uLong)filtered.size() ) + 16 );
+
+    zs.next_in   = filtered.data();
+    zs.avail_in  = (uInt)filtered.size();
+    zs.next_out  = band.psb_deflated.data();
+    zs.avail_out = (uInt)band.psb_deflated.size();
+
+    c_auto res = deflate( &zs, isLast ? Z_FINISH : Z_SYNC_FLUSH );
+    c_auto outSize = band.psb_deflated.size() - zs.avail_out;
+    deflateEnd( &zs );
+
+    if ( res != (isLast ? Z_STREAM_END : Z_OK) || zs.avail_in )
+        DEX_RUNTIME_ERROR( "Failed to deflate" );
+
+    band.psb_deflated.resize( outSize );
+}
+
+//==================================================================
+static void pngsPutU32( DVec<U8> &v, uint32_t x )
 {
-	u_int wd = img.mW;
-	u_int he = img.mH;
+    v.push_back( (U8)(x >> 24) );
+    v.push_back( (U8)(x >> 16) );
+    v.push_back( (U8)(x >>  8) );
+    v.push_back( (U8)(x >>  0) );
+}
+
+static void pngsWriteChunk( FILE *pFile, const char *pType, const U8 *pData, size_t size )
+{
+    DVec<U8> head;
+    pngsPutU32( head, (uint32_t)size );
+    head.insert( head.end(), pType, pType + 4 );
 
-	for (u_int y=0; y < he; ++y)
-	{
-		U8	*pRow = img.GetPixelPtr( 0, y );
+    auto crc = crc32( 0, head.data() + 4, 4 );
+    if ( size )
+        crc = crc32( crc, pData, (uInt)size );
 
-		for (u_int i=0; i < wd; ++i)
-		{
-			U8	a = pRow[ i * 2 + 0 ];
-			U8	b = pRow[ i * 2 + 1 ];
+    DVec<U8> tail;
+    pngsPutU32( tail, (uint32_t)crc );
 
-			pRow[ i * 2 + 0 ] = b;
-			pRow[ i * 2 + 1 ] = a;
-		}
-	}
+    if ( fwrite( head.data(), 1, head.size(), pFile ) != head.size() ||
+         (size && fwrite( pData, 1, size, pFile ) != size) ||
+         fwrite( tail.data(), 1, tail.size(), pFile ) != tail.size() )
+    {
+        DEX_RUNTIME_ERROR( "Failed to write" );
+    }
 }
 
 //==================================================================
 void Image_PNGSave( const image &img, const char *pFName, bool flipY )
 {
-    auto *fp = fopen (pFName, "wb");
-    if NOT( fp )
+    PNGSaveParams par;
+    par.pss_flipY = flipY;
+    Image_PNGSave( img, pFName, par );
+}
+
+//==================================================================
+void Image_PNGSave( const image &img, const char *pFName, const PNGSaveParams &par )
+{
+    DTR_SCOPE( "png_save" );
+
+    PNGSaveFormat fmt;
+    fmt.srcCT = ImageConv::GetChanType( img );
+    fmt.chans = img.mChans;
+
+    // float formats are saved as 8 bit, clamped
+    switch ( fmt.srcCT )
+    {
+    case ImageConv::CHANTYPE_U8:
+    case ImageConv::CHANTYPE_F16:
+    case ImageConv::CHANTYPE_F32:
+        fmt.desCT = ImageConv::CHANTYPE_U8;
+        fmt.bitDepth = 8;
+        break;
+
+    case ImageConv::CHANTYPE_U16:
+        fmt.desCT = ImageConv::CHANTYPE_U16;
+        fmt.bitDepth = 16;
+        break;
+
+    default:
+        DEX_RUNTIME_ERROR( "Unsupported color type" );
+    }
+
+    switch ( fmt.chans )
+    {
+    case 1: fmt.colorType = 0; break;   // gray
+    case 2: fmt.colorType = 4; break;   // gray + alpha
+    case 3: fmt.colorType = 2; break;   // RGB
+    case 4: fmt.colorType = 6; break;   // RGBA
+    default:
+        DEX_RUNTIME_ERROR( "Unsupported color type" );
+    }
+
+    if ( !img.mW || !img.mH )
+        DEX_RUNTIME_ERROR( "Empty image" );
+
+    fmt.pixBytes = (size_t)fmt.chans * (fmt.bitDepth / 8);
+    fmt.rowBytes = fmt.pixBytes * img.mW;
+
+    // bands are filtered and deflated in parallel, pigz style
+    c_auto bandRowsN = (u_int)std::max( (size_t)1, PNGSAVE_BAND_BYTES / fmt.rowBytes );
+    c_auto bandsN = (size_t)((img.mH + bandRowsN - 1) / bandRowsN);
+
+    DVec<PNGSaveBand> bands( bandsN );
+    std::atomic<size_t> doneN {};
+
+    DT_ParallelFor( bandsN, 1, [&]( size_t b1, size_t b2 )
+    {
+        for (size_t bi=b1; bi < b2; ++bi)
+        {
+            c_auto y1 = (u_int)bi * bandRowsN;
+            c_auto y2 = std::min( y1 + bandRowsN, img.mH );
+            pngsEncodeBand( bands[bi], img, fmt, par, y1, y2, bi == bandsN-1 );
+
+            c_auto n = doneN.fetch_add( 1 ) + 1;
+            if ( par.pss_onProgressFn )
+                par.pss_onProgressFn( n, bandsN );
+        }
+    });
+
+    // zlib stream: header, the bands in order, checksum of the whole
+    DVec<U8> zdata;
+    {
+        size_t totSize = 6;
+        for (c_auto &b : bands)
+            totSize += b.psb_deflated.size();
+        zdata.reserve( totSize );
+    }
+
+    c_auto levelBits =
+        par.pss_level == 0 || par.pss_level == 1 ? 0 :
+        par.pss_level >= 2 && par.pss_level <= 5 ? 1 :
+        par.pss_level == 6 || par.pss_level < 0  ? 2 : 3;
+
+    c_auto cmf = 0x78u; // deflate, 32K window
+    auto flg = (u_int)levelBits << 6;
+    flg += 31 - (cmf * 256 + flg) % 31;
+    zdata.push_back( (U8)cmf );
+    zdata.push_back( (U8)flg );
+
+    auto adler = adler32( 0, nullptr, 0 );
+    for (c_auto &b : bands)
+    {
+        zdata.insert( zdata.end(), b.psb_deflated.begin(), b.psb_deflated.end() );
+        adler = adler32_combine( adler, b.psb_adler, (z_off_t)b.psb_rawSize );
+    }
+    pngsPutU32( zdata, (uint32_t)adler );
+
+    //
+    DVec<U8> ihdr;
+    pngsPutU32( ihdr, img.mW );
+    pngsPutU32( ihdr, img.mH );
+    ihdr.push_back( (U8)fmt.bitDepth );
+    ihdr.push_back( (U8)fmt.colorType );
+    ihdr.push_back( 0 );    // compression
+    ihdr.push_back( 0 );    // filter method
+    ihdr.push_back( 0 );    // no interlace
+
+    auto *pFile = fopen( pFName, "wb" );
+    if NOT( pFile )
         DEX_RUNTIME_ERROR( "Failed to open '%s' for writing", pFName );
 
-    png_structp png_ptr = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if NOT( png_ptr )
-        DEX_RUNTIME_ERROR( "Failed to create the PNG write struct" );
-
-    png_infop info_ptr = png_create_info_struct (png_ptr);
-    if NOT( info_ptr )
-        DEX_RUNTIME_ERROR( "Failed to create the PNG struct info" );
-
-	int	colorType;
-
-    int depth = 8;
-
-	if ( img.mDepth == 32 )
-		colorType = PNG_COLOR_TYPE_RGB_ALPHA;
-	else
-	if ( img.mDepth == 24 )
-		colorType = PNG_COLOR_TYPE_RGB;
-	else
-	if ( img.mDepth == 16 )
-	{
-		if ( img.mChans != 1 )
-			DEX_RUNTIME_ERROR( "Unsupported color type" );
-
-		colorType = PNG_COLOR_TYPE_GRAY;
-		depth = 16;
-	}
-	else
-	if ( img.mDepth == 8 )
-		colorType = PNG_COLOR_TYPE_GRAY;
-	else
-	{
-		DEX_RUNTIME_ERROR( "Unsupported color type" );
-		return;
-	}
-
-    /* Set image attributes. */
-    png_set_IHDR (png_ptr,
-                  info_ptr,
-                  img.mW,
-                  img.mH,
-                  depth,
-                  colorType,
-                  PNG_INTERLACE_NONE,
-                  PNG_COMPRESSION_TYPE_DEFAULT,
-                  PNG_FILTER_TYPE_DEFAULT);
-
-    /* Initialize rows of PNG. */
-
-	DVec<png_byte *>	rowPtrs;
-	rowPtrs.resize( img.mH );
-
-	const image	*pUseImg;
-	image		xformImg;
-
-	if ( img.mDepth == 16 && img.mChans == 1 )
-	{
-        image::Params par;
-        par.pSrcImg = &img;
-        par.doCopySrcImgPixels = true;
-
-		xformImg.Setup( par );
-
-		convert_16_to_BigEndian( xformImg );
-
-		pUseImg = &xformImg;
-	}
-	else
-		pUseImg = &img;
-
-    for (u_int y = 0; y < pUseImg->mH; ++y)
-	{
-		u_int yy = flipY ? pUseImg->mH-1 - y : y;
-		rowPtrs[y] = (png_byte *)pUseImg->GetPixelPtr( 0, yy );
-	}
-
-    /* Write the image data to "fp". */
-    png_init_io (png_ptr, fp);
-    png_set_rows (png_ptr, info_ptr, &rowPtrs[0] );
-    png_write_png (png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-
-    png_destroy_write_struct (&png_ptr, &info_ptr);
-    fclose (fp);
+    try {
+        static const U8 sSig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+        if ( fwrite( sSig, 1, sizeof(sSig), pFile ) != sizeof(sSig) )
+            DEX_RUNTIME_ERROR( "Failed to write" );
+
+        pngsWriteChunk( pFile, "IHDR", ihdr.data(), ihdr.size() );
+
+        for (size_t i=0; i < zdata.size(); i += PNGSAVE_IDAT_BYTES)
+        {
+            c_auto n = std::min( PNGSAVE_IDAT_BYTES, zdata.size() - i );
+            pngsWriteChunk( pFile, "IDAT", zdata.data() + i, n );
+        }
+
+        pngsWriteChunk( pFile, "IEND", nullptr, 0 );
+    }
+    catch (...)
+    {
+        fclose( pFile );
+        DEX_RUNTIME_ERROR( "Failed to write '%s'", pFName );
+    }
+
+    if ( fclose( pFile ) != 0 )
+        DEX_RUNTIME_ERROR( "Failed to write '%s'", pFName );
 }
 
 #endif
-
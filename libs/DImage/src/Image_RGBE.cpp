@@ -8,6 +8,7 @@
 
 #include "stdafx.h"
 #include "DHalf.h"
+#include "DTrace.h"
 #include "Image_RGBE.h"
 
 //=============================================================================
@@ -582,6 +583,8 @@ void RGBE_GetFloatRGB( u_int rgbecol, float *out_floatrgb )
 //==================================================================
 void Image_RGBELoad( image &img, u_int imgBaseFlags, const U8 *pData, size_t dataSize )
 {
+    DTR_SCOPE( "rgbe_decode" );
+
     rgbe_header_info    info;
     int                 wd = 0;
     int                 he = 0;
@@ -15,6 +15,7 @@
 
 #include "TimeUtils.h"
 #include "DLogOut.h"
+#include "DTrace.h"
 #include "DNET.h"
 #include "DNET_PacketManager.h"
 
@@ -41,6 +42,8 @@ class PMMaster
     std::mutex              mManagersMutex;
     DVec<PacketManager *>   mpManagers;
 
+    size_t                  mTracedSocketsN = DNPOS;
+
 public:
     PMMaster()
     {
@@ -49,8 +52,17 @@ public:
             DVec<PacketManager *> pUsePMs;
             DVec<pollfd> pfds;
 
+            bool hasName = false;
+
             while NOT( mThreadQuitMsg )
             {
+                // we start statically, the log may come later
+                if ( !hasName && LogGetInstance() )
+                {
+                    LogSetThreadName( "PMMaster" );
+                    hasName = true;
+                }
+
                 if ( animThread( pUsePMs, pfds ) )
                     SleepSecs( 1.0 / 1000 );
                 else
@@ -102,6 +114,12 @@ public:
         if ( pfds.empty() )
             return false;
 
+        if ( mTracedSocketsN != pfds.size() && DTR_IsTracing() )
+        {
+            mTracedSocketsN = pfds.size();
+            DTR_Counter( "pm_sockets", (double)mTracedSocketsN );
+        }
+
         // NOTE: we're assuming that RLIMIT_NOFILE is comfortably larger than this
         constexpr size_t CHUNK_N = 128;
 
@@ -134,6 +152,12 @@ public:
                 continue;
             }
 
+            // nothing ready in this chunk
+            if ( ret == 0 )
+                continue;
+
+            DTR_SCOPE( "pm_io" );
+
             // parse the tasks in this chunk
             for (size_t i=i1; i < i2; ++i)
             {
@@ -213,6 +237,8 @@ PacketManager::PacketManager( SOCKET socket ) : mSocket(socket)
 #else
     mThread = std::thread( [this]()
     {
+        LogThreadNameScope nameScope( "PacketManager" );
+
         while NOT( mThreadQuitMsg )
         {
             if ( mConnError || mProtoError )
@@ -468,6 +494,8 @@ bool PacketManager::animIO_HandleSendList()
     if ( mSendList.mQueue.empty() )
         return true;
 
+    DTR_SCOPE( "pm_send" );
+
     std::lock_guard<std::mutex> lock( mSendList.mInQueueCS );
 
     // as long as we have entries to send..
@@ -519,6 +547,8 @@ bool PacketManager::animIO_HandleSendList()
 //==================================================================
 bool PacketManager::animIO_HandleReceive()
 {
+    DTR_SCOPE( "pm_recv" );
+
     auto &recvBuff                  = mAIOS.recvBuff;
     auto &curRecvPackDoneHeadSize   = mAIOS.curRecvPackDoneHeadSize;
     auto &curRecvPackDataSize       = mAIOS.curRecvPackDataSize    ;
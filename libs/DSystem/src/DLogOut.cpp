@@ -211,6 +211,10 @@ void LogPopPrefix()
 //==================================================================
 void LogSetThreadName( const DStr &name )
 {
+    // threads may start before the log
+    if NOT( _spLOG )
+        return;
+
     LogRemoveThreadName();
 
     std::lock_guard<std::mutex> lock(_spLOG->mLogMutex);
@@ -221,6 +225,9 @@ void LogSetThreadName( const DStr &name )
 //==================================================================
 void LogRemoveThreadName()
 {
+    if NOT( _spLOG )
+        return;
+
     std::lock_guard<std::mutex> lock(_spLOG->mLogMutex);
 
     auto it = _spLOG->mThreadNames.find( std::this_thread::get_id() );
@@ -228,6 +235,21 @@ void LogRemoveThreadName()
         _spLOG->mThreadNames.erase( it );
 }
 
+//==================================================================
+DStr LogGetThreadName( const std::thread::id &id )
+{
+    if NOT( _spLOG )
+        return {};
+
+    std::lock_guard<std::mutex> lock(_spLOG->mLogMutex);
+
+    if ( id == _spLOG->mMainThreadID )
+        return "main";
+
+    auto it = _spLOG->mThreadNames.find( id );
+    return it != _spLOG->mThreadNames.end() ? it->second : DStr();
+}
+
 //==================================================================
 void LogOut( u_int flags, const DStr &str )
 {
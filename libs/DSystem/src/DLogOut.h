@@ -9,6 +9,7 @@
 #ifndef DLOGOUT_H
 #define DLOGOUT_H
 
+#include <thread>
 #include "DBase.h"
 #include "DSafeCrt.h"
 #include "StringUtils.h"
@@ -52,6 +53,8 @@ void LogPushPrefix( const DStr &str );
 void LogPopPrefix();
 void LogSetThreadName( const DStr &name );
 void LogRemoveThreadName();
+// "main" for the main thread, empty if it has no name
+DStr LogGetThreadName( const std::thread::id &id );
 
 void LogOut( u_int flags, const DStr &str );
 void LogOut( u_int flags, const char *pFmt, ... );
@@ -0,0 +1,244 @@
+//==================================================================
+/// DThreads.cpp
+///
+/// Created by Davide Pasca - 2018/11/08
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#if defined(_MSC_VER)
+# include <Windows.h>
+#else
+# include <sys/resource.h>
+# include <unistd.h>
+# include <pthread.h>
+#endif
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include "DThreads.h"
+
+//==================================================================
+namespace
+{
+
+//==================================================================
+struct ParForJob
+{
+    const DFun<void (size_t, size_t)>   *mpFn {};
+    size_t                  mN {};
+    size_t                  mBandN {};
+    size_t                  mBandsN {};
+    std::atomic<size_t>     mNextBand {0};
+    std::atomic<size_t>     mDoneBands {0};
+
+    std::mutex              mDoneMutex;
+    std::condition_variable mDoneCV;
+    std::exception_ptr      mExPtr;
+    std::atomic<size_t>     mWorkersN {0};
+
+    // returns false when there are no more bands to pick
+    bool RunNextBand()
+    {
+        c_auto bi = mNextBand.fetch_add( 1 );
+        if ( bi >= mBandsN )
+            return false;
+
+        c_auto begin = bi * mBandN;
+        c_auto end   = std::min( begin + mBandN, mN );
+
+        try {
+            (*mpFn)( begin, end );
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock( mDoneMutex );
+            if NOT( mExPtr )
+                mExPtr = std::current_exception();
+        }
+
+        if ( mDoneBands.fetch_add( 1 ) + 1 == mBandsN )
+        {
+            std::lock_guard<std::mutex> lock( mDoneMutex );
+            mDoneCV.notify_all();
+        }
+
+        return true;
+    }
+};
+
+//==================================================================
+class ParForPool
+{
+    std::mutex                  mMutex;
+    std::condition_variable     mCV;
+    std::deque<ParForJob *>     mJobs;
+    DVec<std::thread>           mThreads;
+    bool                        mQuit {};
+
+public:
+    ParForPool()
+    {
+        c_auto hwN = (size_t)std::thread::hardware_concurrency();
+
+        // the calling thread also works, so we start one less
+        for (size_t i=1; i < hwN; ++i)
+            mThreads.emplace_back( [this](){ workerLoop(); } );
+    }
+
+    ~ParForPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mQuit = true;
+        }
+        mCV.notify_all();
+
+        for (auto &t : mThreads)
+            t.join();
+    }
+
+    size_t GetThreadsN() const { return mThreads.size() + 1; }
+
+    void Run( ParForJob &job )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mJobs.push_back( &job );
+        }
+        mCV.notify_all();
+
+        // help out with our own job
+        while ( job.RunNextBand() )
+        {
+        }
+
+        // no more bands to pick, make sure that no worker sees the job anymore
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            std::erase( mJobs, &job );
+        }
+
+        // wait for the workers still on the job
+        std::unique_lock<std::mutex> lock( job.mDoneMutex );
+        job.mDoneCV.wait( lock, [&](){
+            return job.mDoneBands == job.mBandsN && job.mWorkersN == 0; } );
+    }
+
+private:
+    void workerLoop()
+    {
+        LogSetThreadName( "parfor" );
+
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock( mMutex );
+            mCV.wait( lock, [&](){ return mQuit || !mJobs.empty(); } );
+
+            if ( mQuit )
+                return;
+
+            auto *pJob = mJobs.front();
+            if NOT( pJob->mNextBand < pJob->mBandsN )
+            {
+                // all bands taken, nothing left for us
+                mJobs.pop_front();
+                continue;
+            }
+
+            // registered in the lock, so that the job is kept alive for us
+            pJob->mWorkersN += 1;
+            lock.unlock();
+
+            while ( pJob->RunNextBand() )
+            {
+            }
+
+            std::lock_guard<std::mutex> doneLock( pJob->mDoneMutex );
+            pJob->mWorkersN -= 1;
+            pJob->mDoneCV.notify_all();
+        }
+    }
+};
+
+//==================================================================
+ParForPool &getPool()
+{
+    static ParForPool sPool;
+    return sPool;
+}
+
+}
+
+//==================================================================
+size_t DT_GetParallelThreadsN()
+{
+    return getPool().GetThreadsN();
+}
+
+//==================================================================
+void DT_ParallelFor(
+        size_t n,
+        size_t minBandN,
+        const DFun<void (size_t begin, size_t end)> &fn )
+{
+    if NOT( n )
+        return;
+
+    auto &pool = getPool();
+
+    // a few bands per thread, for some load balancing
+    c_auto threadsN = pool.GetThreadsN();
+    c_auto bandN = std::max( std::max( minBandN, (size_t)1 ),
+                             (n + threadsN * 4 - 1) / (threadsN * 4) );
+
+    if ( threadsN <= 1 || bandN >= n )
+    {
+        fn( 0, n );
+        return;
+    }
+
+    ParForJob job;
+    job.mpFn    = &fn;
+    job.mN      = n;
+    job.mBandN  = bandN;
+    job.mBandsN = (n + bandN - 1) / bandN;
+
+    pool.Run( job );
+
+    if ( job.mExPtr )
+        std::rethrow_exception( job.mExPtr );
+}
+
+//==================================================================
+static void setCurThreadLowPriority()
+{
+#if defined(_MSC_VER)
+    SetThreadPriority( GetCurrentThread(), THREAD_PRIORITY_LOWEST );
+#elif defined(__linux__)
+    // the nice value is per-thread on Linux
+    setpriority( PRIO_PROCESS, (id_t)gettid(), 19 );
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np( QOS_CLASS_BACKGROUND, 0 );
+#endif
+}
+
+//==================================================================
+std::future<void> DT_AsyncLowPriority( DFun<void ()> fn )
+{
+    // a thread of its own, std::async() may reuse them
+    std::packaged_task<void ()> task( std::move( fn ) );
+    auto fut = task.get_future();
+
+    std::thread( [task=std::move( task )]() mutable
+    {
+        setCurThreadLowPriority();
+        task();
+    }).detach();
+
+    return fut;
+}
+
@@ -86,5 +86,22 @@ public:
     }
 };
 
+//==================================================================
+// Number of threads that DT_ParallelFor() can spread work on
+size_t DT_GetParallelThreadsN();
+
+// Split [0, n) in bands of at least minBandN items and call fn(begin, end)
+//  for each band, on the shared worker threads and on the calling thread.
+// Returns when all the bands are done. Exceptions are rethrown to the caller.
+void DT_ParallelFor(
+        size_t n,
+        size_t minBandN,
+        const DFun<void (size_t begin, size_t end)> &fn );
+
+// Like std::async(), on a new thread at the lowest priority, for the
+//  background work that should only take what's left over by the rest.
+//  Exceptions go in the future
+std::future<void> DT_AsyncLowPriority( DFun<void ()> fn );
+
 #endif
 
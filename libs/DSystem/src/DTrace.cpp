@@ -0,0 +1,306 @@
+//==================================================================
+/// DTrace.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include "TimeUtils.h"
+#include "DLogOut.h"
+#include "DTrace.h"
+
+//==================================================================
+namespace
+{
+
+constexpr size_t CHUNK_EVENTS_N  = 4096;
+constexpr size_t MAX_CHUNKS_N    = 256;  // ~1M events per thread
+
+//==================================================================
+struct TraceEvent
+{
+    const char  *te_pName {};
+    int64_t     te_tsUS {};
+    uint64_t    te_id {};
+    double      te_val {};
+    DTR_Type    te_type {};
+};
+
+//==================================================================
+// Written only by the owning thread. The events count is published
+//  last, so that a reader sees only complete events
+struct ThreadBuf
+{
+    std::thread::id         tb_threadID;
+    DStr                    tb_threadName;  // at the time it was taken
+    u_int                   tb_tid {};
+
+    std::atomic<bool>       tb_isOwned {};
+    std::atomic<uint64_t>   tb_session {};
+    std::atomic<size_t>     tb_eventsN {};
+    std::atomic<size_t>     tb_droppedN {};
+
+    uptr<TraceEvent[]>      tb_oChunks[MAX_CHUNKS_N];
+};
+
+//==================================================================
+struct TraceWork
+{
+    std::mutex              mMutex;     // for the buffers list and the sessions
+    DVec<uptr<ThreadBuf>>   moBufs;
+
+    std::atomic<uint64_t>   mSession {};
+    std::atomic<int64_t>    mStartUS {};
+    std::atomic<uint64_t>   mNextFlowID {1};
+
+    ThreadBuf *TakeBuf()
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+
+        c_auto session = mSession.load();
+
+        // reuse the buffer of an ended thread, if it has nothing to save
+        ThreadBuf *pBuf {};
+        for (auto &oBuf : moBufs)
+        {
+            if ( oBuf->tb_isOwned )
+                continue;
+
+            if ( oBuf->tb_session != session || !oBuf->tb_eventsN )
+            {
+                pBuf = oBuf.get();
+                break;
+            }
+        }
+
+        if NOT( pBuf )
+        {
+            moBufs.push_back( std::make_unique<ThreadBuf>() );
+            pBuf = moBufs.back().get();
+            pBuf->tb_tid = (u_int)moBufs.size();
+        }
+
+        pBuf->tb_threadID   = std::this_thread::get_id();
+        pBuf->tb_threadName = LogGetThreadName( pBuf->tb_threadID );
+        pBuf->tb_isOwned    = true;
+
+        return pBuf;
+    }
+};
+
+TraceWork &getTW()
+{
+    static TraceWork sTW;
+    return sTW;
+}
+
+//==================================================================
+struct ThreadBufHolder
+{
+    ThreadBuf   *mpBuf {};
+
+    ~ThreadBufHolder()
+    {
+        if ( mpBuf )
+            mpBuf->tb_isOwned = false;
+    }
+};
+
+thread_local ThreadBufHolder    _tDTR_Holder;
+
+}
+
+//==================================================================
+void DTR_StartTrace()
+{
+    auto &tw = getTW();
+
+    std::lock_guard<std::mutex> lock( tw.mMutex );
+
+    tw.mStartUS = GetSteadyTimeUS().CalcTimeUS();
+    tw.mSession += 1;
+
+    _gDTR_IsTracing = true;
+}
+
+//==================================================================
+void DTR_StopTrace()
+{
+    _gDTR_IsTracing = false;
+}
+
+//==================================================================
+uint64_t DTR_NewFlowID()
+{
+    return getTW().mNextFlowID.fetch_add( 1, std::memory_order_relaxed );
+}
+
+//==================================================================
+void DTR_AddEvent( DTR_Type type, const char *pName, uint64_t id, double val )
+{
+    auto &tw = getTW();
+
+    auto *pBuf = _tDTR_Holder.mpBuf;
+    if NOT( pBuf )
+        pBuf = _tDTR_Holder.mpBuf = tw.TakeBuf();
+
+    // first event of a new session for this thread
+    if (c_auto session = tw.mSession.load( std::memory_order_acquire );
+               session != pBuf->tb_session.load( std::memory_order_relaxed ))
+    {
+        pBuf->tb_eventsN.store( 0, std::memory_order_release );
+        pBuf->tb_droppedN.store( 0, std::memory_order_relaxed );
+        pBuf->tb_session.store( session, std::memory_order_release );
+    }
+
+    c_auto n = pBuf->tb_eventsN.load( std::memory_order_relaxed );
+
+    c_auto chunkI = n / CHUNK_EVENTS_N;
+    if ( chunkI >= MAX_CHUNKS_N )
+    {
+        pBuf->tb_droppedN.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    auto &oChunk = pBuf->tb_oChunks[ chunkI ];
+    if NOT( oChunk )
+        oChunk = std::make_unique<TraceEvent[]>( CHUNK_EVENTS_N );
+
+    auto &ev = oChunk[ n % CHUNK_EVENTS_N ];
+    ev.te_pName = pName;
+    ev.te_tsUS  = GetSteadyTimeUS().CalcTimeUS();
+    ev.te_id    = id;
+    ev.te_val   = val;
+    ev.te_type  = type;
+
+    pBuf->tb_eventsN.store( n + 1, std::memory_order_release );
+}
+
+//==================================================================
+static DStr dtrEscape( const char *pStr )
+{
+    DStr out;
+    for (; *pStr; ++pStr)
+    {
+        if ( *pStr == '"' || *pStr == '\\' )
+            out += '\\';
+
+        out += *pStr;
+    }
+    return out;
+}
+
+//==================================================================
+bool DTR_SaveTrace( const DStr &pathFName )
+{
+    auto &tw = getTW();
+
+    // buffers can't be taken while we're at it
+    std::lock_guard<std::mutex> lock( tw.mMutex );
+
+    std::ofstream ofs( pathFName, std::ios::out | std::ios::trunc );
+    if NOT( ofs.is_open() )
+    {
+        LogOut( LOG_ERR, "Could not create '%s'", pathFName.c_str() );
+        return false;
+    }
+
+    c_auto session = tw.mSession.load();
+    c_auto startUS = tw.mStartUS.load();
+
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool isFirst = true;
+    auto beginEvent = [&]()
+    {
+        ofs << (isFirst ? "" : ",\n");
+        isFirst = false;
+    };
+
+    size_t savedN = 0;
+    size_t droppedN = 0;
+
+    for (c_auto &oBuf : tw.moBufs)
+    {
+        c_auto &buf = *oBuf;
+
+        if ( buf.tb_session.load( std::memory_order_acquire ) != session )
+            continue;
+
+        c_auto n = buf.tb_eventsN.load( std::memory_order_acquire );
+        if NOT( n )
+            continue;
+
+        droppedN += buf.tb_droppedN.load( std::memory_order_relaxed );
+
+        // the current name, if the thread is still around
+        auto name = buf.tb_isOwned ? LogGetThreadName( buf.tb_threadID ) : DStr();
+        if ( name.empty() )
+            name = buf.tb_threadName;
+        if ( name.empty() )
+            name = SSPrintFS( "thread %u", buf.tb_tid );
+
+        beginEvent();
+        ofs << SSPrintFS(
+                "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"%s\"}}",
+                buf.tb_tid, dtrEscape( name.c_str() ).c_str() );
+
+        for (size_t i=0; i < n; ++i)
+        {
+            c_auto &ev = buf.tb_oChunks[ i / CHUNK_EVENTS_N ][ i % CHUNK_EVENTS_N ];
+
+            beginEvent();
+            ofs << SSPrintFS(
+                    "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%u",
+                    dtrEscape( ev.te_pName ).c_str(),
+                    (char)ev.te_type,
+                    (long long)(ev.te_tsUS - startUS),
+                    buf.tb_tid );
+
+            switch ( ev.te_type )
+            {
+            case DTR_COUNTER:
+                ofs << SSPrintFS( ",\"args\":{\"value\":%g}", ev.te_val );
+                break;
+
+            case DTR_FLOW_START:
+            case DTR_FLOW_STEP:
+                ofs << SSPrintFS( ",\"cat\":\"flow\",\"id\":%llu", (unsigned long long)ev.te_id );
+                break;
+
+            case DTR_FLOW_END:
+                ofs << SSPrintFS( ",\"cat\":\"flow\",\"id\":%llu,\"bp\":\"e\"",
+                                    (unsigned long long)ev.te_id );
+                break;
+
+            default:
+                break;
+            }
+
+            ofs << "}";
+        }
+
+        savedN += n;
+    }
+
+    ofs << "\n]}\n";
+
+    if NOT( ofs.good() )
+    {
+        LogOut( LOG_ERR, "Failed to write '%s'", pathFName.c_str() );
+        return false;
+    }
+
+    LogOut( 0, "Saved %zu trace events to %s", savedN, pathFName.c_str() );
+
+    if ( droppedN )
+        LogOut( LOG_WRN, "Dropped %zu trace events, the buffers were full", droppedN );
+
+    return true;
+}
+
@@ -0,0 +1,117 @@
+//==================================================================
+/// DTrace.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef DTRACE_H
+#define DTRACE_H
+
+#include <atomic>
+#include "DBase.h"
+
+//==================================================================
+// Trace events for a timeline of all the threads, saved in the
+//  Chrome/Perfetto trace format (chrome://tracing, ui.perfetto.dev).
+// Each thread writes to its own buffer without locks. When tracing is
+//  off, an event costs a relaxed atomic load.
+// Event names must be literals (they are kept as pointers).
+//==================================================================
+
+inline std::atomic<bool>    _gDTR_IsTracing;
+
+inline bool DTR_IsTracing() { return _gDTR_IsTracing.load( std::memory_order_relaxed ); }
+
+// start a new session, the events of the previous one are dropped
+void DTR_StartTrace();
+void DTR_StopTrace();
+
+// save the events of the current session so far, as JSON
+bool DTR_SaveTrace( const DStr &pathFName );
+
+enum DTR_Type : char
+{
+    DTR_BEGIN       = 'B',
+    DTR_END         = 'E',
+    DTR_COUNTER     = 'C',
+    DTR_FLOW_START  = 's',
+    DTR_FLOW_STEP   = 't',
+    DTR_FLOW_END    = 'f',
+};
+
+void DTR_AddEvent( DTR_Type type, const char *pName, uint64_t id, double val );
+
+// an ID to link the flow events of a piece of work across threads
+uint64_t DTR_NewFlowID();
+
+//==================================================================
+inline void DTR_Begin( const char *pName )
+{
+    if ( DTR_IsTracing() )
+        DTR_AddEvent( DTR_BEGIN, pName, 0, 0 );
+}
+
+inline void DTR_End( const char *pName )
+{
+    if ( DTR_IsTracing() )
+        DTR_AddEvent( DTR_END, pName, 0, 0 );
+}
+
+inline void DTR_Counter( const char *pName, double val )
+{
+    if ( DTR_IsTracing() )
+        DTR_AddEvent( DTR_COUNTER, pName, 0, val );
+}
+
+// flow events attach to the slice that is open on the thread
+inline void DTR_FlowStart( const char *pName, uint64_t id )
+{
+    if ( DTR_IsTracing() )
+        DTR_AddEvent( DTR_FLOW_START, pName, id, 0 );
+}
+
+inline void DTR_FlowStep( const char *pName, uint64_t id )
+{
+    if ( DTR_IsTracing() )
+        DTR_AddEvent( DTR_FLOW_STEP, pName, id, 0 );
+}
+
+inline void DTR_FlowEnd( const char *pName, uint64_t id )
+{
+    if ( DTR_IsTracing() )
+        DTR_AddEvent( DTR_FLOW_END, pName, id, 0 );
+}
+
+//==================================================================
+class DTR_Scope
+{
+    const char  *mpName {};
+
+public:
+    DTR_Scope( const char *pName )
+    {
+        // an end only if there was a begin, in case tracing gets toggled
+        if ( DTR_IsTracing() )
+        {
+            mpName = pName;
+            DTR_AddEvent( DTR_BEGIN, pName, 0, 0 );
+        }
+    }
+
+    ~DTR_Scope()
+    {
+        if ( mpName )
+            DTR_AddEvent( DTR_END, mpName, 0, 0 );
+    }
+};
+
+#define DTR_SCOPE_CAT2(_A_,_B_)     _A_##_B_
+#define DTR_SCOPE_CAT(_A_,_B_)      DTR_SCOPE_CAT2(_A_,_B_)
+
+// trace the rest of the scope as a slice named _NAME_
+#define DTR_SCOPE( _NAME_ )  DTR_Scope DTR_SCOPE_CAT(_dtrScope,__LINE__)( _NAME_ )
+
+#endif
+
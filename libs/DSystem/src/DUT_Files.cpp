@@ -6,6 +6,23 @@
 /// copyright info.
 //==================================================================
 
+#if defined(_MSC_VER)
+# include <Windows.h>
+#elif !defined(__EMSCRIPTEN__)
+# define DUT_HAS_MMAP
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <ctime>
+# if defined(__APPLE__)
+#  include <sys/param.h>
+#  include <sys/mount.h>
+# else
+#  include <sys/vfs.h>
+# endif
+#endif
+
 #include "DUT_Files.h"
 #include "FileUtils.h"
 
@@ -132,6 +149,224 @@ bool GrabFile( const char *pFileName, DFileData &out_fdata, int fxSiz )
 	return true;
 }
 
+//==================================================================
+#if defined(DUT_HAS_MMAP)
+static void onMappedFileDataDtor( DFileData *pFData )
+{
+    if ( pFData->pData )
+        munmap( pFData->pData, pFData->dataSize );
+
+    pFData->pData = nullptr;
+}
+
+// the page cache of network file systems may not see the changes of
+//  other hosts, and a mapping can fault when the server goes away
+static bool isRemoteFS( int fd )
+{
+    struct statfs sfs {};
+    if ( fstatfs( fd, &sfs ) != 0 )
+        return true;
+
+# if defined(__APPLE__)
+    return !strcmp( sfs.f_fstypename, "nfs" ) ||
+           !strcmp( sfs.f_fstypename, "smbfs" ) ||
+           !strcmp( sfs.f_fstypename, "afpfs" ) ||
+           !strcmp( sfs.f_fstypename, "webdav" );
+# else
+    switch ( (unsigned long)sfs.f_type )
+    {
+    case 0x6969:        // NFS
+    case 0x517B:        // SMB
+    case 0xFF534D42:    // CIFS
+    case 0xFE534D42:    // SMB2
+    case 0x65735546:    // FUSE, sshfs and the like
+    case 0x564C:        // NCP
+    case 0x00C36400:    // Ceph
+    case 0x47504653:    // GPFS
+    case 0x0BD00BD0:    // Lustre
+        return true;
+    default:
+        return false;
+    }
+# endif
+}
+
+// a renderer may still be writing it, or rewriting it in place
+static bool isRecentFile( const struct stat &st, double minAgeS )
+{
+    return minAgeS > 0 && difftime( time( nullptr ), st.st_mtime ) < minAgeS;
+}
+#elif defined(_MSC_VER)
+static void onMappedFileDataDtor( DFileData *pFData )
+{
+    if ( pFData->pData )
+        UnmapViewOfFile( pFData->pData );
+
+    pFData->pData = nullptr;
+}
+
+static bool isRemotePath( const char *pFileName )
+{
+    // UNC paths, or a mapped network drive
+    if ( (pFileName[0] == '\\' && pFileName[1] == '\\') ||
+         (pFileName[0] == '/' && pFileName[1] == '/') )
+        return true;
+
+    if ( pFileName[0] && pFileName[1] == ':' )
+    {
+        const char root[] = { pFileName[0], ':', '\\', 0 };
+        return GetDriveTypeA( root ) == DRIVE_REMOTE;
+    }
+
+    return false;
+}
+
+// a renderer may still be writing it, and couldn't truncate it while mapped
+static bool isRecentFile( HANDLE hFile, double minAgeS )
+{
+    if ( minAgeS <= 0 )
+        return false;
+
+    FILETIME writeFT {};
+    if NOT( GetFileTime( hFile, nullptr, nullptr, &writeFT ) )
+        return true;
+
+    FILETIME nowFT {};
+    GetSystemTimeAsFileTime( &nowFT );
+
+    c_auto toU64 = []( const FILETIME &ft )
+    {
+        return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    };
+
+    // in 100 ns units
+    c_auto writeT = toU64( writeFT );
+    c_auto nowT = toU64( nowFT );
+    return nowT < writeT || (double)(nowT - writeT) * 1e-7 < minAgeS;
+}
+#endif
+
+//==================================================================
+bool MapFile( const char *pFileName, DFileData &out_fdata, int fxSiz, const MapFileParams &par )
+{
+#if defined(DUT_HAS_MMAP)
+    c_auto fd = open( pFileName, O_RDONLY );
+    if ( fd < 0 )
+        return false;
+
+    struct stat st {};
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        return false;
+    }
+
+    auto mapSize = (size_t)st.st_size;
+    if ( fxSiz != -1 )
+        mapSize = std::min( mapSize, (size_t)fxSiz );
+
+    if ( mapSize < std::max( par.mfp_minMapSize, (size_t)1 ) ||
+         isRecentFile( st, par.mfp_minAgeS ) ||
+         (!par.mfp_allowRemote && isRemoteFS( fd )) )
+    {
+        close( fd );
+        return GrabFile( pFileName, out_fdata, fxSiz );
+    }
+
+    int flags = MAP_PRIVATE;
+# if defined(MAP_POPULATE)
+    if ( par.mfp_populate )
+        flags |= MAP_POPULATE;
+# endif
+
+    // read-only, a writable private mapping would be copied as it's populated
+    auto *pMap = mmap( nullptr, mapSize, PROT_READ, flags, fd, 0 );
+
+    // the mapping keeps its own reference to the file
+    close( fd );
+
+    if ( pMap == MAP_FAILED )
+        return GrabFile( pFileName, out_fdata, fxSiz );
+
+    if ( par.mfp_sequential )
+        madvise( pMap, mapSize, MADV_SEQUENTIAL );
+
+# if !defined(MAP_POPULATE)
+    if ( par.mfp_populate )
+        madvise( pMap, mapSize, MADV_WILLNEED );
+# endif
+
+    out_fdata.pData     = (U8 *)pMap;
+    out_fdata.dataSize  = mapSize;
+    out_fdata.dtorCB    = onMappedFileDataDtor;
+
+    return true;
+
+#elif defined(_MSC_VER)
+    if ( !par.mfp_allowRemote && isRemotePath( pFileName ) )
+        return GrabFile( pFileName, out_fdata, fxSiz );
+
+    c_auto hFile = CreateFileA(
+                        pFileName,
+                        GENERIC_READ,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        nullptr,
+                        OPEN_EXISTING,
+                        par.mfp_sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL,
+                        nullptr );
+
+    if ( hFile == INVALID_HANDLE_VALUE )
+        return false;
+
+    LARGE_INTEGER fsize {};
+    if NOT( GetFileSizeEx( hFile, &fsize ) )
+    {
+        CloseHandle( hFile );
+        return false;
+    }
+
+    auto mapSize = (size_t)fsize.QuadPart;
+    if ( fxSiz != -1 )
+        mapSize = std::min( mapSize, (size_t)fxSiz );
+
+    if ( mapSize < std::max( par.mfp_minMapSize, (size_t)1 ) ||
+         isRecentFile( hFile, par.mfp_minAgeS ) )
+    {
+        CloseHandle( hFile );
+        return GrabFile( pFileName, out_fdata, fxSiz );
+    }
+
+    c_auto hMapping = CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    CloseHandle( hFile );
+
+    if NOT( hMapping )
+        return GrabFile( pFileName, out_fdata, fxSiz );
+
+    auto *pMap = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, mapSize );
+
+    // the view keeps the mapping alive
+    CloseHandle( hMapping );
+
+    if NOT( pMap )
+        return GrabFile( pFileName, out_fdata, fxSiz );
+
+    if ( par.mfp_populate )
+    {
+        WIN32_MEMORY_RANGE_ENTRY range { pMap, mapSize };
+        PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+    }
+
+    out_fdata.pData     = (U8 *)pMap;
+    out_fdata.dataSize  = mapSize;
+    out_fdata.dtorCB    = onMappedFileDataDtor;
+
+    return true;
+#else
+    (void)par;
+    return GrabFile( pFileName, out_fdata, fxSiz );
+#endif
+}
+
 //==================================================================
 bool SaveFile( const char *pFileName, const U8 *pInData, size_t dataSize )
 {
@@ -47,6 +47,25 @@ bool FileExists( const char *pFileName );
 bool GrabFile( const char *pFileName, DVec<U8> &out_data, int fxSiz=-1 );
 bool GrabFile( const char *pFileName, DFileData &out_fdata, int fxSiz=-1 );
 
+//==================================================================
+struct MapFileParams
+{
+    bool    mfp_sequential  { true };       // madvise(MADV_SEQUENTIAL)
+    bool    mfp_populate    { true };       // MAP_POPULATE, fault it all in at once
+    size_t  mfp_minMapSize  { 64 * 1024 };  // smaller files are read
+    bool    mfp_allowRemote { false };      // map also on network file systems
+    double  mfp_minAgeS     { 5.0 };        // files modified since are read
+};
+
+// Like GrabFile(), but the data is mapped instead of read into a copy.
+//  Falls back to reading on network file systems, for small files, for
+//  files modified in the last mfp_minAgeS, or if the mapping fails.
+//  Mapped data is read-only, writing to it faults.
+// Files that are truncated while mapped fault on access. The recent ones
+//  may still be written in place, so they're read. Set mfp_minAgeS to 0
+//  only for files that are written to a temporary and renamed.
+bool MapFile( const char *pFileName, DFileData &out_fdata, int fxSiz=-1, const MapFileParams &par={} );
+
 bool SaveFile( const char *pFileName, const U8 *pInData, size_t dataSize );
 
 bool GrabFile( const char *pFileName, MemReader &reader, int fxSiz=-1 );
@@ -0,0 +1,390 @@
+//==================================================================
+/// FilePrefetcher.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#if defined(__linux__)
+# define FPR_HAS_FADVISE
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <filesystem>
+#include "DLogOut.h"
+#include "DTrace.h"
+#include "FilePrefetcher.h"
+
+//==================================================================
+// size and modification time, to tell if the file changed after the read
+static bool fprGetFileStamp( const DStr &pathFName, int64_t &out_time, size_t &out_size )
+{
+    std::error_code ec;
+    c_auto path = std::filesystem::path( pathFName );
+
+    c_auto siz = std::filesystem::file_size( path, ec );
+    if ( ec )
+        return false;
+
+    c_auto tim = std::filesystem::last_write_time( path, ec );
+    if ( ec )
+        return false;
+
+    out_size = (size_t)siz;
+    out_time = (int64_t)tim.time_since_epoch().count();
+    return true;
+}
+
+//==================================================================
+static void fprWarmFile( const DStr &pathFName )
+{
+#if defined(FPR_HAS_FADVISE)
+    // the system reads it in the background, no need to wait
+    c_auto fd = open( pathFName.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        return;
+
+    posix_fadvise( fd, 0, 0, POSIX_FADV_WILLNEED );
+    close( fd );
+#else
+    // no hint to give, read it through
+    auto *pFile = fopen( pathFName.c_str(), "rb" );
+    if NOT( pFile )
+        return;
+
+    DVec<U8> buff( 1024 * 1024 );
+    while ( fread( buff.data(), 1, buff.size(), pFile ) == buff.size() )
+        ;
+
+    fclose( pFile );
+#endif
+}
+
+//==================================================================
+FilePrefetcher::FilePrefetcher( const FilePrefetcherParams &par )
+    : mPar(par)
+{
+    c_auto threadsN = std::max( (size_t)1, mPar.fpp_threadsN );
+    for (size_t i=0; i < threadsN; ++i)
+        mThreads.emplace_back( [this](){ workerLoop(); } );
+}
+
+//==================================================================
+FilePrefetcher::~FilePrefetcher()
+{
+    {
+        std::lock_guard lock( mMutex );
+        mIsQuitting = true;
+    }
+    mWorkCV.notify_all();
+    mDoneCV.notify_all();
+
+    for (auto &t : mThreads)
+        t.join();
+}
+
+//==================================================================
+void FilePrefetcher::Prefetch( const DVec<DStr> &pathFNames )
+{
+    addRequests( pathFNames, true );
+}
+
+void FilePrefetcher::Warm( const DVec<DStr> &pathFNames )
+{
+    addRequests( pathFNames, false );
+}
+
+//==================================================================
+void FilePrefetcher::addRequests( const DVec<DStr> &pathFNames, bool keepData )
+{
+    if ( pathFNames.empty() )
+        return;
+
+    {
+        std::lock_guard lock( mMutex );
+
+        c_auto reqGen = ++mReqGen;
+
+        // the newest requests go first, in their order
+        for (size_t i=pathFNames.size(); i > 0; --i)
+        {
+            c_auto &pathFName = pathFNames[i-1];
+
+            auto [it, isNew] = mItems.try_emplace( pathFName );
+            auto &item = it->second;
+
+            // still wanted, not to be evicted in favor of newer requests
+            item.it_reqGen = reqGen;
+
+            if ( !isNew && item.it_state == STATE_FAILED )
+                item.it_state = STATE_QUEUED;
+
+            if ( item.it_state != STATE_QUEUED )
+                continue;
+
+            item.it_keepData = item.it_keepData || keepData;
+
+            if NOT( isNew )
+                std::erase( mQueue, pathFName );
+
+            mQueue.push_front( pathFName );
+        }
+    }
+    mWorkCV.notify_all();
+}
+
+//==================================================================
+bool FilePrefetcher::Take( const DStr &pathFName, uptr<DFileData> &out_oData )
+{
+    std::unique_lock lock( mMutex );
+
+    auto it = mItems.find( pathFName );
+    if ( it == mItems.end() || !it->second.it_keepData )
+    {
+        ++mStats.fps_missedN;
+        return false;
+    }
+
+    // not started, the caller is better off reading it now
+    if ( it->second.it_state == STATE_QUEUED )
+    {
+        eraseItem( pathFName );
+        ++mStats.fps_missedN;
+        return false;
+    }
+
+    if ( it->second.it_state == STATE_READING )
+    {
+        DTR_SCOPE( "prefetch_wait" );
+
+        mDoneCV.wait( lock, [&]()
+        {
+            it = mItems.find( pathFName );
+            return mIsQuitting || it == mItems.end() || it->second.it_state != STATE_READING;
+        });
+    }
+
+    if ( it == mItems.end() || it->second.it_state != STATE_READY )
+    {
+        if ( it != mItems.end() )
+            eraseItem( pathFName );
+
+        ++mStats.fps_missedN;
+        return false;
+    }
+
+    auto item = std::move( it->second );
+    mCacheBytes -= item.it_oData->size();
+    mItems.erase( it );
+    lock.unlock();
+
+    // there's room for more
+    mWorkCV.notify_all();
+
+    // rewritten after the read, as a render in progress would
+    int64_t curTime {};
+    size_t  curSize {};
+    if ( !fprGetFileStamp( pathFName, curTime, curSize ) ||
+         curTime != item.it_fileTime ||
+         curSize != item.it_fileSize )
+    {
+        lock.lock();
+        ++mStats.fps_missedN;
+        return false;
+    }
+
+    out_oData = std::move( item.it_oData );
+
+    lock.lock();
+    ++mStats.fps_takenN;
+    return true;
+}
+
+//==================================================================
+void FilePrefetcher::Clear()
+{
+    {
+        std::lock_guard lock( mMutex );
+
+        // what's being read is dropped when it's done, its room with it
+        mQueue.clear();
+        mItems.clear();
+        mCacheBytes = 0;
+    }
+    mWorkCV.notify_all();
+    mDoneCV.notify_all();
+}
+
+//==================================================================
+FilePrefetcher::Stats FilePrefetcher::GetStats()
+{
+    std::lock_guard lock( mMutex );
+
+    auto stats = mStats;
+    stats.fps_cacheBytes = mCacheBytes;
+    return stats;
+}
+
+//==================================================================
+void FilePrefetcher::eraseItem( const DStr &pathFName )
+{
+    auto it = mItems.find( pathFName );
+    if ( it == mItems.end() )
+        return;
+
+    if ( it->second.it_oData )
+        mCacheBytes -= it->second.it_oData->size();
+
+    mItems.erase( it );
+}
+
+//==================================================================
+// reserves the bytes in the cache, dropping the data of older requests
+//  if needed. False if it will never fit, or if quitting
+bool FilePrefetcher::makeRoom(
+                size_t needBytes,
+                uint64_t reqGen,
+                std::unique_lock<std::mutex> &lock )
+{
+    if ( needBytes > mPar.fpp_maxCacheBytes )
+        return false;
+
+    for (;;)
+    {
+        if ( mIsQuitting )
+            return false;
+
+        if ( mCacheBytes + mReservedBytes + needBytes <= mPar.fpp_maxCacheBytes )
+        {
+            mReservedBytes += needBytes;
+            return true;
+        }
+
+        // the oldest request that is ready and not taken yet
+        const DStr *pOldest {};
+        uint64_t oldestGen = reqGen;
+        for (c_auto &[pathFName, item] : mItems)
+        {
+            if ( item.it_state == STATE_READY && item.it_reqGen < oldestGen )
+            {
+                oldestGen = item.it_reqGen;
+                pOldest = &pathFName;
+            }
+        }
+
+        if ( pOldest )
+        {
+            eraseItem( DStr( *pOldest ) );
+            ++mStats.fps_droppedN;
+            continue;
+        }
+
+        // all is wanted as much, wait for some to be taken
+        mWorkCV.wait( lock );
+    }
+}
+
+//==================================================================
+void FilePrefetcher::workerLoop()
+{
+    std::unique_lock lock( mMutex );
+
+    for (;;)
+    {
+        mWorkCV.wait( lock, [this](){ return mIsQuitting || !mQueue.empty(); } );
+        if ( mIsQuitting )
+            return;
+
+        c_auto pathFName = mQueue.front();
+        mQueue.pop_front();
+
+        auto it = mItems.find( pathFName );
+        if ( it == mItems.end() || it->second.it_state != STATE_QUEUED )
+            continue;
+
+        // hints are given and forgotten
+        if NOT( it->second.it_keepData )
+        {
+            mItems.erase( it );
+            lock.unlock();
+            fprWarmFile( pathFName );
+            lock.lock();
+            continue;
+        }
+
+        c_auto reqGen = it->second.it_reqGen;
+        lock.unlock();
+
+        int64_t fileTime {};
+        size_t  fileSize {};
+        c_auto hasStamp = fprGetFileStamp( pathFName, fileTime, fileSize );
+
+        lock.lock();
+
+        // too big to keep, or gone, in the page cache at least
+        if ( !hasStamp || !makeRoom( fileSize, reqGen, lock ) )
+        {
+            if ( mIsQuitting )
+                return;
+
+            eraseItem( pathFName );
+            mDoneCV.notify_all();
+
+            lock.unlock();
+            if ( hasStamp )
+                fprWarmFile( pathFName );
+            lock.lock();
+            continue;
+        }
+
+        // taken or cleared while waiting for room
+        it = mItems.find( pathFName );
+        if ( it == mItems.end() || it->second.it_state != STATE_QUEUED )
+        {
+            mReservedBytes -= fileSize;
+            mWorkCV.notify_all();
+            continue;
+        }
+
+        it->second.it_state = STATE_READING;
+        lock.unlock();
+
+        auto oData = std::make_unique<DFileData>();
+        bool ok {};
+        {
+            DTR_SCOPE( "prefetch_read" );
+            ok = DUT::GrabFile( pathFName.c_str(), *oData ) &&
+                 oData->size() == fileSize;
+        }
+
+        lock.lock();
+
+        // the reservation becomes the data, or goes
+        mReservedBytes -= fileSize;
+
+        it = mItems.find( pathFName );
+        if ( it != mItems.end() && it->second.it_state == STATE_READING )
+        {
+            if ( ok )
+            {
+                mCacheBytes += fileSize;
+                mStats.fps_readBytes += fileSize;
+
+                it->second.it_state     = STATE_READY;
+                it->second.it_oData     = std::move( oData );
+                it->second.it_fileTime  = fileTime;
+                it->second.it_fileSize  = fileSize;
+            }
+            else
+            {
+                LogOut( LOG_WRN, "Prefetch failed for %s", pathFName.c_str() );
+                it->second.it_state = STATE_FAILED;
+            }
+        }
+
+        mDoneCV.notify_all();
+    }
+}
+
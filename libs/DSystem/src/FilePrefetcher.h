@@ -0,0 +1,111 @@
+//==================================================================
+/// FilePrefetcher.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef FILEPREFETCHER_H
+#define FILEPREFETCHER_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <deque>
+#include "DBase.h"
+#include "DContainers.h"
+#include "DUT_Files.h"
+
+//==================================================================
+struct FilePrefetcherParams
+{
+    size_t  fpp_threadsN        { 4 };                  // reads in flight
+    size_t  fpp_maxCacheBytes   { 512 * 1024 * 1024 };  // of the data not taken yet
+};
+
+//==================================================================
+// Reads files ahead of the decoders, on worker threads, so that many
+//  requests are in flight at once. This is what matters on network
+//  storage, where the latency of each file dominates.
+// Prefetch() keeps the data in a bounded cache for Take(). Warm() is
+//  for readers that open the file themselves: it only asks the system
+//  to bring it into its page cache.
+// The latest requests go first. When the cache is full, data of older
+//  requests is dropped to make room, otherwise the reads wait for
+//  Take() to free some.
+//==================================================================
+class FilePrefetcher
+{
+public:
+    struct Stats
+    {
+        size_t  fps_takenN {};      // served from the cache
+        size_t  fps_missedN {};     // not prefetched, failed or stale
+        size_t  fps_droppedN {};    // evicted before being taken
+        size_t  fps_readBytes {};
+        size_t  fps_cacheBytes {};
+    };
+
+private:
+    enum : u_int
+    {
+        STATE_QUEUED,
+        STATE_READING,
+        STATE_READY,
+        STATE_FAILED,
+    };
+
+    struct Item
+    {
+        u_int               it_state    { STATE_QUEUED };
+        bool                it_keepData {};
+        uint64_t            it_reqGen   {};     // of the request that wants it
+        uptr<DFileData>     it_oData;
+        int64_t             it_fileTime {};     // to tell if it changed since
+        size_t              it_fileSize {};
+    };
+
+    FilePrefetcherParams                mPar;
+    DVec<std::thread>                   mThreads;
+
+    std::mutex                          mMutex;
+    std::condition_variable             mWorkCV;    // for the workers
+    std::condition_variable             mDoneCV;    // for Take()
+    std::unordered_map<DStr,Item>       mItems;
+    std::deque<DStr>                    mQueue;     // next first
+    uint64_t                            mReqGen {};
+    size_t                              mCacheBytes {};     // of the data ready
+    size_t                              mReservedBytes {};  // of the reads in flight
+    Stats                               mStats;
+    bool                                mIsQuitting {};
+
+public:
+    FilePrefetcher( const FilePrefetcherParams &par={} );
+    ~FilePrefetcher();
+
+    // read ahead into the cache, in order of need
+    void Prefetch( const DVec<DStr> &pathFNames );
+    // into the page cache of the system only
+    void Warm( const DVec<DStr> &pathFNames );
+
+    // the data of a prefetched file, waiting for it if it's still being
+    //  read. False if it wasn't prefetched, it failed or it changed
+    //  since, then it's up to the caller to read it
+    bool Take( const DStr &pathFName, uptr<DFileData> &out_oData );
+
+    // forget what's queued and drop the cache
+    void Clear();
+
+    Stats GetStats();
+
+private:
+    void addRequests( const DVec<DStr> &pathFNames, bool keepData );
+    void workerLoop();
+    bool makeRoom( size_t needBytes, uint64_t reqGen, std::unique_lock<std::mutex> &lock );
+    void eraseItem( const DStr &pathFName );
+};
+
+#endif
+
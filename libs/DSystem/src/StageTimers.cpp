@@ -0,0 +1,125 @@
+//==================================================================
+/// StageTimers.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <cstring>
+#include "DLogOut.h"
+#include "SerializeJS.h"
+#include "StageTimers.h"
+
+//==================================================================
+void StageTimers::StageInfo::Serialize( SerialJS &v_ ) const
+{
+    v_.MSerializeObjectStart();
+    SERIALIZE_THIS_MEMBER( v_, si_name      );
+    SERIALIZE_THIS_MEMBER( v_, si_lastMS    );
+    SERIALIZE_THIS_MEMBER( v_, si_avgMS     );
+    SERIALIZE_THIS_MEMBER( v_, si_maxMS     );
+    SERIALIZE_THIS_MEMBER( v_, si_totMS     );
+    SERIALIZE_THIS_MEMBER( v_, si_callsN    );
+    SERIALIZE_THIS_MEMBER( v_, si_histMS    );
+    v_.MSerializeObjectEnd();
+}
+
+//==================================================================
+StageTimers &StageTimers::Get()
+{
+    static StageTimers sInstance;
+    return sInstance;
+}
+
+//==================================================================
+size_t StageTimers::FindOrAddStage( const char *pName )
+{
+    std::lock_guard lock( mMutex );
+
+    c_auto n = mStagesN.load();
+    for (size_t i=0; i < n; ++i)
+        if NOT( strcmp( mStages[i].st_pName, pName ) )
+            return i;
+
+    // out of slots, share the last one
+    if ( n == MAX_STAGES_N )
+    {
+        LogOut( LOG_WRN, "Too many stage timers, %s shares with %s",
+                    pName, mStages[n-1].st_pName );
+        return n-1;
+    }
+
+    mStages[n].st_pName = pName;
+    mStagesN = n + 1;
+
+    return n;
+}
+
+//==================================================================
+void StageTimers::EndFrame()
+{
+    std::lock_guard lock( mMutex );
+
+    c_auto n = mStagesN.load();
+    for (size_t i=0; i < n; ++i)
+    {
+        auto &st = mStages[i];
+        st.st_histMS[ mHistPos ] = (float)(st.st_frameUS.exchange( 0 ) / 1000.0);
+    }
+
+    mHistPos = (mHistPos + 1) % HISTORY_N;
+    mHistN = std::min( mHistN + 1, HISTORY_N );
+}
+
+//==================================================================
+void StageTimers::GetStageInfos( DVec<StageInfo> &out_infos ) const
+{
+    std::lock_guard lock( mMutex );
+
+    c_auto n = mStagesN.load();
+
+    out_infos.resize( n );
+
+    for (size_t i=0; i < n; ++i)
+    {
+        c_auto &st = mStages[i];
+        auto &si = out_infos[i];
+
+        si.si_name      = st.st_pName;
+        si.si_totMS     = st.st_totUS.load() / 1000.0;
+        si.si_callsN    = st.st_callsN.load();
+
+        // unroll the ring, oldest first
+        si.si_histMS.resize( mHistN );
+        for (size_t j=0; j < mHistN; ++j)
+            si.si_histMS[j] = st.st_histMS[ (mHistPos + HISTORY_N - mHistN + j) % HISTORY_N ];
+
+        si.si_lastMS = mHistN ? si.si_histMS.back() : 0.0;
+
+        double sum = 0;
+        si.si_maxMS = 0;
+        for (c_auto ms : si.si_histMS)
+        {
+            sum += ms;
+            si.si_maxMS = std::max( si.si_maxMS, (double)ms );
+        }
+        si.si_avgMS = mHistN ? sum / (double)mHistN : 0.0;
+    }
+}
+
+//==================================================================
+void StageTimers::SaveJSON( const DStr &pathFName ) const
+{
+    DVec<StageInfo> infos;
+    GetStageInfos( infos );
+
+    try {
+        SerializeToFile( pathFName, infos );
+    }
+    catch (...)
+    {
+        LogOut( LOG_ERR, "Failed to save %s", pathFName.c_str() );
+    }
+}
+
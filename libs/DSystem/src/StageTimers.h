@@ -0,0 +1,116 @@
+//==================================================================
+/// StageTimers.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef STAGETIMERS_H
+#define STAGETIMERS_H
+
+#include <atomic>
+#include <mutex>
+#include "DBase.h"
+#include "DContainers.h"
+#include "TimeUtils.h"
+#include "DTrace.h"
+
+class SerialJS;
+
+//==================================================================
+// Time spent in named stages of the processing, from any thread.
+// Scopes add to the current frame, EndFrame() moves the frame's
+//  times into a rolling history. Times of parallel workers add up.
+//==================================================================
+class StageTimers
+{
+public:
+    static constexpr size_t MAX_STAGES_N    = 64;
+    static constexpr size_t HISTORY_N       = 240;
+
+    struct StageInfo
+    {
+        DStr        si_name;
+        double      si_lastMS {};   // in the last frame
+        double      si_avgMS {};    // per frame, over the history
+        double      si_maxMS {};    // per frame, over the history
+        double      si_totMS {};    // since the start
+        uint64_t    si_callsN {};   // since the start
+        DVec<float> si_histMS;      // per frame, oldest first
+
+        void Serialize( SerialJS &v_ ) const;
+        friend void Serialize( SerialJS &v_, const StageInfo &o_ ){ o_.Serialize(v_); }
+    };
+
+private:
+    struct Stage
+    {
+        const char              *st_pName {};
+        std::atomic<int64_t>    st_frameUS {};
+        std::atomic<int64_t>    st_totUS {};
+        std::atomic<uint64_t>   st_callsN {};
+        float                   st_histMS[HISTORY_N] {};
+    };
+
+    Stage               mStages[MAX_STAGES_N];
+    std::atomic<size_t> mStagesN {};
+    size_t              mHistPos {};    // next slot in st_histMS
+    size_t              mHistN {};      // valid slots in st_histMS
+    mutable std::mutex  mMutex;         // for adding stages and the history
+
+public:
+    static StageTimers &Get();
+
+    // index of a stage, added the first time. The name must be a literal
+    size_t FindOrAddStage( const char *pName );
+
+    void AddStageTime( size_t idx, TimeUS t )
+    {
+        auto &st = mStages[ idx ];
+        st.st_frameUS.fetch_add( t.CalcTimeUS(), std::memory_order_relaxed );
+        st.st_totUS.fetch_add( t.CalcTimeUS(), std::memory_order_relaxed );
+        st.st_callsN.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    // call once per frame, from the main thread
+    void EndFrame();
+
+    void GetStageInfos( DVec<StageInfo> &out_infos ) const;
+
+    void SaveJSON( const DStr &pathFName ) const;
+};
+
+//==================================================================
+// also a slice in the trace, when tracing
+class StageTimerScope
+{
+    size_t      mIdx;
+    TimeUS      mStartUS;
+    DTR_Scope   mTrace;
+
+public:
+    StageTimerScope( size_t idx, const char *pName )
+        : mIdx(idx)
+        , mStartUS(GetSteadyTimeUS())
+        , mTrace(pName)
+    {
+    }
+
+    ~StageTimerScope()
+    {
+        StageTimers::Get().AddStageTime( mIdx, GetSteadyTimeUS() - mStartUS );
+    }
+};
+
+#define STAGE_TIMER_CAT2(_A_,_B_)   _A_##_B_
+#define STAGE_TIMER_CAT(_A_,_B_)    STAGE_TIMER_CAT2(_A_,_B_)
+
+// time the rest of the scope as the stage _NAME_
+#define STAGE_TIMER( _NAME_ ) \
+    static const size_t STAGE_TIMER_CAT(_stIdx,__LINE__) = \
+                            StageTimers::Get().FindOrAddStage( _NAME_ ); \
+    StageTimerScope STAGE_TIMER_CAT(_stScope,__LINE__)( STAGE_TIMER_CAT(_stIdx,__LINE__), _NAME_ )
+
+#endif
+
@@ -10,6 +10,7 @@
 # include "GL/glew.h"
 # include "DGLUtils.h"
 #endif
+#include "StageTimers.h"
 #include "GShaderProg.h"
 #include "Graphics.h"
 
@@ -178,11 +179,10 @@ static void checkGLErr( const char *pFile, int line )
 #endif
 
 //==================================================================
-void Graphics::UploadImageTexture( image &img )
+// make sure that the image has a texture object, then bind it
+void Graphics::BindImageTexture( image &img )
 {
 #ifdef ENABLE_OPENGL
-    CHECKGLERR;
-
 #if defined(USE_SOFT_MIPMAPS) || defined(USE_HARD_MIPMAPS)
     c_auto usingMips = !!(img.mFlags & image::FLG_USE_MIPMAPS);
 #else
@@ -190,32 +190,50 @@ void Graphics::UploadImageTexture( image &img )
 #endif
 
     if NOT( img.IsTextureIDValid() )
-    {
         glGenTextures( 1, &img.mImageTexID0 );
-        glBindTexture( GL_TEXTURE_2D, img.mImageTexID0 );
 
-        auto setParamI = [&]( auto a, auto b )
-        {
-            glTexParameteri( GL_TEXTURE_2D, a, b );
-        };
+    glBindTexture( GL_TEXTURE_2D, img.mImageTexID0 );
 
-        c_auto usingLinear = !!(img.mFlags & image::FLG_USE_BILINEAR);
+    // always set, the texture may have been handed over by another image
+    auto setParamI = [&]( auto a, auto b )
+    {
+        glTexParameteri( GL_TEXTURE_2D, a, b );
+    };
 
-        setParamI( GL_TEXTURE_MAG_FILTER,
-                    usingLinear
-                        ? GL_LINEAR
-                        : GL_NEAREST );
+    c_auto usingLinear = !!(img.mFlags & image::FLG_USE_BILINEAR);
 
-        setParamI( GL_TEXTURE_MIN_FILTER,
-                    usingLinear
-                        ? (usingMips ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST)
-                        : (usingMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR) );
+    setParamI( GL_TEXTURE_MAG_FILTER,
+                usingLinear
+                    ? GL_LINEAR
+                    : GL_NEAREST );
 
-        setParamI( GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-        setParamI( GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    setParamI( GL_TEXTURE_MIN_FILTER,
+                usingLinear
+                    ? (usingMips ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST)
+                    : (usingMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR) );
 
-        CHECKGLERR;
-    }
+    setParamI( GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    setParamI( GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+    CHECKGLERR;
+#endif
+}
+
+//==================================================================
+void Graphics::UploadImageTexture( image &img )
+{
+#ifdef ENABLE_OPENGL
+    STAGE_TIMER( "tex_upload" );
+
+    CHECKGLERR;
+
+#if defined(USE_SOFT_MIPMAPS) || defined(USE_HARD_MIPMAPS)
+    c_auto usingMips = !!(img.mFlags & image::FLG_USE_MIPMAPS);
+#else
+    c_auto usingMips = false;
+#endif
+
+    BindImageTexture( img );
 
     u_int fmt = GL_RGBA;
 
@@ -229,20 +247,50 @@ void Graphics::UploadImageTexture( image &img )
         DASSERT( 0 );
     }
 
-    glBindTexture( GL_TEXTURE_2D, img.mImageTexID0 );
+    c_auto type = (u_int)(img.IsFloat32() ? GL_FLOAT : GL_UNSIGNED_BYTE);
 
-    glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            fmt, //GL_RGBA8,
-            img.mW,
-            img.mH,
-            0,
-            fmt,
-            img.IsFloat32() ? GL_FLOAT : GL_UNSIGNED_BYTE,
-            img.GetPixelPtr(0,0) );
+    // same storage as the last upload ? Then just update the texels
+    c_auto doSubUpdate =
+                img.mImageTexW0    == img.mW &&
+                img.mImageTexH0    == img.mH &&
+                img.mImageTexFmt0  == fmt &&
+                img.mImageTexType0 == type;
 
-    CHECKGLERR;
+    auto texImage = [&]( int level, const image &src )
+    {
+        if ( doSubUpdate )
+        {
+            glTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    level,
+                    0,
+                    0,
+                    src.mW,
+                    src.mH,
+                    fmt,
+                    type,
+                    src.GetPixelPtr(0,0) );
+        }
+        else
+        {
+            glTexImage2D(
+                    GL_TEXTURE_2D,
+                    level,
+                    fmt, //GL_RGBA8,
+                    src.mW,
+                    src.mH,
+                    0,
+                    fmt,
+                    type,
+                    src.GetPixelPtr(0,0) );
+        }
+
+        CHECKGLERR;
+    };
+
+    glBindTexture( GL_TEXTURE_2D, img.mImageTexID0 );
+
+    texImage( 0, img );
 
 #ifdef USE_SOFT_MIPMAPS
     if ( usingMips )
@@ -253,18 +301,7 @@ void Graphics::UploadImageTexture( image &img )
         {
             tmp.ScaleQuarter();
 
-            glTexImage2D(
-                    GL_TEXTURE_2D,
-                    level++,
-                    fmt, //GL_RGBA8,
-                    tmp.mW,
-                    tmp.mH,
-                    0,
-                    fmt,
-                    img.IsFloat32() ? GL_FLOAT : GL_UNSIGNED_BYTE,
-                    tmp.GetPixelPtr(0,0) );
-
-            CHECKGLERR;
+            texImage( level++, tmp );
         }
 
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0 );
@@ -281,6 +318,60 @@ void Graphics::UploadImageTexture( image &img )
 #endif
 
     glBindTexture( GL_TEXTURE_2D, 0 );
+
+    img.mImageTexW0    = img.mW;
+    img.mImageTexH0    = img.mH;
+    img.mImageTexFmt0  = fmt;
+    img.mImageTexType0 = type;
+#endif
+}
+
+//==================================================================
+// hand over the texture object, so that a reallocated image can
+//  reuse it instead of generating a new one
+void Graphics::TransferImageTexture( image &des, image &src )
+{
+    DASSERT( !des.IsTextureIDValid() );
+
+    des.mImageTexID0   = src.mImageTexID0;
+    des.mImageTexW0    = src.mImageTexW0;
+    des.mImageTexH0    = src.mImageTexH0;
+    des.mImageTexFmt0  = src.mImageTexFmt0;
+    des.mImageTexType0 = src.mImageTexType0;
+
+    src.mImageTexID0   = (u_int)-1;
+    src.mImageTexW0    = 0;
+    src.mImageTexH0    = 0;
+    src.mImageTexFmt0  = 0;
+    src.mImageTexType0 = 0;
+}
+
+//==================================================================
+void Graphics::FreeImageTexture( image &img )
+{
+#ifdef ENABLE_OPENGL
+    if ( img.IsTextureIDValid() )
+        glDeleteTextures( 1, &img.mImageTexID0 );
+#endif
+
+    img.mImageTexID0   = (u_int)-1;
+    img.mImageTexW0    = 0;
+    img.mImageTexH0    = 0;
+    img.mImageTexFmt0  = 0;
+    img.mImageTexType0 = 0;
+}
+
+//==================================================================
+u_int Graphics::GetMaxTextureSize()
+{
+#ifdef ENABLE_OPENGL
+    static GLint sMaxSize;
+    if NOT( sMaxSize )
+        glGetIntegerv( GL_MAX_TEXTURE_SIZE, &sMaxSize );
+
+    return (u_int)sMaxSize;
+#else
+    return 0;
 #endif
 }
 
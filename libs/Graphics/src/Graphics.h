@@ -123,7 +123,12 @@ public:
     void SetBlendAdd();
     void SetBlendAlpha();
 
+    static void BindImageTexture( image &img );
     static void UploadImageTexture( image &img );
+    static void TransferImageTexture( image &des, image &src );
+    static void FreeImageTexture( image &img );
+
+    static u_int GetMaxTextureSize();
 
     void SetTextureFromImage( const image &img );
     void SetTexture( u_int texID );
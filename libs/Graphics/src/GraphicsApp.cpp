@@ -518,6 +518,41 @@ GraphicsApp::~GraphicsApp()
         mainWindowDestroy();
 }
 
+//==================================================================
+void GraphicsApp::PostWakeUp()
+{
+    msHasWakeUpReq = true;
+#ifdef ENABLE_OPENGL
+    glfwPostEmptyEvent();
+#endif
+}
+
+//==================================================================
+void GraphicsApp::waitEvents()
+{
+#ifdef ENABLE_OPENGL
+    // still painting, or not event-driven
+    if ( mRedrawFramesN || mPar.mEventWaitTimeoutS <= 0 )
+    {
+        glfwPollEvents();
+    }
+    else
+    {
+        c_auto startS = GetSteadyTimeS();
+
+        glfwWaitEventsTimeout( mPar.mEventWaitTimeoutS );
+
+        // woken up early: some event, possibly one that we don't hook
+        //  (e.g. from secondary viewports)
+        if ( (GetSteadyTimeS() - startS) < mPar.mEventWaitTimeoutS )
+            requestRedraw();
+    }
+
+    if ( msHasWakeUpReq.exchange( false ) )
+        requestRedraw();
+#endif
+}
+
 //==================================================================
 bool GraphicsApp::mainLoop()
 {
@@ -526,6 +561,12 @@ bool GraphicsApp::mainLoop()
         mShouldQuit = true;
 #endif
 
+#ifdef ENABLE_OPENGL
+    // before animating, so that what woke us up gets handled right away
+    if NOT( mPar.mIsNoUIMode )
+        waitEvents();
+#endif
+
     if ( mPar.mOnAnimateFn )
     {
         if NOT( mPar.mOnAnimateFn() )
@@ -536,8 +577,6 @@ bool GraphicsApp::mainLoop()
     if ( mPar.mIsNoUIMode )
         return true;
 
-    glfwPollEvents();
-
     c_auto isWinVisible = glfwGetWindowAttrib( mpWin, GLFW_VISIBLE );
     if NOT( isWinVisible )
         return true;
@@ -551,11 +590,19 @@ bool GraphicsApp::mainLoop()
 
     c_auto isFirstPaint = !mLastPaintTimeUS;
 
-    if ( !mIsWindowIconified &&
+    // event-driven: only when something happened, or once in a while
+    c_auto isIdle = mPar.mEventWaitTimeoutS > 0 &&
+                    !mRedrawFramesN &&
+                    (curTimeUS - mLastPaintTimeUS) <= useNonInteractIntervalUS;
+
+    if ( !mIsWindowIconified && !isIdle &&
          (!isLFState || (curTimeUS - mLastPaintTimeUS) > useNonInteractIntervalUS) )
     {
         mLastPaintTimeUS = curTimeUS;
 
+        if ( mRedrawFramesN )
+            --mRedrawFramesN;
+
         if ( mHasPendingWindowPos )
         {
             mHasPendingWindowPos = false;
@@ -1296,6 +1343,7 @@ void GraphicsApp::mainWindowInit()
         thiss->localLog( LOG_DBG, SSPrintFS( "Event, win maximize %i", maximized ) );
 #endif
         thiss->mIsWindowMaximized = (bool)maximized;
+        thiss->requestRedraw();
     });
 
     glfwSetWindowIconifyCallback(mpWin, [](GLFWwindow* w, int iconified)
@@ -1305,6 +1353,7 @@ void GraphicsApp::mainWindowInit()
         thiss->localLog( LOG_DBG, SSPrintFS( "Event, win iconify %i", iconified ) );
 #endif
         thiss->mIsWindowIconified = (bool)iconified;
+        thiss->requestRedraw();
     });
 
     if ( mPar.mOnDropFn )
@@ -1579,6 +1628,7 @@ void GraphicsApp::onInputEvent()
 {
     mLastEventTimeS = GetSteadyTimeS();
     mShouldRedisplayCustomScene = true;
+    requestRedraw();
 }
 
 //========================================================================
@@ -1721,6 +1771,8 @@ void GraphicsApp::framebuffer_sizeCB( int width, int height )
         mPendingWindowSiz = {width, height};
         mHasPendingWindowSiz = true;
     }
+
+    requestRedraw();
 }
 
 #endif // ENABLE_IMGUI
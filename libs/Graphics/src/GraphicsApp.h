@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <functional>
+#include <atomic>
 #include "FontFix.h"
 #include "Graphics.h"
 #include "TimeUtils.h"
@@ -67,6 +68,9 @@ struct GraphicsAppParams
     double      mExtraContentScale = 1.0;
 
     TimeUS      mNonInteracIntervalUS;
+    // if > 0, sleep until there are events (up to this long) and paint
+    //  only then, instead of polling and painting continuously
+    double      mEventWaitTimeoutS {};
 
     DVec<DStr>  mAppIconFNames;
 
@@ -162,6 +166,7 @@ class GraphicsApp
     bool        mIsWindowIconified = false;
 
     bool        mShouldRedisplayCustomScene = true;
+    int         mRedrawFramesN = 0; // frames to paint before going idle
     bool        mShouldQuit = false;
     double      mLastEventTimeS = 0;
 
@@ -187,6 +192,8 @@ class GraphicsApp
 
     DVec<Int4>  mMonitorsWorkArea;
 
+    inline static std::atomic<bool> msHasWakeUpReq;
+
 private:
     DVec<GraphicsAppWindowState>  mWinStates;
 
@@ -196,7 +203,10 @@ public:
     GraphicsApp( const GraphicsAppParams &par );
     ~GraphicsApp();
 
-    void PostCustomRedisplay() { mShouldRedisplayCustomScene = true; }
+    void PostCustomRedisplay() { mShouldRedisplayCustomScene = true; requestRedraw(); }
+
+    // wake up the main loop and paint. Can be called from any thread
+    static void PostWakeUp();
 
     void ChangeColorScheme( DStr scheme, bool forceSet=false );
 
@@ -236,6 +246,9 @@ private:
     }
 
     bool mainLoop();
+    void waitEvents();
+    // a few frames, ImGui may need them to settle
+    void requestRedraw() { mRedrawFramesN = 3; }
     void mainWindowInit();
     void mainWindowDestroy();
 
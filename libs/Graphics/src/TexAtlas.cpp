@@ -0,0 +1,219 @@
+//==================================================================
+/// TexAtlas.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifdef ENABLE_OPENGL
+# include "GL/glew.h"
+#endif
+#include "StageTimers.h"
+#include "ImageConv.h"
+#include "Graphics.h"
+#include "TexAtlas.h"
+
+//==================================================================
+TexAtlas::TexAtlas( u_int slotW, u_int slotH, u_int slotsN, u_int maxUploadsPerFrame )
+    : mSlotW(slotW)
+    , mSlotH(slotH)
+    , mMaxUploadsN(maxUploadsPerFrame)
+{
+    // about square, within the texture size limit
+    mColsN = 1;
+    while ( mColsN * mColsN < slotsN )
+        ++mColsN;
+
+    mColsN = std::min( mColsN, std::max( 1u, Graphics::GetMaxTextureSize() / slotW ) );
+
+    c_auto rowsN = std::min( (slotsN + mColsN - 1) / mColsN,
+                             std::max( 1u, Graphics::GetMaxTextureSize() / slotH ) );
+
+    mSlots.resize( (size_t)mColsN * rowsN );
+
+    image::Params par;
+    par.width   = mColsN * slotW;
+    par.height  = rowsN * slotH;
+    par.chans   = 4;
+    par.depth   = 4 * 8;
+    par.flags   = image::FLG_USE_BILINEAR;
+    moAtlas = std::make_unique<image>( par );
+
+    memset( moAtlas->GetPixelPtr( 0, 0 ), 0, (size_t)moAtlas->mBytesPerRow * moAtlas->mH );
+}
+
+//==================================================================
+TexAtlas::~TexAtlas()
+{
+    if ( moAtlas->IsTextureIDValid() )
+        Graphics::FreeImageTexture( *moAtlas );
+}
+
+//==================================================================
+void TexAtlas::Clear()
+{
+    for (auto &e : mSlots)
+        e = {};
+
+    mSlotByKey.clear();
+}
+
+//==================================================================
+bool TexAtlas::GetSlot(
+            uint64_t key,
+            const image &img,
+            uint64_t gen,
+            Slot &out_slot,
+            bool *pOut_isDeferred )
+{
+    c_auto canUpload = mUploadsN < mMaxUploadsN;
+
+    if ( pOut_isDeferred )
+        *pOut_isDeferred = false;
+
+    if (auto it = mSlotByKey.find( key ); it != mSlotByKey.end())
+    {
+        c_auto idx = it->second;
+        auto &e = mSlots[ idx ];
+        e.en_lastUseFrame = mFrame;
+
+        if ( e.en_gen != gen )
+        {
+            if ( canUpload )
+            {
+                uploadSlot( idx, img );
+                e.en_gen = gen;
+            }
+            else
+            if ( pOut_isDeferred )
+                *pOut_isDeferred = true;
+        }
+
+        makeSlot( idx, out_slot );
+        return true;
+    }
+
+    if NOT( canUpload )
+    {
+        if ( pOut_isDeferred )
+            *pOut_isDeferred = true;
+        return false;
+    }
+
+    u_int idx {};
+    if NOT( findFreeSlot( idx ) )
+        return false;
+
+    auto &e = mSlots[ idx ];
+    if ( e.en_isUsed )
+        mSlotByKey.erase( e.en_key );
+
+    e.en_key            = key;
+    e.en_gen            = gen;
+    e.en_lastUseFrame   = mFrame;
+    e.en_isUsed         = true;
+    mSlotByKey[ key ]   = idx;
+
+    uploadSlot( idx, img );
+
+    makeSlot( idx, out_slot );
+    return true;
+}
+
+//==================================================================
+// an unused one, or the least recently used, but not in this frame
+bool TexAtlas::findFreeSlot( u_int &out_idx )
+{
+    auto bestIdx = (u_int)-1;
+    for (u_int i=0; i < (u_int)mSlots.size(); ++i)
+    {
+        c_auto &e = mSlots[i];
+        if NOT( e.en_isUsed )
+        {
+            out_idx = i;
+            return true;
+        }
+
+        if ( e.en_lastUseFrame != mFrame &&
+                (bestIdx == (u_int)-1 ||
+                 e.en_lastUseFrame < mSlots[ bestIdx ].en_lastUseFrame) )
+            bestIdx = i;
+    }
+
+    if ( bestIdx == (u_int)-1 )
+        return false;
+
+    out_idx = bestIdx;
+    return true;
+}
+
+//==================================================================
+void TexAtlas::uploadSlot( u_int idx, const image &img )
+{
+    STAGE_TIMER( "atlas_upload" );
+
+    ++mUploadsN;
+
+    auto &e = mSlots[ idx ];
+    e.en_w = std::min( img.mW, mSlotW );
+    e.en_h = std::min( img.mH, mSlotH );
+
+    c_auto x = (idx % mColsN) * mSlotW;
+    c_auto y = (idx / mColsN) * mSlotH;
+
+    // into the texels, as RGBA
+    ImageConv::ConvertFormat( img, 0, 0, *moAtlas, (int)x, (int)y, (int)e.en_w, (int)e.en_h );
+
+#ifdef ENABLE_OPENGL
+    // the whole texture the first time, then only the slot
+    if NOT( moAtlas->IsTextureIDValid() )
+    {
+        Graphics::UploadImageTexture( *moAtlas );
+        return;
+    }
+
+    Graphics::BindImageTexture( *moAtlas );
+
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+    glPixelStorei( GL_UNPACK_ROW_LENGTH, (GLint)(moAtlas->mBytesPerRow / 4) );
+
+    glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            (GLint)x,
+            (GLint)y,
+            (GLsizei)e.en_w,
+            (GLsizei)e.en_h,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            moAtlas->GetPixelPtr( x, y ) );
+
+    glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+#endif
+}
+
+//==================================================================
+void TexAtlas::makeSlot( u_int idx, Slot &out_slot ) const
+{
+    c_auto &e = mSlots[ idx ];
+
+    c_auto x = (float)((idx % mColsN) * mSlotW);
+    c_auto y = (float)((idx / mColsN) * mSlotH);
+
+    c_auto oow = 1.f / (float)moAtlas->mW;
+    c_auto ooh = 1.f / (float)moAtlas->mH;
+
+    out_slot.sl_texID   = moAtlas->GetTextureID();
+    out_slot.sl_uv1     = { x * oow, y * ooh };
+    out_slot.sl_uv2     = { (x + (float)e.en_w) * oow, (y + (float)e.en_h) * ooh };
+    out_slot.sl_w       = e.en_w;
+    out_slot.sl_h       = e.en_h;
+}
+
+//==================================================================
+void TexAtlas::EndFrame()
+{
+    mUploadsN = 0;
+    ++mFrame;
+}
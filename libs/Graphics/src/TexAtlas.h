@@ -0,0 +1,84 @@
+//==================================================================
+/// TexAtlas.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef TEXATLAS_H
+#define TEXATLAS_H
+
+#include <unordered_map>
+#include "DBase.h"
+#include "DContainers.h"
+#include "DVector.h"
+#include "Image.h"
+
+//==================================================================
+// Small 8 bit images in the slots of a single texture, such as the
+//  thumbnails of a list. Slots go to the least recently used keys, and
+//  the uploads per frame are limited, so that a list that comes into
+//  view fills in over a few frames, instead of stalling one.
+// Call from the thread of the GL context.
+//==================================================================
+class TexAtlas
+{
+public:
+    struct Slot
+    {
+        u_int   sl_texID {};
+        Float2  sl_uv1 {0,0};       // of the image in the slot
+        Float2  sl_uv2 {0,0};
+        u_int   sl_w {};
+        u_int   sl_h {};
+    };
+
+private:
+    struct Entry
+    {
+        uint64_t    en_key {};
+        uint64_t    en_gen {};
+        u_int       en_lastUseFrame {};
+        u_int       en_w {};
+        u_int       en_h {};
+        bool        en_isUsed {};
+    };
+    DVec<Entry>                         mSlots;
+    std::unordered_map<uint64_t,u_int>  mSlotByKey;
+
+    uptr<image>     moAtlas;        // RGBA, the texels of the texture
+    u_int           mSlotW {};
+    u_int           mSlotH {};
+    u_int           mColsN {};
+    u_int           mMaxUploadsN {};
+    u_int           mUploadsN {};
+    u_int           mFrame {};
+
+public:
+    TexAtlas( u_int slotW, u_int slotH, u_int slotsN, u_int maxUploadsPerFrame );
+    ~TexAtlas();
+
+    // the slot with img, uploaded if the key is new or if gen changed.
+    //  Past the uploads of the frame, a changed image shows as it was,
+    //  and a new one isn't there, pOut_isDeferred tells that it needs
+    //  another frame. Images larger than a slot are cut
+    bool GetSlot(
+            uint64_t key,
+            const image &img,
+            uint64_t gen,
+            Slot &out_slot,
+            bool *pOut_isDeferred=nullptr );
+
+    // call once per frame
+    void EndFrame();
+
+    void Clear();
+
+private:
+    bool findFreeSlot( u_int &out_idx );
+    void uploadSlot( u_int idx, const image &img );
+    void makeSlot( u_int idx, Slot &out_slot ) const;
+};
+
+#endif
@@ -0,0 +1,435 @@
+//==================================================================
+/// TexStreamer.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifdef ENABLE_OPENGL
+# include "GL/glew.h"
+# include "DGLUtils.h"
+#endif
+#include "DThreads.h"
+#include "StageTimers.h"
+#include "ImageConv.h"
+#include "Graphics.h"
+#include "TexStreamer.h"
+
+#ifdef ENABLE_OPENGL
+
+//==================================================================
+static bool tsHasPBO()
+{
+    return GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object;
+}
+
+static bool tsHasHalf()
+{
+    return GLEW_VERSION_3_0 || (GLEW_ARB_texture_float && GLEW_ARB_half_float_pixel);
+}
+
+//==================================================================
+struct TSFmtInfo
+{
+    GLint   intFmt;
+    GLenum  fmt;
+    GLenum  type;
+    u_int   bpp;
+};
+
+static TSFmtInfo tsGetFmtInfo( TexStreamer::Format fmt, u_int chans )
+{
+    c_auto isRGB = (chans == 3);
+
+    switch ( fmt )
+    {
+    case TexStreamer::FMT_HALF:
+        return isRGB
+            ? TSFmtInfo{ GL_RGB16F,  GL_RGB,  GL_HALF_FLOAT, 3 * 2 }
+            : TSFmtInfo{ GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 4 * 2 };
+
+    case TexStreamer::FMT_RGB10A2:
+        return TSFmtInfo{ GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4 };
+
+    default:
+        // same storage as Graphics::UploadImageTexture()
+        return isRGB
+            ? TSFmtInfo{ GL_RGB,  GL_RGB,  GL_FLOAT, 3 * 4 }
+            : TSFmtInfo{ GL_RGBA, GL_RGBA, GL_FLOAT, 4 * 4 };
+    }
+}
+
+#endif
+
+//==================================================================
+static void tsPackRGB10A2( uint32_t *pDes, const float *pSrc, u_int w, u_int chans )
+{
+    // NaN goes to 0
+    auto sat = []( float v ) { return v > 0.f ? (v < 1.f ? v : 1.f) : 0.f; };
+
+    auto q10 = [&]( float v ) { return (uint32_t)(sat( v ) * 1023.f + 0.5f); };
+
+    for (u_int x=0; x < w; ++x, pSrc += chans)
+    {
+        c_auto a = chans == 4 ? (uint32_t)(sat( pSrc[3] ) * 3.f + 0.5f) : 3u;
+
+        pDes[x] = q10( pSrc[0] )       |
+                  q10( pSrc[1] ) << 10 |
+                  q10( pSrc[2] ) << 20 |
+                  a << 30;
+    }
+}
+
+//==================================================================
+static void tsConvertRow(
+        U8 *pDes, TexStreamer::Format fmt, const float *pSrc, u_int w, u_int chans )
+{
+    switch ( fmt )
+    {
+    case TexStreamer::FMT_HALF:
+        ImageConv::ChanRowFromFloat( pDes, ImageConv::CHANTYPE_F16, pSrc, (size_t)w * chans );
+        break;
+
+    case TexStreamer::FMT_RGB10A2:
+        tsPackRGB10A2( (uint32_t *)pDes, pSrc, w, chans );
+        break;
+
+    default:
+        memcpy( pDes, pSrc, (size_t)w * chans * sizeof(float) );
+        break;
+    }
+}
+
+//==================================================================
+static uint64_t tsHashBytes( uint64_t h, const U8 *p, size_t n )
+{
+    constexpr uint64_t PRIME = 0x100000001b3ull;
+
+    size_t i = 0;
+    for (; (i + 8) <= n; i += 8)
+    {
+        uint64_t v;
+        memcpy( &v, p + i, 8 );
+        h = (h ^ v) * PRIME;
+        h ^= h >> 29;
+    }
+
+    for (; i < n; ++i)
+        h = (h ^ p[i]) * PRIME;
+
+    return h;
+}
+
+//==================================================================
+// one hash per TILE_DIM x TILE_DIM tile, row-major
+static void tsHashTiles( DVec<uint64_t> &out_hashes, const image &img )
+{
+    c_auto TD = TexStreamer::TILE_DIM;
+    c_auto tilesW = (img.mW + TD - 1) / TD;
+    c_auto tilesH = (img.mH + TD - 1) / TD;
+
+    out_hashes.resize( (size_t)tilesW * tilesH );
+
+    DT_ParallelFor( tilesH, 1, [&]( size_t begin, size_t end )
+    {
+        for (size_t ty=begin; ty < end; ++ty)
+        {
+            auto *pHashes = out_hashes.data() + ty * tilesW;
+
+            for (u_int tx=0; tx < tilesW; ++tx)
+                pHashes[tx] = 0xcbf29ce484222325ull;
+
+            c_auto y1 = (u_int)ty * TD;
+            c_auto y2 = std::min( y1 + TD, img.mH );
+            for (u_int y=y1; y < y2; ++y)
+            {
+                c_auto *pRow = img.GetPixelPtr( 0, y );
+
+                for (u_int tx=0; tx < tilesW; ++tx)
+                {
+                    c_auto x1 = tx * TD;
+                    c_auto x2 = std::min( x1 + TD, img.mW );
+
+                    pHashes[tx] = tsHashBytes(
+                                    pHashes[tx],
+                                    pRow + (size_t)x1 * img.mBytesPerPixel,
+                                    (size_t)(x2 - x1) * img.mBytesPerPixel );
+                }
+            }
+        }
+    });
+}
+
+//==================================================================
+TexStreamer::TexStreamer()
+{
+}
+
+//==================================================================
+TexStreamer::~TexStreamer()
+{
+#ifdef ENABLE_OPENGL
+    if ( mPBOs[0] )
+        glDeleteBuffers( RING_N, mPBOs );
+#endif
+}
+
+//==================================================================
+TexStreamer::Format TexStreamer::FormatFromName( const DStr &name )
+{
+    if ( name == "half" )    return FMT_HALF;
+    if ( name == "rgb10a2" ) return FMT_RGB10A2;
+
+    return FMT_FLOAT;
+}
+
+//==================================================================
+bool TexStreamer::canStream( const image &img ) const
+{
+    return img.IsFloat32() &&
+           (img.mChans == 3 || img.mChans == 4) &&
+           !(img.mFlags & image::FLG_USE_MIPMAPS);
+}
+
+//==================================================================
+TexStreamer::Format TexStreamer::resolveFormat( Format fmt ) const
+{
+#ifdef ENABLE_OPENGL
+    if ( fmt == FMT_HALF && !tsHasHalf() )
+        return FMT_FLOAT;
+#endif
+    return fmt;
+}
+
+//==================================================================
+// (re)allocate the texture storage if needed. Returns true if it did
+bool TexStreamer::setupStorage( image &img, Format fmt )
+{
+#ifdef ENABLE_OPENGL
+    Graphics::BindImageTexture( img );
+
+    c_auto fi = tsGetFmtInfo( fmt, img.mChans );
+
+    if ( img.mImageTexW0    == img.mW &&
+         img.mImageTexH0    == img.mH &&
+         img.mImageTexFmt0  == (u_int)fi.intFmt &&
+         img.mImageTexType0 == (u_int)fi.type )
+    {
+        return false;
+    }
+
+    glTexImage2D(
+            GL_TEXTURE_2D,
+            0,
+            fi.intFmt,
+            img.mW,
+            img.mH,
+            0,
+            fi.fmt,
+            fi.type,
+            nullptr );
+
+    CHECKGLERR;
+
+    img.mImageTexW0    = img.mW;
+    img.mImageTexH0    = img.mH;
+    img.mImageTexFmt0  = (u_int)fi.intFmt;
+    img.mImageTexType0 = (u_int)fi.type;
+#endif
+    return true;
+}
+
+//==================================================================
+void TexStreamer::UploadImage( image &img, Format fmt )
+{
+    mLastUploadBytes = 0;
+
+    if NOT( canStream( img ) )
+    {
+        Graphics::UploadImageTexture( img );
+        mTexStates.erase( img.GetTextureID() );
+        return;
+    }
+
+    STAGE_TIMER( "tex_stream" );
+
+    fmt = resolveFormat( fmt );
+
+    c_auto didRealloc = setupStorage( img, fmt );
+
+    DVec<uint64_t> hashes;
+    tsHashTiles( hashes, img );
+
+    c_auto TD = TILE_DIM;
+    c_auto tilesW = (img.mW + TD - 1) / TD;
+    c_auto tilesH = (img.mH + TD - 1) / TD;
+
+    auto &st = mTexStates[ img.GetTextureID() ];
+
+    // bounding box of the tiles that changed
+    u_int tx1 = 0;
+    u_int ty1 = 0;
+    u_int tx2 = tilesW;
+    u_int ty2 = tilesH;
+
+    if ( !didRealloc && st.ts_w == img.mW && st.ts_h == img.mH )
+    {
+        tx1 = tilesW;
+        ty1 = tilesH;
+        tx2 = 0;
+        ty2 = 0;
+        for (u_int ty=0; ty < tilesH; ++ty)
+        {
+            for (u_int tx=0; tx < tilesW; ++tx)
+            {
+                c_auto idx = (size_t)ty * tilesW + tx;
+                if ( hashes[idx] == st.ts_tileHashes[idx] )
+                    continue;
+
+                tx1 = std::min( tx1, tx );
+                ty1 = std::min( ty1, ty );
+                tx2 = std::max( tx2, tx + 1 );
+                ty2 = std::max( ty2, ty + 1 );
+            }
+        }
+    }
+
+    st.ts_w = img.mW;
+    st.ts_h = img.mH;
+    st.ts_tileHashes = std::move( hashes );
+
+    if ( tx1 >= tx2 || ty1 >= ty2 )
+        return;
+
+    c_auto x1 = tx1 * TD;
+    c_auto y1 = ty1 * TD;
+    c_auto x2 = std::min( tx2 * TD, img.mW );
+    c_auto y2 = std::min( ty2 * TD, img.mH );
+
+    uploadRect( img, fmt, x1, y1, x2 - x1, y2 - y1 );
+}
+
+//==================================================================
+void TexStreamer::UploadImageRect(
+            image &img, Format fmt, u_int x, u_int y, u_int w, u_int h )
+{
+    mLastUploadBytes = 0;
+
+    if NOT( canStream( img ) )
+    {
+        Graphics::UploadImageTexture( img );
+        mTexStates.erase( img.GetTextureID() );
+        return;
+    }
+
+    fmt = resolveFormat( fmt );
+
+    // new storage is undefined, so it all goes up
+    if ( setupStorage( img, fmt ) )
+    {
+        x = 0;
+        y = 0;
+        w = img.mW;
+        h = img.mH;
+    }
+
+    // we don't know about the rest of the image anymore
+    mTexStates.erase( img.GetTextureID() );
+
+    DASSERT( x + w <= img.mW && y + h <= img.mH );
+
+    if ( w && h )
+        uploadRect( img, fmt, x, y, w, h );
+}
+
+//==================================================================
+void TexStreamer::uploadRect(
+            image &img, Format fmt, u_int x, u_int y, u_int w, u_int h )
+{
+#ifdef ENABLE_OPENGL
+    c_auto fi = tsGetFmtInfo( fmt, img.mChans );
+
+    c_auto desPitch = (size_t)w * fi.bpp;
+    c_auto sizeBytes = desPitch * h;
+
+    U8 *pDes {};
+    bool isMapped = false;
+
+    if ( tsHasPBO() )
+    {
+        if NOT( mPBOs[0] )
+            glGenBuffers( RING_N, mPBOs );
+
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, mPBOs[ mCurPBO ] );
+        mCurPBO = (mCurPBO + 1) % RING_N;
+
+        // orphan the old storage, so to not wait on a transfer in flight
+        glBufferData( GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)sizeBytes, nullptr, GL_STREAM_DRAW );
+
+        pDes = (U8 *)glMapBuffer( GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY );
+        CHECKGLERR;
+
+        if ( pDes )
+            isMapped = true;
+        else
+            glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    }
+
+    if NOT( pDes )
+    {
+        mStaging.resize( sizeBytes );
+        pDes = mStaging.data();
+    }
+
+    DT_ParallelFor( h, 16, [&]( size_t begin, size_t end )
+    {
+        for (size_t r=begin; r < end; ++r)
+        {
+            tsConvertRow(
+                pDes + r * desPitch,
+                fmt,
+                (const float *)img.GetPixelPtr( x, y + (u_int)r ),
+                w,
+                img.mChans );
+        }
+    });
+
+    const void *pData = pDes;
+    if ( isMapped )
+    {
+        // contents got lost (e.g. mode switch), next time send everything
+        if NOT( glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER ) )
+            mTexStates.erase( img.GetTextureID() );
+
+        // offset in the bound buffer
+        pData = nullptr;
+    }
+
+    glBindTexture( GL_TEXTURE_2D, img.GetTextureID() );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+    glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            (GLint)x,
+            (GLint)y,
+            (GLsizei)w,
+            (GLsizei)h,
+            fi.fmt,
+            fi.type,
+            pData );
+
+    CHECKGLERR;
+
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    if ( isMapped )
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    mLastUploadBytes = sizeBytes;
+    mTotUploadBytes += sizeBytes;
+#endif
+}
+
@@ -0,0 +1,79 @@
+//==================================================================
+/// TexStreamer.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef TEXSTREAMER_H
+#define TEXSTREAMER_H
+
+#include <unordered_map>
+#include "DBase.h"
+#include "DContainers.h"
+#include "Image.h"
+
+//==================================================================
+// Uploads float images to their texture through a ring of pixel buffer
+//  objects, converting to a lighter format on the way, and sending only
+//  the part of the image that changed since the previous upload.
+// Call from the thread of the GL context.
+//==================================================================
+class TexStreamer
+{
+public:
+    enum Format : u_int
+    {
+        FMT_FLOAT,      // texture storage as with Graphics::UploadImageTexture()
+        FMT_HALF,       // RGB(A) 16F
+        FMT_RGB10A2,    // RGB 10 bit, clamped to [0..1]
+    };
+
+    static constexpr u_int  RING_N = 3;
+    static constexpr u_int  TILE_DIM = 64;
+
+private:
+    struct TexState
+    {
+        u_int           ts_w {};
+        u_int           ts_h {};
+        DVec<uint64_t>  ts_tileHashes;
+    };
+    // what's currently in each texture, by texture ID
+    std::unordered_map<u_int,TexState>  mTexStates;
+
+    u_int       mPBOs[RING_N] {};
+    u_int       mCurPBO {};
+    DVec<U8>    mStaging;   // when PBOs are not available
+
+    size_t      mLastUploadBytes {};
+    size_t      mTotUploadBytes {};
+
+public:
+    TexStreamer();
+    ~TexStreamer();
+
+    // upload whatever changed since the last upload to the image's texture
+    void UploadImage( image &img, Format fmt );
+    // upload a given rectangle
+    void UploadImageRect( image &img, Format fmt, u_int x, u_int y, u_int w, u_int h );
+
+    // call before the texture is deleted
+    void ForgetTexture( u_int texID ) { mTexStates.erase( texID ); }
+
+    size_t GetLastUploadBytes() const { return mLastUploadBytes; }
+    size_t GetTotUploadBytes() const { return mTotUploadBytes; }
+
+    // "float", "half" or "rgb10a2"
+    static Format FormatFromName( const DStr &name );
+
+private:
+    bool canStream( const image &img ) const;
+    Format resolveFormat( Format fmt ) const;
+    bool setupStorage( image &img, Format fmt );
+    void uploadRect( image &img, Format fmt, u_int x, u_int y, u_int w, u_int h );
+};
+
+#endif
+
@@ -0,0 +1,102 @@
+//==================================================================
+/// TileTexCache.cpp
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#include <algorithm>
+#include "Graphics.h"
+#include "TileTexCache.h"
+
+//==================================================================
+TileTexCache::TileTexCache( size_t maxTilesN )
+    : mMaxTilesN(maxTilesN)
+{
+}
+
+//==================================================================
+TileTexCache::~TileTexCache()
+{
+    Clear();
+}
+
+//==================================================================
+void TileTexCache::freeEntry( Entry &e )
+{
+    if NOT( e.te_oView )
+        return;
+
+    mStreamer.ForgetTexture( e.te_oView->GetTextureID() );
+    Graphics::FreeImageTexture( *e.te_oView );
+}
+
+//==================================================================
+void TileTexCache::Clear()
+{
+    for (auto &[key, e] : mEntries)
+        freeEntry( e );
+
+    mEntries.clear();
+}
+
+//==================================================================
+u_int TileTexCache::GetTileTexID(
+            const image &srcImg,
+            uint64_t srcGen,
+            const ImageTiler::Tile &tile,
+            TexStreamer::Format fmt )
+{
+    auto &e = mEntries[ tile.GetKey() ];
+    e.te_lastUseFrame = mFrame;
+
+    if ( e.te_oView && e.te_srcGen == srcGen )
+        return e.te_oView->GetTextureID();
+
+    // a view on the source pixels, no copy
+    image::Params par;
+    par.FormatFromImage( srcImg );
+    par.width       = tile.tl_w;
+    par.height      = tile.tl_h;
+    par.rowPitch    = srcImg.mBytesPerRow;
+    par.pUseData    = (U8 *)srcImg.GetPixelPtr( tile.tl_x, tile.tl_y );
+
+    auto oView = std::make_unique<image>( par );
+
+    // keep the old texture, the streamer sends only what changed
+    if ( e.te_oView && e.te_oView->IsTextureIDValid() )
+        Graphics::TransferImageTexture( *oView, *e.te_oView );
+
+    e.te_oView  = std::move( oView );
+    e.te_srcGen = srcGen;
+
+    mStreamer.UploadImage( *e.te_oView, fmt );
+
+    return e.te_oView->GetTextureID();
+}
+
+//==================================================================
+void TileTexCache::EndFrame()
+{
+    if ( mEntries.size() > mMaxTilesN )
+    {
+        // oldest first, but never what was used in this frame
+        DVec<std::pair<u_int,uint64_t>> ages;
+        for (c_auto &[key, e] : mEntries)
+            if ( e.te_lastUseFrame != mFrame )
+                ages.push_back( { e.te_lastUseFrame, key } );
+
+        std::sort( ages.begin(), ages.end() );
+
+        for (size_t i=0; i < ages.size() && mEntries.size() > mMaxTilesN; ++i)
+        {
+            auto it = mEntries.find( ages[i].second );
+            freeEntry( it->second );
+            mEntries.erase( it );
+        }
+    }
+
+    ++mFrame;
+}
+
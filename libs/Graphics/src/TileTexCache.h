@@ -0,0 +1,60 @@
+//==================================================================
+/// TileTexCache.h
+///
+/// Created by Davide Pasca - 2026/10/19
+/// See the file "license.txt" that comes with this project for
+/// copyright info.
+//==================================================================
+
+#ifndef TILETEXCACHE_H
+#define TILETEXCACHE_H
+
+#include <unordered_map>
+#include "DBase.h"
+#include "Image.h"
+#include "ImageTiler.h"
+#include "TexStreamer.h"
+
+//==================================================================
+// One texture per tile of a source image, made on demand for the tiles
+//  that get displayed. Textures are updated when the source generation
+//  changes, and the least recently used ones go past the tiles budget.
+//==================================================================
+class TileTexCache
+{
+    struct Entry
+    {
+        uptr<image> te_oView;       // borrows the pixels of the source
+        uint64_t    te_srcGen {};
+        u_int       te_lastUseFrame {};
+    };
+    std::unordered_map<uint64_t,Entry>  mEntries;
+
+    TexStreamer     mStreamer;
+    size_t          mMaxTilesN {};
+    u_int           mFrame {};
+
+public:
+    TileTexCache( size_t maxTilesN=64 );
+    ~TileTexCache();
+
+    // texture of a tile of srcImg, uploaded if it's new or if srcGen changed
+    u_int GetTileTexID(
+            const image &srcImg,
+            uint64_t srcGen,
+            const ImageTiler::Tile &tile,
+            TexStreamer::Format fmt );
+
+    // evict what's over budget. Call once per frame
+    void EndFrame();
+
+    void Clear();
+
+    size_t GetTilesN() const { return mEntries.size(); }
+
+private:
+    void freeEntry( Entry &e );
+};
+
+#endif
+